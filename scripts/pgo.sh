@@ -0,0 +1,45 @@
+#!/bin/bash
+# Build a profile-guided optimised CacheMiss
+#
+# 1. Build an instrumented engine (-DCACHEMISS_PGO=GENERATE)
+# 2. Train it: fixed-depth search bench, perft, and a short WAC sample
+# 3. Rebuild with the collected profile (-DCACHEMISS_PGO=USE)
+#
+# Works with GCC and Clang (Clang needs llvm-profdata; override with LLVM_PROFDATA).
+# Set CACHEMISS_ARCH=portable for a binary that runs on other x86-64 hosts.
+#
+# Usage: ./scripts/pgo.sh [build_dir] [build_type]
+# Example: ./scripts/pgo.sh build-pgo Release
+#          -> build-pgo/cachemiss
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+BUILD_DIR="$(realpath -m "${1:-$PROJECT_DIR/build-pgo}")"
+BUILD_TYPE="${2:-Release}"
+PGO_DIR="$BUILD_DIR/pgo-data"
+ENGINE="$BUILD_DIR/cachemiss"
+
+echo "PGO: instrumented build ($BUILD_TYPE)"
+rm -rf "$PGO_DIR"
+cmake -S "$PROJECT_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE="$BUILD_TYPE" \
+    -DCACHEMISS_ARCH="${CACHEMISS_ARCH:-native}" \
+    -DCACHEMISS_PGO=GENERATE -DCACHEMISS_PGO_DIR="$PGO_DIR" > /dev/null
+cmake --build "$BUILD_DIR" --target cachemiss --clean-first
+
+echo "PGO: training"
+"$ENGINE" --bench > /dev/null
+"$ENGINE" --fen "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" --perft 4 --mem 16 > /dev/null
+"$ENGINE" --bench-wac "$PROJECT_DIR/wac.epd" 30 --mem 64 > /dev/null
+
+# Clang writes raw profiles that have to be merged before use
+if compgen -G "$PGO_DIR/*.profraw" > /dev/null; then
+    "${LLVM_PROFDATA:-llvm-profdata}" merge -output="$PGO_DIR/cachemiss.profdata" "$PGO_DIR"/*.profraw
+fi
+
+echo "PGO: optimised build"
+cmake -S "$PROJECT_DIR" -B "$BUILD_DIR" -DCACHEMISS_PGO=USE > /dev/null
+cmake --build "$BUILD_DIR" --target cachemiss --clean-first
+
+echo "Built: $ENGINE"
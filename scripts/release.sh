@@ -1,14 +1,23 @@
 #!/bin/bash
 # Build a release version of CacheMiss
+# Release binaries are portable (x86-64 baseline with runtime CPU dispatch)
 #
-# Usage: ./scripts/release.sh <suffix>
+# Usage: ./scripts/release.sh [--pgo] <suffix>
 # Example: ./scripts/release.sh v1.0
 #          -> builds/cachemiss.v1.0
+#          ./scripts/release.sh --pgo v1.0
+#          -> profile-guided build (see scripts/pgo.sh)
 
 set -e
 
+PGO=0
+if [ "$1" = "--pgo" ]; then
+    PGO=1
+    shift
+fi
+
 if [ -z "$1" ]; then
-    echo "Usage: $0 <suffix>"
+    echo "Usage: $0 [--pgo] <suffix>"
     echo "Example: $0 v1.0"
     exit 1
 fi
@@ -23,11 +32,17 @@ OUTPUT_PATH="$OUTPUT_DIR/$OUTPUT_NAME"
 
 echo "Building release: $OUTPUT_NAME"
 
-# Configure release build
-cmake -S "$PROJECT_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release > /dev/null
+if [ "$PGO" = 1 ]; then
+    BUILD_DIR="$PROJECT_DIR/build-release-pgo"
+    CACHEMISS_ARCH=portable "$SCRIPT_DIR/pgo.sh" "$BUILD_DIR" Release
+else
+    # Configure release build
+    cmake -S "$PROJECT_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DCACHEMISS_PGO=OFF \
+        -DCACHEMISS_ARCH=portable > /dev/null
 
-# Build
-cmake --build "$BUILD_DIR" --target cachemiss
+    # Build
+    cmake --build "$BUILD_DIR" --target cachemiss
+fi
 
 # Create output directory
 mkdir -p "$OUTPUT_DIR"
@@ -0,0 +1,271 @@
+#include "analyze.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "pawn_cache.hpp"
+#include "search.hpp"
+#include "ttable.hpp"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+size_t analyze_worker_hash_mb(const AnalyzeOptions& options) {
+    int threads = std::max(1, options.threads);
+    if (options.hash_mb > 0) {
+        return std::max<size_t>(1, options.hash_mb / static_cast<size_t>(threads));
+    }
+    // About two slots per node visited; a bigger table only costs clearing
+    // time, since every position starts from an empty one
+    constexpr u64 NODES_PER_MS = 1000;  // Conservative single-thread speed
+    constexpr size_t DEFAULT_MB = 16;
+    constexpr size_t MAX_MB = 256;
+    u64 nodes = options.nodes * static_cast<u64>(std::max(1, options.multipv));
+    if (nodes == 0 && options.movetime_ms > 0) nodes = static_cast<u64>(options.movetime_ms) * NODES_PER_MS;
+    if (nodes == 0) return DEFAULT_MB;
+    u64 mb = (nodes * 2 * sizeof(TTEntry) + (1 << 20) - 1) >> 20;
+    return std::clamp<size_t>(std::bit_ceil(mb), 1, MAX_MB);
+}
+
+namespace {
+
+struct Position {
+    std::string fen;
+    Board board;
+    std::string id;  // EPD "id" operation, if any
+};
+
+// A line is a FEN, or an EPD record (four FEN fields and operations), of a
+// position with one king per side
+bool parse_line(const std::string& line, Position& position) {
+    std::istringstream iss(line);
+    std::vector<std::string> fields;
+    std::string token;
+    while (fields.size() < 6 && iss >> token) fields.push_back(token);
+    if (fields.size() < 4) return false;
+
+    auto is_number = [](const std::string& s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+    };
+    position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+    if (fields.size() == 6 && is_number(fields[4]) && is_number(fields[5])) {
+        position.fen += " " + fields[4] + " " + fields[5];
+    } else {
+        position.fen += " 0 1";
+    }
+    if (!parse_fen(position.fen, position.board)) return false;
+
+    size_t id = line.find("id \"");
+    if (id != std::string::npos) {
+        size_t end = line.find('"', id + 4);
+        if (end != std::string::npos) position.id = line.substr(id + 4, end - id - 4);
+    }
+    return true;
+}
+
+void append_json_string(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+int count_legal_moves(const Board& board) {
+    Board scratch = board;
+    MoveList moves = generate_moves<MoveType::All>(scratch);
+    int legal = 0;
+    for (int i = 0; i < moves.size; ++i) {
+        UndoInfo undo = make_move(scratch, moves[i]);
+        if (!is_illegal(scratch)) ++legal;
+        unmake_move(scratch, moves[i], undo);
+    }
+    return legal;
+}
+
+// Searcher state owned by one worker thread
+struct Worker {
+    TTable tt;
+    PawnCache pawn_cache;
+    SearchController controller;
+};
+
+// Analyse one line; returns its JSON (without newline)
+std::string analyze_line(Worker& worker, const AnalyzeOptions& options, size_t line_number,
+                         const std::string& line) {
+    std::string json = "{\"line\":" + std::to_string(line_number);
+    Position position;
+    if (!parse_line(line, position)) {
+        json += ",\"error\":\"not a FEN or EPD record\"}";
+        return json;
+    }
+    if (!position.id.empty()) {
+        json += ",\"id\":";
+        append_json_string(json, position.id);
+    }
+    json += ",\"fen\":";
+    append_json_string(json, position.fen);
+
+    Board& board = position.board;
+    int lines = std::min(std::max(1, options.multipv), count_legal_moves(board));
+
+    // Each position starts from an empty table, so results don't depend on
+    // which worker got which positions before
+    worker.tt.clear();
+    worker.controller.reset();
+
+    bool no_limit = options.depth == 0 && options.nodes == 0 && options.movetime_ms == 0;
+    SearchLimits limits;
+    limits.time_ms = options.movetime_ms > 0 ? std::max(1, options.movetime_ms / std::max(1, lines)) : 999999999;
+    limits.depth = no_limit ? ANALYZE_DEFAULT_DEPTH : options.depth;
+    limits.nodes = options.nodes;
+    limits.silent = true;
+    limits.controller = &worker.controller;
+
+    // MultiPV: line k searches the root without the best moves of lines 1..k-1
+    std::vector<Move32> excluded;
+    std::vector<SearchResult> results;
+    u64 nodes = 0;
+    int time_ms = 0;
+    for (int k = 0; k < lines; ++k) {
+        limits.exclude = excluded.data();
+        limits.exclude_count = static_cast<int>(excluded.size());
+        worker.tt.new_search();
+        Board search_board = board;
+        SearchResult result = search(search_board, worker.tt, limits);
+        nodes += result.nodes;
+        time_ms += result.elapsed_ms;
+        if (result.best_move.data == 0) break;
+        excluded.push_back(result.best_move);
+        results.push_back(result);
+    }
+
+    json += ",\"nodes\":" + std::to_string(nodes) + ",\"time_ms\":" + std::to_string(time_ms);
+    json += ",\"bestmove\":";
+    if (results.empty()) {
+        json += "null";  // Checkmate or stalemate
+    } else {
+        append_json_string(json, results[0].best_move.to_uci());
+    }
+    json += ",\"lines\":[";
+    for (size_t k = 0; k < results.size(); ++k) {
+        const SearchResult& r = results[k];
+        if (k > 0) json += ',';
+        json += "{\"move\":\"" + r.best_move.to_uci() + "\"";
+        if (is_mate_score(r.score)) {
+            json += ",\"mate\":" + std::to_string(mate_in_moves(r.score));
+        } else {
+            json += ",\"cp\":" + std::to_string(r.score);
+        }
+        json += ",\"depth\":" + std::to_string(r.depth) + ",\"pv\":\"";
+        for (int i = 0; i < r.pv_length; ++i) {
+            if (i > 0) json += ' ';
+            json += r.pv[i].to_uci();
+        }
+        json += "\"}";
+    }
+    json += "]}";
+    return json;
+}
+
+}  // namespace
+
+size_t analyze_positions(std::istream& in, std::ostream& out, const AnalyzeOptions& options) {
+    int threads = std::max(1, options.threads);
+    size_t hash_mb = analyze_worker_hash_mb(options);
+    // Positions read ahead of the oldest unfinished one; bounds memory on huge inputs
+    const size_t window = static_cast<size_t>(threads) * 8;
+
+    struct Job {
+        size_t index;
+        size_t line_number;
+        std::string text;
+    };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::map<size_t, std::string> finished;  // Results waiting for an earlier one
+    size_t next_output = 0;
+    bool input_done = false;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            Worker worker;
+            worker.tt.resize(hash_mb);
+            t_pawn_cache = &worker.pawn_cache;
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return !jobs.empty() || input_done; });
+                    if (jobs.empty()) return;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                std::string json = analyze_line(worker, options, job.line_number, job.text);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                finished[job.index] = std::move(json);
+                bool wrote = false;
+                for (auto it = finished.begin(); it != finished.end() && it->first == next_output;) {
+                    out << it->second << '\n';
+                    it = finished.erase(it);
+                    ++next_output;
+                    wrote = true;
+                }
+                if (wrote) {
+                    out.flush();
+                    cv.notify_all();  // The reader may be waiting for the window to move
+                }
+            }
+        });
+    }
+
+    std::string line;
+    size_t count = 0;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#') continue;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return count - next_output < window; });
+        jobs.push_back({count++, line_number, std::move(line)});
+        lock.unlock();
+        cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        input_done = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+    return count;
+}
+
+bool analyze_file(const std::string& filename, const AnalyzeOptions& options) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Cannot open " << filename << '\n';
+        return false;
+    }
+    std::cerr << "Analysing " << filename << " with " << std::max(1, options.threads) << " threads, "
+              << analyze_worker_hash_mb(options) << " MB hash each" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t count = analyze_positions(file, std::cout, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Analysed " << count << " positions in " << seconds << " s" << std::endl;
+    return true;
+}
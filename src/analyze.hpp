@@ -0,0 +1,37 @@
+#pragma once
+
+#include "cachemiss.hpp"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+// ============================================================================
+// Batch analysis (--analyze)
+// ============================================================================
+// Analyses every position of a FEN/EPD file (one per line) with a fixed limit
+// and writes one JSON line per position, in input order. Lines are streamed:
+// a pool of workers, each with its own hash table, pawn cache and search
+// controller, takes positions as they are read, and results are printed as
+// soon as every earlier position is done.
+
+struct AnalyzeOptions {
+    int threads = 1;
+    int depth = 0;         // Per line; 0 = unlimited
+    u64 nodes = 0;         // Per line; 0 = unlimited
+    int movetime_ms = 0;   // Per position, split between the MultiPV lines
+    int multipv = 1;       // Best moves reported per position
+    size_t hash_mb = 0;    // Total over the workers; 0 = sized from the limits
+};
+
+// Default when no limit is given
+constexpr int ANALYZE_DEFAULT_DEPTH = 10;
+
+// Hash table size (MB) for one worker
+size_t analyze_worker_hash_mb(const AnalyzeOptions& options);
+
+// Analyse the positions read from `in`, writing JSONL to `out`.
+// Returns the number of positions analysed.
+size_t analyze_positions(std::istream& in, std::ostream& out, const AnalyzeOptions& options);
+
+// Analyse a file; returns false if it can't be opened
+bool analyze_file(const std::string& filename, const AnalyzeOptions& options);
@@ -1,6 +1,8 @@
 #include "bench.hpp"
 #include "board.hpp"
+#include "cpu.hpp"
 #include "epd.hpp"
+#include "eval.hpp"
 #include "move.hpp"
 #include "perft.hpp"
 #include "search.hpp"
@@ -8,6 +10,7 @@
 #include <iomanip>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 
 // Strip check/checkmate indicators from SAN
 static std::string strip_check_indicators(const std::string& san) {
@@ -101,6 +104,53 @@ void bench_perftsuite(const std::string& filename, int max_depth, size_t mem_mb)
               << " (" << std::fixed << std::setprecision(1) << hit_rate << "% hit rate)\n";
 }
 
+// Fixed positions for the deterministic search bench: openings, middlegames
+// with tactics, and endgames, so every part of the search and eval gets work
+static const char* BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5",
+    "r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2Q1RK1 w - - 0 10",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "2r2rk1/1bqnbpp1/1p1ppn1p/pP6/N1P1P3/P2B1N1P/1B2QPP1/R2R2K1 b - - 0 20",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "3r4/2p1p3/8/1P1P1P2/3K4/5k2/8/8 b - - 0 1",
+    "8/8/1p1k4/5ppp/PPK1p3/6P1/5PP1/8 b - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/8/5k2/8/8/3QK3/8 w - - 0 1",
+};
+
+void bench_search(int depth, size_t mem_mb) {
+    TTable tt(mem_mb);
+    u64 total_nodes = 0;
+
+    auto suite_start = std::chrono::steady_clock::now();
+
+    for (const char* fen : BENCH_FENS) {
+        Board board(fen);
+        // Start every position from empty tables so the node count is reproducible
+        tt.clear();
+        g_pawn_cache.clear();
+        SearchResult result = search(board, tt, 999999999, depth);
+        total_nodes += result.nodes;
+    }
+
+    auto suite_end = std::chrono::steady_clock::now();
+    auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(suite_end - suite_start).count();
+    u64 nps = total_ms > 0 ? total_nodes * 1000 / static_cast<u64>(total_ms) : 0;
+
+    std::cout << "\n=== Bench ===\n";
+    std::cout << "Positions: " << std::size(BENCH_FENS) << ", depth " << depth << '\n';
+    std::cout << "CPU dispatch: " << cpu_dispatch_level() << '\n';
+    std::cout << "Nodes: " << total_nodes << '\n';
+    std::cout << "Time: " << total_ms << " ms\n";
+    std::cout << "NPS: " << nps << '\n';
+}
+
 void bench_wac(const std::string& filename, int time_limit_ms, size_t mem_mb, const std::string& filter_id) {
     auto entries = parse_wac_file(filename);
 
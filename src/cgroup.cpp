@@ -0,0 +1,187 @@
+#include "cgroup.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+int CgroupLimits::cpus() const {
+    if (cpu_quota_us == 0 || cpu_period_us == 0) return 0;
+    return static_cast<int>((cpu_quota_us + cpu_period_us - 1) / cpu_period_us);
+}
+
+namespace {
+
+// First two whitespace-separated fields of a file
+bool read_fields(const std::string& path, std::string& first, std::string& second) {
+    std::ifstream file(path);
+    if (!file) return false;
+    first.clear();
+    second.clear();
+    file >> first >> second;
+    return !first.empty();
+}
+
+bool parse_u64(const std::string& text, u64& value) {
+    if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    value = std::stoull(text);
+    return true;
+}
+
+// The cgroup's directory and its ancestors up to the hierarchy root, where
+// they exist (a container usually sees only part of the host's path)
+std::vector<std::string> cgroup_dirs(const std::string& root, std::string path) {
+    std::vector<std::string> dirs;
+    while (true) {
+        std::string dir = path == "/" ? root : root + path;
+        std::error_code ec;
+        if (std::filesystem::is_directory(dir, ec)) dirs.push_back(dir);
+        size_t slash = path.rfind('/');
+        if (path == "/" || slash == std::string::npos) break;
+        path = slash == 0 ? "/" : path.substr(0, slash);
+    }
+    return dirs;
+}
+
+void take_memory_limit(CgroupLimits& limits, u64 bytes) {
+    if (limits.memory_bytes == 0 || bytes < limits.memory_bytes) limits.memory_bytes = bytes;
+}
+
+// Keep the quota that allows the least CPU time per wall time
+void take_cpu_quota(CgroupLimits& limits, u64 quota_us, u64 period_us, const std::string& dir) {
+    if (quota_us == 0 || period_us == 0) return;
+    if (limits.cpu_quota_us == 0 || quota_us * limits.cpu_period_us < limits.cpu_quota_us * period_us) {
+        limits.cpu_quota_us = quota_us;
+        limits.cpu_period_us = period_us;
+        limits.cpu_stat_path = dir + "/cpu.stat";
+    }
+}
+
+void read_v2(CgroupLimits& limits, const std::string& root, const std::string& path) {
+    std::string first, second;
+    u64 value = 0, period = 0;
+    for (const auto& dir : cgroup_dirs(root, path)) {
+        if (read_fields(dir + "/memory.max", first, second) && parse_u64(first, value)) {
+            take_memory_limit(limits, value);
+        }
+        // "max 100000" or "<quota> <period>"
+        if (read_fields(dir + "/cpu.max", first, second) && parse_u64(first, value) && parse_u64(second, period)) {
+            take_cpu_quota(limits, value, period, dir);
+        }
+    }
+}
+
+void read_v1_memory(CgroupLimits& limits, const std::string& root, const std::string& path) {
+    // "Unlimited" is the largest page-aligned 64-bit value
+    constexpr u64 NO_LIMIT = u64(1) << 60;
+    std::string first, second;
+    u64 value = 0;
+    for (const auto& dir : cgroup_dirs(root, path)) {
+        if (read_fields(dir + "/memory.limit_in_bytes", first, second) && parse_u64(first, value) &&
+            value < NO_LIMIT) {
+            take_memory_limit(limits, value);
+        }
+    }
+}
+
+void read_v1_cpu(CgroupLimits& limits, const std::string& root, const std::string& path) {
+    std::string first, second;
+    u64 quota = 0, period = 0;
+    for (const auto& dir : cgroup_dirs(root, path)) {
+        // A quota of -1 means none
+        if (read_fields(dir + "/cpu.cfs_quota_us", first, second) && parse_u64(first, quota) &&
+            read_fields(dir + "/cpu.cfs_period_us", first, second) && parse_u64(first, period)) {
+            take_cpu_quota(limits, quota, period, dir);
+        }
+    }
+}
+
+}  // namespace
+
+CgroupLimits read_cgroup_limits(const std::string& proc_cgroup_file, const std::string& mount_dir) {
+    CgroupLimits limits;
+    std::ifstream file(proc_cgroup_file);
+    std::string line;
+    std::error_code ec;
+    bool unified = std::filesystem::exists(mount_dir + "/cgroup.controllers", ec);
+
+    // Lines are "<id>:<controllers>:<path>"; cgroup v2 is "0::<path>"
+    while (std::getline(file, line)) {
+        size_t colon1 = line.find(':');
+        size_t colon2 = colon1 == std::string::npos ? colon1 : line.find(':', colon1 + 1);
+        if (colon2 == std::string::npos) continue;
+        std::string controllers = line.substr(colon1 + 1, colon2 - colon1 - 1);
+        std::string path = line.substr(colon2 + 1);
+        if (path.empty() || path[0] != '/') continue;
+
+        if (controllers.empty()) {
+            if (!unified) continue;  // Hybrid setup: the v2 hierarchy has no controllers we use
+            limits.version = 2;
+            read_v2(limits, mount_dir, path);
+            continue;
+        }
+        if (unified) continue;
+
+        std::vector<std::string> names;
+        std::istringstream iss(controllers);
+        for (std::string name; std::getline(iss, name, ',');) names.push_back(name);
+        auto has = [&names](const char* name) { return std::find(names.begin(), names.end(), name) != names.end(); };
+        if (has("memory")) {
+            limits.version = 1;
+            read_v1_memory(limits, mount_dir + "/memory", path);
+        }
+        if (has("cpu")) {
+            // Mounted as "cpu,cpuacct" (often symlinked to "cpu") or on its own
+            limits.version = 1;
+            std::string root = mount_dir + "/" + controllers;
+            if (!std::filesystem::is_directory(root, ec)) root = mount_dir + "/cpu";
+            read_v1_cpu(limits, root, path);
+        }
+    }
+    return limits;
+}
+
+const CgroupLimits& cgroup_limits() {
+    static const CgroupLimits limits = read_cgroup_limits("/proc/self/cgroup", "/sys/fs/cgroup");
+    return limits;
+}
+
+size_t max_hash_mb(const CgroupLimits& limits) {
+    if (limits.memory_bytes == 0) return 0;
+    return std::max<size_t>(1, (limits.memory_bytes >> 20) * HASH_MEMORY_PERCENT / 100);
+}
+
+int available_cpus() {
+    int cpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int quota = cgroup_limits().cpus();
+    return quota > 0 ? std::min(cpus, quota) : cpus;
+}
+
+u64 read_throttled_us(const std::string& cpu_stat_path) {
+    std::ifstream file(cpu_stat_path);
+    std::string key;
+    u64 value = 0;
+    while (file >> key >> value) {
+        if (key == "throttled_usec") return value;          // v2
+        if (key == "throttled_time") return value / 1000;   // v1, nanoseconds
+    }
+    return 0;
+}
+
+ThrottleMonitor::ThrottleMonitor(const CgroupLimits& limits) {
+    if (limits.cpu_quota_us == 0) return;
+    stat_path = limits.cpu_stat_path;
+    period_ms = static_cast<int>((limits.cpu_period_us + 999) / 1000);
+    throttled_us = read_throttled_us(stat_path);
+}
+
+int ThrottleMonitor::margin_ms() {
+    if (stat_path.empty()) return 0;
+    u64 now = read_throttled_us(stat_path);
+    last_delta_us = now > throttled_us ? now - throttled_us : 0;
+    throttled_us = now;
+    return last_delta_us > 0 ? period_ms : 0;
+}
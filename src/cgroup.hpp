@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cachemiss.hpp"
+#include <cstddef>
+#include <string>
+
+// ============================================================================
+// Container limits (cgroup v1/v2)
+// ============================================================================
+// Inside a container the engine may get far less memory and CPU than the
+// machine has. Memory beyond the cgroup limit gets the process OOM-killed,
+// so Hash is clamped to a fraction of it. A CPU quota (cpu.max) lets the
+// cgroup run for `quota` microseconds per `period`; once used up, every
+// thread stalls until the period ends, which the time manager must allow
+// for when it happens near a deadline.
+
+struct CgroupLimits {
+    int version = 0;            // 1 or 2; 0 = no readable cgroup
+    u64 memory_bytes = 0;       // Lowest memory limit on the path; 0 = none
+    u64 cpu_quota_us = 0;       // CPU time per period of the tightest quota; 0 = none
+    u64 cpu_period_us = 0;
+    std::string cpu_stat_path;  // cpu.stat of the cgroup with that quota (throttling counters)
+
+    // CPUs the quota is worth, rounded up; 0 = no quota
+    int cpus() const;
+};
+
+// Limits of this process, read on first use from /proc/self/cgroup and the
+// hierarchy mounted at /sys/fs/cgroup
+const CgroupLimits& cgroup_limits();
+
+// Same against another process table and mount point (for tests)
+CgroupLimits read_cgroup_limits(const std::string& proc_cgroup_file, const std::string& mount_dir);
+
+// Share of the memory limit the hash table may take. Half leaves room for
+// the rest of the process and for resizing, which briefly holds both tables.
+constexpr int HASH_MEMORY_PERCENT = 50;
+
+// Largest Hash in MB under a memory limit (at least 1); 0 = no limit
+size_t max_hash_mb(const CgroupLimits& limits);
+
+// CPUs available to the process: hardware threads, capped by a CPU quota
+int available_cpus();
+
+// Total time (microseconds) the cgroup has been throttled so far; 0 if unknown
+u64 read_throttled_us(const std::string& cpu_stat_path);
+
+// Watches the throttling counter between moves. If the cgroup was throttled
+// since the previous move, the next one keeps a full CFS period in reserve.
+class ThrottleMonitor {
+public:
+    explicit ThrottleMonitor(const CgroupLimits& limits);
+
+    // Margin (ms) to add to the move overhead for the coming move
+    int margin_ms();
+
+    // Throttled time seen by the last margin_ms() call
+    u64 last_throttled_us() const { return last_delta_us; }
+
+private:
+    std::string stat_path;
+    int period_ms = 0;
+    u64 throttled_us = 0;
+    u64 last_delta_us = 0;
+};
@@ -0,0 +1,26 @@
+#include "cpu.hpp"
+
+const char* cpu_dispatch_level() {
+#if CACHEMISS_DISPATCH_ENABLED
+    __builtin_cpu_init();
+#if !defined(__clang__) && __GNUC__ >= 12
+    // The same level checks GCC's target_clones resolver makes, so this is
+    // the clone that actually runs
+    if (__builtin_cpu_supports("x86-64-v3")) return "x86-64-v3 (BMI2, AVX2)";
+    if (__builtin_cpu_supports("x86-64-v2")) return "x86-64-v2 (POPCNT)";
+    return "x86-64 (generic)";
+#else
+    // Compilers without level names here: infer the level from its key
+    // features, which may disagree with the loader's choice on odd CPUs
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) {
+        return "x86-64-v3 (BMI2, AVX2; inferred)";
+    }
+    if (__builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2")) {
+        return "x86-64-v2 (POPCNT; inferred)";
+    }
+    return "x86-64 (generic; inferred)";
+#endif
+#else
+    return "native";
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// ============================================================================
+// Runtime CPU dispatch
+// ============================================================================
+// Portable builds (-DCACHEMISS_ARCH=portable) target baseline x86-64 and
+// compile the hot kernels several times via target_clones; the dynamic
+// loader picks the best clone for the host CPU at startup. Native builds
+// (the default) are compiled for the build machine and need no dispatch.
+//
+// Levels: x86-64 (generic), x86-64-v2 (POPCNT, SSE4.2), x86-64-v3 (BMI1/2,
+// LZCNT, AVX2). Inlined helpers (popcount, attack lookups) are compiled
+// inside each clone, so they pick up the wider instruction set too.
+
+#if defined(CACHEMISS_MULTIARCH) && defined(__x86_64__) && defined(__GNUC__)
+#define CACHEMISS_DISPATCH_ENABLED 1
+#define CACHEMISS_TARGET_CLONES \
+    __attribute__((target_clones("default", "arch=x86-64-v2", "arch=x86-64-v3")))
+#else
+#define CACHEMISS_DISPATCH_ENABLED 0
+#define CACHEMISS_TARGET_CLONES
+#endif
+
+// Clang does not accept target_clones on function templates
+#if CACHEMISS_DISPATCH_ENABLED && !defined(__clang__)
+#define CACHEMISS_TARGET_CLONES_TEMPLATE CACHEMISS_TARGET_CLONES
+#else
+#define CACHEMISS_TARGET_CLONES_TEMPLATE
+#endif
+
+// Instruction-set level the dispatched kernels run at on this machine,
+// e.g. "x86-64-v3 (BMI2, AVX2)", or "native" for a -march=native build
+const char* cpu_dispatch_level();
@@ -0,0 +1,397 @@
+#include "engine_server.hpp"
+#include "cgroup.hpp"
+#include "uci.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <tuple>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ============================================================================
+// HashPool
+// ============================================================================
+
+size_t HashPool::acquire(int session, size_t requested_mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    granted_.erase(session);
+    size_t share = total_mb_ / (granted_.size() + 1);
+    size_t grant = std::max<size_t>(1, std::min(requested_mb, share));
+    granted_[session] = grant;
+
+    // Waiting for the others' next bestmove would leave a joining game with
+    // almost nothing for its first moves: they shrink when next idle instead
+    for (const auto& [id, mb] : granted_) {
+        auto it = rebalance_.find(id);
+        if (mb > share && it != rebalance_.end()) it->second();
+    }
+    return grant;
+}
+
+void HashPool::on_rebalance(int session, std::function<void()> rebalance) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rebalance_[session] = std::move(rebalance);
+}
+
+void HashPool::release(int session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    granted_.erase(session);
+    rebalance_.erase(session);
+}
+
+size_t HashPool::allocated_mb() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const auto& [id, mb] : granted_) total += mb;
+    return total;
+}
+
+// ============================================================================
+// SearchScheduler
+// ============================================================================
+
+const SearchScheduler::Entry* SearchScheduler::next_waiting() const {
+    const Entry* best = nullptr;
+    for (const Entry& entry : waiting_) {
+        if (!best || std::tie(entry.ponder, entry.urgency_ms, entry.ticket) <
+                     std::tie(best->ponder, best->urgency_ms, best->ticket)) {
+            best = &entry;
+        }
+    }
+    return best;
+}
+
+u64 SearchScheduler::enqueue(int urgency_ms, bool ponder, std::function<void()> preempt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    u64 ticket = next_ticket_++;
+    waiting_.push_back({ticket, urgency_ms, ponder, std::move(preempt)});
+    return ticket;
+}
+
+bool SearchScheduler::wait(u64 ticket, const std::function<bool()>& cancelled) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto find = [&] {
+        return std::find_if(waiting_.begin(), waiting_.end(), [&](const Entry& e) { return e.ticket == ticket; });
+    };
+    while (true) {
+        auto it = find();
+        if (it == waiting_.end()) return false;
+        if (it->cancelled || (cancelled && cancelled())) {
+            waiting_.erase(it);
+            lock.unlock();
+            cv_.notify_all();  // A waiter behind this one may be next now
+            return false;
+        }
+        if (static_cast<int>(running_.size()) < slots_ && next_waiting()->ticket == ticket) break;
+
+        if (!it->ponder && static_cast<int>(running_.size()) >= slots_) {
+            // A move is waiting on the clock: take the slot of a ponder search
+            for (Entry& entry : running_) {
+                if (entry.ponder && entry.preempt) {
+                    auto stop = std::move(entry.preempt);
+                    entry.preempt = nullptr;
+                    stop();
+                    break;
+                }
+            }
+        }
+        cv_.wait(lock);
+    }
+
+    auto it = find();
+    running_.push_back(std::move(*it));
+    waiting_.erase(it);
+    lock.unlock();
+    cv_.notify_all();  // The next waiter may fit in another free slot
+    return true;
+}
+
+void SearchScheduler::cancel(u64 ticket) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Entry& entry : waiting_) {
+            if (entry.ticket == ticket) entry.cancelled = true;
+        }
+    }
+    cv_.notify_all();
+}
+
+u64 SearchScheduler::acquire(int urgency_ms, bool ponder, std::function<void()> preempt) {
+    u64 ticket = enqueue(urgency_ms, ponder, std::move(preempt));
+    wait(ticket);
+    return ticket;
+}
+
+void SearchScheduler::release(u64 ticket) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::erase_if(running_, [&](const Entry& e) { return e.ticket == ticket; });
+    }
+    cv_.notify_all();
+}
+
+int SearchScheduler::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(running_.size());
+}
+
+int SearchScheduler::waiting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(waiting_.size());
+}
+
+// ============================================================================
+// Socket streams
+// ============================================================================
+// Reads are buffered. The UCI thread (readyok, bestmove) and the search
+// thread (info) each write through a stream of their own, which sends only
+// whole lines, under a mutex shared by the session's streams: lines from the
+// two threads never interleave, and no stream is used by two threads.
+
+namespace {
+
+class SocketReadBuf : public std::streambuf {
+public:
+    explicit SocketReadBuf(int fd) : fd_(fd) { setg(in_, in_, in_); }
+
+protected:
+    int_type underflow() override {
+        ssize_t n;
+        do {
+            n = ::read(fd_, in_, sizeof(in_));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return traits_type::eof();
+        setg(in_, in_, in_ + n);
+        return traits_type::to_int_type(in_[0]);
+    }
+
+private:
+    int fd_;
+    char in_[4096];
+};
+
+class SocketLineBuf : public std::streambuf {
+public:
+    SocketLineBuf(int fd, std::mutex& write_mutex) : fd_(fd), write_mutex_(write_mutex) {}
+    ~SocketLineBuf() override {
+        if (!line_.empty()) send_all(line_.data(), line_.size());  // An unterminated last line
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        line_.append(s, static_cast<size_t>(n));
+        return send_lines() ? n : 0;
+    }
+
+    int sync() override { return send_lines() ? 0 : -1; }
+
+private:
+    // Send the complete lines collected so far; a partial one waits for its newline
+    bool send_lines() {
+        size_t end = line_.rfind('\n');
+        if (end == std::string::npos) return true;
+        bool sent = send_all(line_.data(), end + 1);
+        line_.erase(0, end + 1);
+        return sent;
+    }
+
+    bool send_all(const char* data, size_t size) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        while (size > 0) {
+            ssize_t n = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;  // The client is gone; the session ends at end of input
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int fd_;
+    std::mutex& write_mutex_;
+    std::string line_;
+};
+
+std::atomic<bool> g_server_stop{false};
+
+void on_server_signal(int) {
+    g_server_stop.store(true);
+}
+
+bool make_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << '\n';
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+struct Session {
+    int fd;
+    std::thread thread;
+    std::atomic<bool> done{false};
+};
+
+}  // namespace
+
+// ============================================================================
+// Server
+// ============================================================================
+
+int run_engine_server(const std::string& socket_path, size_t hash_mb, int threads) {
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr)) return 1;
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "socket: " << std::strerror(errno) << '\n';
+        return 1;
+    }
+    ::unlink(socket_path.c_str());  // Left over from a previous server
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, 16) < 0) {
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << '\n';
+        ::close(listen_fd);
+        return 1;
+    }
+
+    if (threads <= 0) threads = available_cpus();
+    size_t limit_mb = max_hash_mb(cgroup_limits());
+    if (limit_mb > 0 && hash_mb > limit_mb) {
+        std::cerr << "info string hash " << hash_mb << " MB is over " << HASH_MEMORY_PERCENT
+                  << "% of the container memory limit (" << (cgroup_limits().memory_bytes >> 20)
+                  << " MB), using " << limit_mb << " MB" << std::endl;
+        hash_mb = limit_mb;
+    }
+    HashPool pool(hash_mb);
+    SearchScheduler scheduler(threads);
+    std::cerr << "info string engine server on " << socket_path << ": hash " << hash_mb << " MB, "
+              << threads << " search slots" << std::endl;
+
+    std::signal(SIGINT, on_server_signal);
+    std::signal(SIGTERM, on_server_signal);
+
+    std::list<Session> sessions;
+    int next_id = 1;
+    while (!g_server_stop.load()) {
+        pollfd pfd{listen_fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200);
+
+        // Reap finished sessions
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if (it->done.load()) {
+                it->thread.join();
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (ready <= 0 || !(pfd.revents & POLLIN)) continue;
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        Session& session = sessions.emplace_back();
+        session.fd = fd;
+        int id = next_id++;
+        session.thread = std::thread([&pool, &scheduler, &session, id, hash_mb] {
+            std::cerr << "info string session " << id << " connected" << std::endl;
+            {
+                std::mutex write_mutex;
+                SocketReadBuf in_buf(session.fd);
+                SocketLineBuf out_buf(session.fd, write_mutex);
+                SocketLineBuf search_buf(session.fd, write_mutex);
+                std::istream in(&in_buf);
+                std::ostream out(&out_buf);
+                std::ostream search_out(&search_buf);
+                SessionShare share{pool, scheduler, id, search_out};
+                uci_session(in, out, hash_mb, &share);
+            }
+            ::close(session.fd);
+            std::cerr << "info string session " << id << " closed" << std::endl;
+            session.done.store(true);
+        });
+    }
+
+    // End every session as if its client had gone away
+    std::cerr << "info string engine server stopping (" << sessions.size() << " sessions)" << std::endl;
+    for (Session& session : sessions) {
+        if (!session.done.load()) ::shutdown(session.fd, SHUT_RD);
+    }
+    for (Session& session : sessions) session.thread.join();
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+    return 0;
+}
+
+// ============================================================================
+// Client shim
+// ============================================================================
+
+int run_engine_client(const std::string& socket_path) {
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr)) return 1;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Cannot connect to " << socket_path << ": " << std::strerror(errno) << '\n';
+        if (fd >= 0) ::close(fd);
+        return 1;
+    }
+
+    // Copy everything read from `from` to `to`; false once `from` is closed
+    auto relay = [](int from, int to) {
+        char buf[4096];
+        ssize_t n = ::read(from, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) return true;
+        if (n <= 0) return false;
+        for (ssize_t off = 0; off < n;) {
+            ssize_t w = ::write(to, buf + off, static_cast<size_t>(n - off));
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return false;
+            off += w;
+        }
+        return true;
+    };
+
+    bool stdin_open = true;
+    while (true) {
+        pollfd pfds[2] = {{fd, POLLIN, 0}, {stdin_open ? STDIN_FILENO : -1, POLLIN, 0}};
+        if (::poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // The server closing the session ends the shim
+        if ((pfds[0].revents & (POLLIN | POLLHUP | POLLERR)) && !relay(fd, STDOUT_FILENO)) break;
+        if (pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            if (!relay(STDIN_FILENO, fd)) {
+                // The GUI is gone: let the session see end of input, then drain its output
+                stdin_open = false;
+                ::shutdown(fd, SHUT_WR);
+            }
+        }
+    }
+    ::close(fd);
+    return 0;
+}
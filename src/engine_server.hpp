@@ -0,0 +1,114 @@
+#pragma once
+
+#include "cachemiss.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Engine server: several UCI sessions in one process
+// ============================================================================
+// A bot playing many games at once would otherwise start one engine per game,
+// each with its own full-size hash table and as many busy threads as there
+// are games. The server accepts UCI sessions on a Unix domain socket and runs
+// them all against one memory budget and one set of search slots:
+//
+//   - HashPool splits the Hash budget between the connected sessions. A
+//     session takes its share when it connects, at "ucinewgame" and after
+//     every bestmove (on the opponent's clock), so tables shrink and grow as
+//     games start and end; mid-game the table is rescaled keeping its entries.
+//     A new session gets its full share at once; sessions left holding more
+//     are told to shrink as soon as they are idle.
+//   - SearchScheduler runs at most N searches at a time. Waiting searches are
+//     admitted by clock urgency (least time to think first); ponder searches
+//     only use otherwise idle slots and are stopped when a timed search needs
+//     their slot.
+//
+// "cachemiss --connect <socket>" is a stdin/stdout shim for GUIs and bots
+// that can only start engine processes.
+
+class HashPool {
+public:
+    explicit HashPool(size_t total_mb) : total_mb_(total_mb) {}
+
+    // Hash size (MB) for `session`: at most `requested_mb` and its even share
+    // of the budget among the connected sessions; at least 1. Replaces the
+    // session's previous grant. Sessions that now hold more than their share
+    // get their rebalance call, so the budget is only overrun until they
+    // have acquired again.
+    size_t acquire(int session, size_t requested_mb);
+
+    // Called (on the acquiring session's thread, under the pool's lock) when
+    // another session's grant leaves `session` above its share; it should
+    // acquire again at its next idle point
+    void on_rebalance(int session, std::function<void()> rebalance);
+
+    // Forget a session (disconnected) and its rebalance call; its memory goes
+    // to the next acquire
+    void release(int session);
+
+    size_t total_mb() const { return total_mb_; }
+    size_t allocated_mb() const;
+
+private:
+    size_t total_mb_;
+    mutable std::mutex mutex_;
+    std::map<int, size_t> granted_;  // Session -> MB currently held
+    std::map<int, std::function<void()>> rebalance_;
+};
+
+class SearchScheduler {
+public:
+    explicit SearchScheduler(int slots) : slots_(slots < 1 ? 1 : slots) {}
+
+    // Queue a search; returns its ticket for wait(), cancel() and release().
+    // urgency_ms: the time the search may use (smaller runs first)
+    // preempt: stops the search early; called at most once, only for ponder searches
+    u64 enqueue(int urgency_ms, bool ponder, std::function<void()> preempt = {});
+
+    // Block until the queued search may run. Returns false, and leaves the
+    // queue, if it is cancelled first: by cancel() or by `cancelled` returning
+    // true (checked whenever the waiter wakes up).
+    bool wait(u64 ticket, const std::function<bool()>& cancelled = {});
+
+    // Make a queued search give up its wait; no effect once it runs
+    void cancel(u64 ticket);
+
+    // enqueue() and wait() without cancellation
+    u64 acquire(int urgency_ms, bool ponder, std::function<void()> preempt = {});
+    void release(u64 ticket);
+
+    int slots() const { return slots_; }
+    int running() const;
+    int waiting() const;
+
+private:
+    struct Entry {
+        u64 ticket;
+        int urgency_ms;
+        bool ponder;
+        std::function<void()> preempt;
+        bool cancelled = false;
+    };
+
+    // Waiting entry to admit next: timed before ponder, then most urgent, then oldest
+    const Entry* next_waiting() const;
+
+    int slots_;
+    u64 next_ticket_ = 1;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Entry> waiting_;
+    std::vector<Entry> running_;
+};
+
+// Serve UCI sessions on `socket_path` until interrupted (SIGINT/SIGTERM).
+// hash_mb: total Hash budget; threads: concurrent searches (0 = one per CPU)
+int run_engine_server(const std::string& socket_path, size_t hash_mb, int threads);
+
+// Relay stdin/stdout to the server at `socket_path` until either side closes
+int run_engine_client(const std::string& socket_path);
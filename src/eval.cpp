@@ -1,4 +1,5 @@
 #include "eval.hpp"
+#include "cpu.hpp"
 #include "eval_params.hpp"
 #include "precalc.hpp"
 #include "move.hpp"
@@ -7,6 +8,7 @@
 
 // Global pawn structure cache
 PawnCache g_pawn_cache(1);
+thread_local PawnCache* t_pawn_cache = &g_pawn_cache;
 
 // Space evaluation zones
 constexpr Bitboard CENTER_4 = 0x0000001818000000ULL;         // d4, d5, e4, e5
@@ -294,7 +296,7 @@ static void evaluate_king_safety(const Board& board, int& mg, int& eg, const Bit
 }
 
 // Main evaluation function - combines PST, mobility, and positional features
-int evaluate(const Board& board) {
+CACHEMISS_TARGET_CLONES int evaluate(const Board& board) {
     int mg_score = 0;
     int eg_score = 0;
 
@@ -312,10 +314,11 @@ int evaluate(const Board& board) {
 
     // Pawn structure evaluation (with cache)
     int pawn_mg = 0, pawn_eg = 0;
-    if (!g_pawn_cache.probe(board.pawn_key, pawn_mg, pawn_eg)) {
+    PawnCache& pawn_cache = *t_pawn_cache;
+    if (!pawn_cache.probe(board.pawn_key, pawn_mg, pawn_eg)) {
         evaluate_pawn_structure(board, pawn_mg, pawn_eg);
         evaluate_passed_pawns(board, pawn_mg, pawn_eg);
-        g_pawn_cache.store(board.pawn_key, pawn_mg, pawn_eg);
+        pawn_cache.store(board.pawn_key, pawn_mg, pawn_eg);
     }
     mg_score += pawn_mg;
     eg_score += pawn_eg;
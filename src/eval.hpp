@@ -6,5 +6,10 @@
 // Global pawn structure cache (1 MB default)
 extern PawnCache g_pawn_cache;
 
+// Pawn cache evaluate() uses on the calling thread; points at g_pawn_cache
+// unless the thread installed its own (independent searches running side by
+// side, e.g. tools/match -inprocess, each need one)
+extern thread_local PawnCache* t_pawn_cache;
+
 // Evaluate the position from the side-to-move's perspective
 int evaluate(const Board& board);
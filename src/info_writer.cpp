@@ -0,0 +1,86 @@
+#include "info_writer.hpp"
+#include "search.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+void InfoWriter::append(std::string_view text) {
+    size_t n = std::min(text.size(), BUFFER_SIZE - 1 - len);
+    std::memcpy(buf + len, text.data(), n);
+    len += n;
+}
+
+void InfoWriter::append(s64 value) {
+    auto [end, ec] = std::to_chars(buf + len, buf + BUFFER_SIZE - 1, value);
+    if (ec == std::errc()) len = static_cast<size_t>(end - buf);
+}
+
+void InfoWriter::append(Move32 move) {
+    if (len + 6 >= BUFFER_SIZE) return;
+    int from_sq = move.from();
+    int to_sq = move.to();
+    buf[len++] = static_cast<char>('a' + from_sq % 8);
+    buf[len++] = static_cast<char>('1' + from_sq / 8);
+    buf[len++] = static_cast<char>('a' + to_sq % 8);
+    buf[len++] = static_cast<char>('1' + to_sq / 8);
+    if (move.is_promotion()) {
+        // UCI uses lowercase for promotion piece
+        char promo = piece_to_char(move.promotion());
+        buf[len++] = (promo >= 'A' && promo <= 'Z') ? static_cast<char>(promo + 32) : promo;
+    }
+}
+
+std::string_view InfoWriter::format_pv(int depth, int seldepth, int score, ScoreBound bound, u64 nodes,
+                                       s64 time_ms, int hashfull, const Move32* pv, int pv_length) {
+    len = 0;
+    append("info depth ");
+    append(depth);
+    append(" seldepth ");
+    append(std::max(seldepth, depth));
+
+    if (is_mate_score(score)) {
+        append(" score mate ");
+        append(mate_in_moves(score));
+    } else {
+        append(" score cp ");
+        append(score);
+    }
+    if (bound == ScoreBound::Lower) append(" lowerbound");
+    if (bound == ScoreBound::Upper) append(" upperbound");
+
+    append(" nodes ");
+    append(static_cast<s64>(nodes));
+    append(" nps ");
+    append(time_ms > 0 ? static_cast<s64>(nodes * 1000 / static_cast<u64>(time_ms)) : 0);
+    append(" hashfull ");
+    append(hashfull);
+    append(" time ");
+    append(time_ms);
+
+    if (pv_length > 0) {
+        append(" pv");
+        for (int i = 0; i < pv_length; ++i) {
+            append(" ");
+            append(pv[i]);
+        }
+    }
+    return {buf, len};
+}
+
+std::string_view InfoWriter::format_currmove(int depth, Move32 move, int number) {
+    len = 0;
+    append("info depth ");
+    append(depth);
+    append(" currmove ");
+    append(move);
+    append(" currmovenumber ");
+    append(number);
+    return {buf, len};
+}
+
+void InfoWriter::write(std::ostream& out) const {
+    out.write(buf, static_cast<std::streamsize>(len));
+    out.put('\n');
+    out.flush();
+}
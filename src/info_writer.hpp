@@ -0,0 +1,43 @@
+#pragma once
+
+#include "move.hpp"
+#include <iosfwd>
+#include <string_view>
+
+// ============================================================================
+// UCI "info" output for the search
+// ============================================================================
+// Lines are formatted with std::to_chars into a fixed buffer and written with
+// a single stream write, so printing costs no allocations. Intra-iteration
+// output (aspiration fail lines, currmove) only starts once a search has run
+// for a while: short searches print one line per iteration and nothing else.
+
+enum class ScoreBound { Exact, Lower, Upper };
+
+class InfoWriter {
+public:
+    // Delay before currmove and lowerbound/upperbound lines are printed
+    static constexpr int CURRMOVE_DELAY_MS = 3000;
+    static constexpr int BOUND_DELAY_MS = 3000;
+
+    // "info depth .. seldepth .. score cp|mate .. [lowerbound|upperbound]
+    //  nodes .. nps .. hashfull .. time .. pv .."
+    // The returned text is valid until the next format call.
+    std::string_view format_pv(int depth, int seldepth, int score, ScoreBound bound, u64 nodes,
+                               s64 time_ms, int hashfull, const Move32* pv, int pv_length);
+
+    // "info depth .. currmove .. currmovenumber .."
+    std::string_view format_currmove(int depth, Move32 move, int number);
+
+    // Write the last formatted line (with newline) and flush
+    void write(std::ostream& out) const;
+
+private:
+    static constexpr size_t BUFFER_SIZE = 2048;  // Longest line: full PV of MAX_PLY moves
+    char buf[BUFFER_SIZE];
+    size_t len = 0;
+
+    void append(std::string_view text);
+    void append(s64 value);
+    void append(Move32 move);
+};
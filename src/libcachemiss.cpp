@@ -0,0 +1,181 @@
+#include "libcachemiss.h"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "pawn_cache.hpp"
+#include "search.hpp"
+#include "ttable.hpp"
+#include "zobrist.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// C API (libcachemiss.h)
+// ============================================================================
+// A thin layer over the engine: each instance bundles what a UCI session
+// keeps, and searches run silently on the caller's thread with the
+// instance's own controller and pawn cache.
+
+struct cachemiss_engine {
+    Board board;
+    std::vector<u64> game_hashes;  // Positions before the current one (repetition detection)
+    TTable tt;
+    PawnCache pawn_cache;
+    SearchController controller;
+
+    explicit cachemiss_engine(size_t hash_mb) : tt(hash_mb) {}
+};
+
+namespace {
+
+// Evaluation and search of this instance use its pawn cache
+class UsePawnCache {
+public:
+    explicit UsePawnCache(PawnCache& cache) : previous_(t_pawn_cache) { t_pawn_cache = &cache; }
+    ~UsePawnCache() { t_pawn_cache = previous_; }
+
+private:
+    PawnCache* previous_;
+};
+
+// Apply a UCI move if it is legal
+bool apply_move(Board& board, std::vector<u64>& hashes, const char* text) {
+    if (!text) return false;
+    Move32 move = parse_uci_move(text, board);
+    if (move.data == 0) return false;
+    Board next = board;
+    (void)make_move(next, move);
+    if (is_illegal(next)) return false;
+    hashes.push_back(board.hash);
+    board = next;
+    return true;
+}
+
+void copy_move(char* dest, Move32 move) {
+    std::string uci = move.to_uci();
+    std::memcpy(dest, uci.c_str(), std::min(uci.size() + 1, size_t(CACHEMISS_MOVE_CHARS)));
+    dest[CACHEMISS_MOVE_CHARS - 1] = '\0';
+}
+
+std::once_flag g_init_once;
+
+}  // namespace
+
+extern "C" {
+
+int cachemiss_api_version(void) {
+    return CACHEMISS_API_VERSION;
+}
+
+cachemiss_engine* cachemiss_create(size_t hash_mb) {
+    std::call_once(g_init_once, zobrist::init);
+    try {
+        return new cachemiss_engine(std::max<size_t>(1, hash_mb));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void cachemiss_destroy(cachemiss_engine* engine) {
+    delete engine;
+}
+
+void cachemiss_new_game(cachemiss_engine* engine) {
+    if (!engine) return;
+    engine->tt.clear();
+    engine->pawn_cache.clear();
+}
+
+cachemiss_status cachemiss_set_position(cachemiss_engine* engine, const char* fen, const char* const* moves,
+                                        int move_count) {
+    if (!engine || move_count < 0 || (move_count > 0 && !moves)) return CACHEMISS_INVALID_ARGUMENT;
+    Board board;
+    if (fen && !parse_fen(fen, board)) return CACHEMISS_INVALID_FEN;
+
+    std::vector<u64> hashes;
+    for (int i = 0; i < move_count; ++i) {
+        if (!apply_move(board, hashes, moves[i])) return CACHEMISS_ILLEGAL_MOVE;
+    }
+    engine->board = board;
+    engine->game_hashes = std::move(hashes);
+    return CACHEMISS_OK;
+}
+
+cachemiss_status cachemiss_make_move(cachemiss_engine* engine, const char* move) {
+    if (!engine || !move) return CACHEMISS_INVALID_ARGUMENT;
+    return apply_move(engine->board, engine->game_hashes, move) ? CACHEMISS_OK : CACHEMISS_ILLEGAL_MOVE;
+}
+
+int cachemiss_get_fen(const cachemiss_engine* engine, char* buffer, size_t size) {
+    if (!engine || !buffer) return -1;
+    std::string fen = engine->board.to_fen();
+    if (fen.size() + 1 > size) return -1;
+    std::memcpy(buffer, fen.c_str(), fen.size() + 1);
+    return static_cast<int>(fen.size());
+}
+
+int cachemiss_legal_moves(const cachemiss_engine* engine, char moves[CACHEMISS_MAX_MOVES][CACHEMISS_MOVE_CHARS]) {
+    if (!engine || !moves) return 0;
+    Board board = engine->board;
+    MoveList list = generate_moves<MoveType::All>(board);
+    int count = 0;
+    for (int i = 0; i < list.size && count < CACHEMISS_MAX_MOVES; ++i) {
+        UndoInfo undo = make_move(board, list[i]);
+        if (!is_illegal(board)) copy_move(moves[count++], list[i]);
+        unmake_move(board, list[i], undo);
+    }
+    return count;
+}
+
+int cachemiss_evaluate(cachemiss_engine* engine) {
+    if (!engine) return 0;
+    UsePawnCache use(engine->pawn_cache);
+    return evaluate(engine->board);
+}
+
+cachemiss_status cachemiss_search(cachemiss_engine* engine, const cachemiss_limits* limits,
+                                  cachemiss_result* result) {
+    if (!engine || !result) return CACHEMISS_INVALID_ARGUMENT;
+    UsePawnCache use(engine->pawn_cache);
+
+    SearchLimits search_limits;
+    search_limits.time_ms = 999999999;  // Until a limit or cachemiss_stop()
+    if (limits) {
+        if (limits->movetime_ms > 0) search_limits.time_ms = limits->movetime_ms;
+        search_limits.depth = std::max(0, limits->depth);
+        search_limits.nodes = limits->nodes;
+    }
+    search_limits.silent = true;
+    search_limits.controller = &engine->controller;
+
+    engine->controller.reset();
+    engine->tt.new_search();
+    Board board = engine->board;
+    SearchResult r = search(board, engine->tt, search_limits, engine->game_hashes.data(),
+                            static_cast<int>(engine->game_hashes.size()));
+
+    std::memset(result, 0, sizeof(*result));
+    if (r.best_move.data != 0) copy_move(result->best_move, r.best_move);
+    if (is_mate_score(r.score)) {
+        result->mate = mate_in_moves(r.score);
+    } else {
+        result->score_cp = r.score;
+    }
+    result->depth = r.depth;
+    result->seldepth = r.seldepth;
+    result->nodes = r.nodes;
+    result->time_ms = r.elapsed_ms;
+    result->pv_length = std::min(r.pv_length, CACHEMISS_MAX_PV);
+    for (int i = 0; i < result->pv_length; ++i) copy_move(result->pv[i], r.pv[i]);
+    return CACHEMISS_OK;
+}
+
+void cachemiss_stop(cachemiss_engine* engine) {
+    if (engine) engine->controller.request_stop();
+}
+
+}  // extern "C"
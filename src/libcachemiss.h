@@ -0,0 +1,105 @@
+/*
+ * libcachemiss - C API for embedding the CacheMiss engine
+ *
+ * An engine instance owns its position, hash table, pawn cache and stop
+ * flag. Instances share nothing mutable, so different instances can be used
+ * from different threads at the same time; a single instance must not be
+ * used from two threads at once, except for cachemiss_stop().
+ *
+ * Moves are UCI strings ("e2e4", "e7e8q"). Functions that can fail return a
+ * cachemiss_status; everything else cannot fail for valid arguments.
+ */
+#ifndef LIBCACHEMISS_H
+#define LIBCACHEMISS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define CACHEMISS_API __declspec(dllexport)
+#else
+#define CACHEMISS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a declaration below changes incompatibly */
+#define CACHEMISS_API_VERSION 1
+
+#define CACHEMISS_MAX_PV 64
+#define CACHEMISS_MAX_MOVES 256
+#define CACHEMISS_MOVE_CHARS 6 /* Longest UCI move ("e7e8q") plus terminator */
+
+typedef enum {
+    CACHEMISS_OK = 0,
+    CACHEMISS_INVALID_ARGUMENT = 1,
+    CACHEMISS_INVALID_FEN = 2,
+    CACHEMISS_ILLEGAL_MOVE = 3,
+    CACHEMISS_OUT_OF_MEMORY = 4
+} cachemiss_status;
+
+typedef struct cachemiss_engine cachemiss_engine;
+
+/* Zero for "no limit"; with no limit at all the search runs until
+   cachemiss_stop() or the maximum depth */
+typedef struct {
+    int depth;
+    uint64_t nodes;
+    int movetime_ms;
+} cachemiss_limits;
+
+typedef struct {
+    char best_move[CACHEMISS_MOVE_CHARS]; /* Empty when there is no legal move */
+    int score_cp;      /* From the side to move's point of view; 0 when mate != 0 */
+    int mate;          /* Moves to mate: > 0 we mate, < 0 we are mated, 0 none */
+    int depth;         /* Last completed iteration */
+    int seldepth;
+    uint64_t nodes;
+    int time_ms;
+    int pv_length;
+    char pv[CACHEMISS_MAX_PV][CACHEMISS_MOVE_CHARS];
+} cachemiss_result;
+
+CACHEMISS_API int cachemiss_api_version(void);
+
+/* New instance at the starting position with a hash_mb table (at least 1).
+   Returns NULL if the table can't be allocated. */
+CACHEMISS_API cachemiss_engine* cachemiss_create(size_t hash_mb);
+CACHEMISS_API void cachemiss_destroy(cachemiss_engine* engine);
+
+/* Clear the hash table (a new, unrelated game or position set) */
+CACHEMISS_API void cachemiss_new_game(cachemiss_engine* engine);
+
+/* Set the position from a FEN (NULL: the starting position) followed by
+   move_count moves. On error the position is unchanged. */
+CACHEMISS_API cachemiss_status cachemiss_set_position(cachemiss_engine* engine, const char* fen,
+                                                      const char* const* moves, int move_count);
+
+/* Play one more move on the current position */
+CACHEMISS_API cachemiss_status cachemiss_make_move(cachemiss_engine* engine, const char* move);
+
+/* Current position as FEN into buffer (size bytes, terminated).
+   Returns the FEN length, or -1 if buffer is too small. */
+CACHEMISS_API int cachemiss_get_fen(const cachemiss_engine* engine, char* buffer, size_t size);
+
+/* Legal moves of the current position; returns their number */
+CACHEMISS_API int cachemiss_legal_moves(const cachemiss_engine* engine,
+                                        char moves[CACHEMISS_MAX_MOVES][CACHEMISS_MOVE_CHARS]);
+
+/* Static evaluation in centipawns from the side to move's point of view */
+CACHEMISS_API int cachemiss_evaluate(cachemiss_engine* engine);
+
+/* Search the current position on the calling thread; limits may be NULL */
+CACHEMISS_API cachemiss_status cachemiss_search(cachemiss_engine* engine, const cachemiss_limits* limits,
+                                                cachemiss_result* result);
+
+/* Stop a search running on another thread; it returns its best result so far */
+CACHEMISS_API void cachemiss_stop(cachemiss_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCACHEMISS_H */
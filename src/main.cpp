@@ -1,10 +1,16 @@
+#include "analyze.hpp"
 #include "bench.hpp"
 #include "board.hpp"
+#include "cgroup.hpp"
+#include "engine_server.hpp"
 #include "move.hpp"
 #include "perft.hpp"
 #include "search.hpp"
+#include "telemetry.hpp"
+#include "tree_log.hpp"
 #include "uci.hpp"
 #include "zobrist.hpp"
+#include <algorithm>
 #include <getopt.h>
 #include <iostream>
 #include <string>
@@ -16,10 +22,23 @@ void print_usage(const char* prog) {
               << "  --perft <depth>          Run perft to given depth\n"
               << "  --divide <depth>         Run divide (perft per move) to given depth\n"
               << "  --search[=time]          Search for best move (time in ms, default: 10000)\n"
+              << "  --bench[=depth]          Fixed-depth search bench over built-in positions (default: 9)\n"
               << "  --bench-perftsuite <file>[=max_depth]  Run perft test suite\n"
               << "  --bench-wac <file>[=time_ms]  Run WAC test suite (default: 1000ms)\n"
               << "  --wac-id <id>            Filter WAC suite to single position\n"
               << "  --mem <mb>               Hash table size in MB (default: 512)\n"
+              << "  --tree-log <file>        Log the search tree (needs -DCACHEMISS_TREE_LOG=ON;\n"
+              << "                           not with --server, and --analyze needs --threads 1)\n"
+              << "  --analyze <file>         Analyse each FEN/EPD line of a file, JSONL results to stdout\n"
+              << "  --depth <d>              Depth limit for --analyze (default: 10 if no other limit)\n"
+              << "  --nodes <n>              Node limit for --analyze\n"
+              << "  --movetime <ms>          Time per position for --analyze\n"
+              << "  --multipv <n>            Best moves reported per position by --analyze (default: 1)\n"
+              << "  --server <socket>        Serve UCI sessions on a Unix socket, sharing --mem between them\n"
+              << "  --threads <n>            Workers for --analyze, concurrent searches for --server\n"
+              << "                           (default: one per CPU)\n"
+              << "  --connect <socket>       Relay stdin/stdout to a --server (for GUIs that start engines)\n"
+              << "  --telemetry <file>       Append per-move telemetry of every --server session to a file\n"
               << "  -h, --help               Show this help\n";
 }
 
@@ -30,22 +49,42 @@ int main(int argc, char* argv[]) {
     int perft_depth = 0;
     int divide_depth = 0;
     int search_time = 0;
+    int bench_depth = 0;
     std::string perftsuite_file;
     int perftsuite_max_depth = 0;
     std::string wac_file;
     int wac_time_ms = 1000;
     std::string wac_id;
     size_t mem_mb = 512;
+    bool mem_mb_set = false;
+    std::string tree_log_file;
+    std::string server_socket;
+    std::string connect_socket;
+    std::string telemetry_file;
+    int threads = 0;
+    std::string analyze_file_name;
+    AnalyzeOptions analyze_options;
 
     enum Opt {
         OPT_FEN = 'f',
         OPT_PERFT = 'p',
         OPT_DIVIDE = 'd',
         OPT_SEARCH = 's',
+        OPT_BENCH = 'b',
         OPT_BENCH_PERFTSUITE = 'P',
         OPT_BENCH_WAC = 'w',
         OPT_WAC_ID = 'i',
         OPT_MEM = 'm',
+        OPT_TREE_LOG = 'T',
+        OPT_ANALYZE = 'A',
+        OPT_DEPTH = 'D',
+        OPT_NODES = 'n',
+        OPT_MOVETIME = 'M',
+        OPT_MULTIPV = 'v',
+        OPT_SERVER = 'S',
+        OPT_THREADS = 't',
+        OPT_CONNECT = 'c',
+        OPT_TELEMETRY = 'L',
         OPT_HELP = 'h',
     };
 
@@ -54,16 +93,27 @@ int main(int argc, char* argv[]) {
         {"perft",           required_argument, nullptr, OPT_PERFT},
         {"divide",          required_argument, nullptr, OPT_DIVIDE},
         {"search",          optional_argument, nullptr, OPT_SEARCH},
+        {"bench",           optional_argument, nullptr, OPT_BENCH},
         {"bench-perftsuite", required_argument, nullptr, OPT_BENCH_PERFTSUITE},
         {"bench-wac",       required_argument, nullptr, OPT_BENCH_WAC},
         {"wac-id",          required_argument, nullptr, OPT_WAC_ID},
         {"mem",             required_argument, nullptr, OPT_MEM},
+        {"tree-log",        required_argument, nullptr, OPT_TREE_LOG},
+        {"analyze",         required_argument, nullptr, OPT_ANALYZE},
+        {"depth",           required_argument, nullptr, OPT_DEPTH},
+        {"nodes",           required_argument, nullptr, OPT_NODES},
+        {"movetime",        required_argument, nullptr, OPT_MOVETIME},
+        {"multipv",         required_argument, nullptr, OPT_MULTIPV},
+        {"server",          required_argument, nullptr, OPT_SERVER},
+        {"threads",         required_argument, nullptr, OPT_THREADS},
+        {"connect",         required_argument, nullptr, OPT_CONNECT},
+        {"telemetry",       required_argument, nullptr, OPT_TELEMETRY},
         {"help",            no_argument,       nullptr, OPT_HELP},
         {nullptr, 0, nullptr, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "f:p:d:s::P:w:i:m:h", long_options, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "f:p:d:s::b::P:w:i:m:T:A:D:n:M:v:S:t:c:L:h", long_options, nullptr)) != -1) {
         switch (opt) {
         case OPT_FEN:
             fen = optarg;
@@ -77,6 +127,9 @@ int main(int argc, char* argv[]) {
         case OPT_SEARCH:
             search_time = optarg ? std::stoi(optarg) : 10000;
             break;
+        case OPT_BENCH:
+            bench_depth = optarg ? std::stoi(optarg) : 9;
+            break;
         case OPT_BENCH_PERFTSUITE:
             perftsuite_file = optarg;
             if (optind < argc && argv[optind][0] != '-') {
@@ -94,6 +147,37 @@ int main(int argc, char* argv[]) {
             break;
         case OPT_MEM:
             mem_mb = std::stoul(optarg);
+            mem_mb_set = true;
+            break;
+        case OPT_TREE_LOG:
+            tree_log_file = optarg;
+            break;
+        case OPT_ANALYZE:
+            analyze_file_name = optarg;
+            break;
+        case OPT_DEPTH:
+            analyze_options.depth = std::stoi(optarg);
+            break;
+        case OPT_NODES:
+            analyze_options.nodes = std::stoull(optarg);
+            break;
+        case OPT_MOVETIME:
+            analyze_options.movetime_ms = std::stoi(optarg);
+            break;
+        case OPT_MULTIPV:
+            analyze_options.multipv = std::max(1, std::stoi(optarg));
+            break;
+        case OPT_SERVER:
+            server_socket = optarg;
+            break;
+        case OPT_THREADS:
+            threads = std::stoi(optarg);
+            break;
+        case OPT_CONNECT:
+            connect_socket = optarg;
+            break;
+        case OPT_TELEMETRY:
+            telemetry_file = optarg;
             break;
         case OPT_HELP:
             print_usage(argv[0]);
@@ -104,6 +188,50 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!tree_log_file.empty()) {
+        if (!TREE_LOG_ENABLED) {
+            std::cerr << "--tree-log requires a build with -DCACHEMISS_TREE_LOG=ON\n";
+            return 1;
+        }
+        // The logger is one file shared by the process; only one search may write to it
+        bool parallel_analyze = !analyze_file_name.empty() && threads != 1;
+        if (!server_socket.empty() || parallel_analyze) {
+            std::cerr << "--tree-log works with a single search: use it without --server, "
+                         "and with --analyze only together with --threads 1\n";
+            return 1;
+        }
+        if (!g_tree_log.open(tree_log_file)) {
+            std::cerr << "Cannot open tree log: " << tree_log_file << '\n';
+            return 1;
+        }
+    }
+
+    if (!connect_socket.empty()) {
+        return run_engine_client(connect_socket);
+    }
+
+    if (!server_socket.empty()) {
+        // Sessions can't set the log themselves: it is one per process
+        if (!telemetry_file.empty() && !g_telemetry.open(telemetry_file)) {
+            std::cerr << "Cannot open telemetry file: " << telemetry_file << '\n';
+            return 1;
+        }
+        int status = run_engine_server(server_socket, mem_mb, threads);
+        g_telemetry.close();
+        return status;
+    }
+
+    if (!analyze_file_name.empty()) {
+        analyze_options.threads = threads > 0 ? threads : available_cpus();
+        analyze_options.hash_mb = mem_mb_set ? mem_mb : 0;
+        return analyze_file(analyze_file_name, analyze_options) ? 0 : 1;
+    }
+
+    if (bench_depth > 0) {
+        bench_search(bench_depth, mem_mb_set ? mem_mb : 16);
+        return 0;
+    }
+
     if (!perftsuite_file.empty()) {
         bench_perftsuite(perftsuite_file, perftsuite_max_depth, mem_mb);
         return 0;
@@ -1,10 +1,14 @@
 #include "cachemiss.hpp"
 #include "board.hpp"
+#include "cpu.hpp"
 #include "precalc.hpp"
 #include "move.hpp"
 #include "zobrist.hpp"
 #include <cassert>
 #include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
 
 // SEE piece values (standard centipawn values)
 constexpr int SEE_VALUES[] = { 100, 320, 330, 500, 900, 20000, 0, 0 };
@@ -39,7 +43,7 @@ constexpr Bitboard BLACK_OO_PATH  = (1ULL << F8) | (1ULL << G8);
 constexpr Bitboard BLACK_OOO_PATH = (1ULL << 57) | (1ULL << C8) | (1ULL << D8); // b8, c8, d8
 
 template <Color turn, MoveType type>
-MoveList generate_moves(const Board& board) {
+CACHEMISS_TARGET_CLONES_TEMPLATE MoveList generate_moves(const Board& board) {
     MoveList moves;
 
     constexpr bool gen_noisy = (type == MoveType::All || type == MoveType::Noisy);
@@ -534,7 +538,7 @@ void unmake_null_move(Board& b, int prev_ep_file) {
     b.turn = opposite(b.turn);
 }
 
-bool is_attacked(int square, Color attacker, const Board& board) {
+CACHEMISS_TARGET_CLONES bool is_attacked(int square, Color attacker, const Board& board) {
     if (attacker == Color::White) {
         return is_attacked<Color::White>(square, board);
     } else {
@@ -548,6 +552,37 @@ bool is_illegal(const Board& board) {
     return is_attacked(board.king_sq[(int)us], them, board);
 }
 
+bool parse_fen(std::string_view fen, Board& board) {
+    std::istringstream iss{std::string(fen)};
+    std::string placement, side;
+    if (!(iss >> placement >> side) || (side != "w" && side != "b")) return false;
+
+    int rank = 0, file = 0;
+    int kings[2] = {0, 0};
+    for (char c : placement) {
+        if (c == '/') {
+            if (file != 8) return false;
+            ++rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else if (std::strchr("pnbrqkPNBRQK", c)) {
+            if (c == 'K') ++kings[0];
+            if (c == 'k') ++kings[1];
+            ++file;
+        } else {
+            return false;
+        }
+        if (file > 8) return false;
+    }
+    if (rank != 7 || file != 8 || kings[0] != 1 || kings[1] != 1) return false;
+
+    Board parsed(fen);
+    if (is_illegal(parsed)) return false;  // The side not to move is in check
+    board = parsed;
+    return true;
+}
+
 // Get all pieces attacking a square (both colors)
 static Bitboard get_all_attackers(int sq, Bitboard occ, const Board& board) {
     Bitboard bishops = board.pieces[0][(int)Piece::Bishop] | board.pieces[1][(int)Piece::Bishop];
@@ -562,7 +597,7 @@ static Bitboard get_all_attackers(int sq, Bitboard occ, const Board& board) {
          | (get_rook_attacks(sq, occ) & (rooks | queens));
 }
 
-int see(const Board& board, const Move32& move) {
+CACHEMISS_TARGET_CLONES int see(const Board& board, const Move32& move) {
     int to_sq = move.to();
     int from_sq = move.from();
 
@@ -642,7 +677,7 @@ int see(const Board& board, const Move32& move) {
 
 // SEE threshold check with early exit optimization
 // Returns true if see(board, move) >= threshold
-bool see_ge(const Board& board, const Move32& move, int threshold) {
+CACHEMISS_TARGET_CLONES bool see_ge(const Board& board, const Move32& move, int threshold) {
     int to_sq = move.to();
     int from_sq = move.from();
 
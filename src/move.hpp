@@ -123,6 +123,11 @@ bool is_attacked(int square, Color attacker, const Board& board);
 // Check if the side that just moved left their king in check (illegal move)
 bool is_illegal(const Board& board);
 
+// Parse a FEN into `board` if it describes a usable position: a valid
+// placement and side to move, one king per side, and the side not to move
+// not in check. Board's own constructor accepts anything.
+bool parse_fen(std::string_view fen, Board& board);
+
 // Static Exchange Evaluation - compute material outcome of capture sequences
 int see(const Board& board, const Move32& move);
 
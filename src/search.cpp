@@ -1,5 +1,10 @@
 #include "search.hpp"
 #include "eval.hpp"
+#include "info_writer.hpp"
+#include "search_params.hpp"
+#include "trace.hpp"
+#include "tree_log.hpp"
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
@@ -14,36 +19,45 @@ SearchController g_search_controller;
 
 // Core search constants
 constexpr int INFINITY_SCORE = 30000;
-constexpr int MATE_SCORE = 29000;
 
 // Time management
 constexpr int NODE_CHECK_INTERVAL = 2048;     // Check time every N nodes (must be power of 2)
 constexpr int NODE_CHECK_MASK = NODE_CHECK_INTERVAL - 1;  // Bitmask for fast modulo
 
-// Aspiration window
-constexpr int ASPIRATION_WINDOW = 50;         // Initial aspiration window size (centipawns)
-
-// Null Move Pruning (NMP)
-constexpr int NMP_MIN_DEPTH = 3;              // Minimum depth to apply NMP
-constexpr int NMP_HIGH_DEPTH = 6;             // Depth threshold for higher reduction
-constexpr int NMP_REDUCTION_LOW = 2;          // Reduction at low depths
-constexpr int NMP_REDUCTION_HIGH = 3;         // Reduction at high depths
-constexpr int NMP_DRAW_THRESHOLD = 50;        // Ignore NMP if score is within this of draw
-
-// Late Move Reductions (LMR)
-constexpr int LMR_MIN_MOVES = 4;              // Minimum moves searched before applying LMR
-constexpr int LMR_MIN_DEPTH = 3;              // Minimum depth to apply LMR
-constexpr int LMR_PV_REDUCTION = 1;           // Reduce LMR by this amount in PV nodes
-constexpr int LMR_MIN_REDUCED_DEPTH = 1;      // Never reduce below this depth
+// Tunable parameters (aspiration window, NMP, LMR, move ordering, SEE pruning)
+// live in search_params.hpp:
+//   ASPIRATION_WINDOW     Initial aspiration window size (centipawns)
+//   NMP_MIN_DEPTH         Minimum depth to apply NMP
+//   NMP_HIGH_DEPTH        Depth threshold for higher reduction
+//   NMP_REDUCTION_LOW     Reduction at low depths
+//   NMP_REDUCTION_HIGH    Reduction at high depths
+//   NMP_DRAW_THRESHOLD    Ignore NMP if score is within this of draw
+//   LMR_MIN_MOVES         Minimum moves searched before applying LMR
+//   LMR_MIN_DEPTH         Minimum depth to apply LMR
+//   LMR_PV_REDUCTION      Reduce LMR by this amount in PV nodes
+//   LMR_MIN_REDUCED_DEPTH Never reduce below this depth
+//   LMR_BASE/LMR_DIVISOR  LMR table formula (hundredths)
+//   KILLER_SCORE_1/2      Move ordering bonus for killer moves
+//   HISTORY_MAX           History score cap (must stay below the killer scores)
+//   SEE_PRUNE_MARGIN      Shallow captures losing more than this are skipped
+using namespace search_params;
 
 // LMR (Late Move Reduction) table
 // Indexed by [depth][move_count], values are reduction amounts
 constexpr int LMR_MAX_DEPTH = 64;
 constexpr int LMR_MAX_MOVES = 64;
-static int LMR_TABLE[LMR_MAX_DEPTH][LMR_MAX_MOVES];
+// Tuning builds keep the table per thread, like the parameters it is built from
+#ifdef CACHEMISS_TUNE
+#define SEARCH_TABLE_STORAGE static thread_local
+#else
+#define SEARCH_TABLE_STORAGE static
+#endif
+SEARCH_TABLE_STORAGE int LMR_TABLE[LMR_MAX_DEPTH][LMR_MAX_MOVES];
+SEARCH_TABLE_STORAGE int lmr_table_base = -1;     // LMR_BASE/LMR_DIVISOR the table was built with
+SEARCH_TABLE_STORAGE int lmr_table_divisor = -1;
 
 // Initialize LMR table with log-based formula
-// Called once at startup
+// Called at startup and whenever the LMR parameters change
 static bool init_lmr_table() {
     for (int depth = 0; depth < LMR_MAX_DEPTH; ++depth) {
         for (int moves = 0; moves < LMR_MAX_MOVES; ++moves) {
@@ -51,18 +65,25 @@ static bool init_lmr_table() {
                 LMR_TABLE[depth][moves] = 0;
             } else {
                 // Standard log formula used by many engines
-                // R = 0.5 + ln(depth) * ln(moves) / 2.25
-                double reduction = 0.5 + std::log(depth) * std::log(moves) / 2.25;
+                // R = 0.5 + ln(depth) * ln(moves) / 2.25 with the default parameters
+                double reduction = LMR_BASE / 100.0 + std::log(depth) * std::log(moves) / (LMR_DIVISOR / 100.0);
                 LMR_TABLE[depth][moves] = static_cast<int>(reduction);
             }
         }
     }
+    lmr_table_base = LMR_BASE;
+    lmr_table_divisor = LMR_DIVISOR;
     return true;
 }
 
 // Static initialization
 static bool lmr_initialized = init_lmr_table();
 
+void refresh_search_tables() {
+    if (lmr_table_base == LMR_BASE && lmr_table_divisor == LMR_DIVISOR) return;
+    init_lmr_table();
+}
+
 // Piece values for MVV-LVA move ordering
 constexpr int MVV_LVA_VALUES[] = {
     100,   // Pawn
@@ -75,10 +96,6 @@ constexpr int MVV_LVA_VALUES[] = {
     0      // None
 };
 
-// Move ordering bonuses
-constexpr int KILLER_SCORE_1 = 9000;
-constexpr int KILLER_SCORE_2 = 8000;
-constexpr int HISTORY_MAX = 6000;
 
 // ============================================================================
 // SearchContext - bundles all search state
@@ -91,8 +108,10 @@ struct SearchContext {
     // Time control
     std::chrono::steady_clock::time_point start_time;
     int time_limit_ms;
+    u64 node_limit;          // 0 = unlimited
     bool stop_search = false;
     u64 nodes_searched = 0;
+    int seldepth = 0;
 
     // Move ordering tables
     Move32 killers[MAX_PLY][2] = {};
@@ -107,11 +126,24 @@ struct SearchContext {
     std::array<u64, 1024> hash_stack;
     int hash_sp = 0;
 
-    SearchContext(Board& b, TTable& t, int time_ms,
-                  const u64* hash_history = nullptr, int hash_history_len = 0)
+    // UCI info output
+    InfoWriter info;
+    bool silent;             // No info output at all
+    const std::atomic<bool>* abort;  // Extra stop flag (may be null)
+    SearchController& controller;
+    std::ostream& out;
+    const Move32* exclude = nullptr;  // Root moves left out
+    int exclude_count = 0;
+    int report_after_depth = 0;       // Iterations up to this depth print nothing
+
+    SearchContext(Board& b, TTable& t, int time_ms, u64 max_nodes = 0,
+                  const u64* hash_history = nullptr, int hash_history_len = 0, bool quiet = false,
+                  const std::atomic<bool>* abort_flag = nullptr, SearchController& ctl = g_search_controller,
+                  std::ostream& info_out = std::cout)
         : board(b), tt(t),
           start_time(std::chrono::steady_clock::now()),
-          time_limit_ms(time_ms) {
+          time_limit_ms(time_ms), node_limit(max_nodes), silent(quiet), abort(abort_flag),
+          controller(ctl), out(info_out) {
         if (hash_history && hash_history_len > 0) {
             int count = std::min(hash_history_len, 1024);
             for (int i = 0; i < count; ++i) {
@@ -122,8 +154,12 @@ struct SearchContext {
     }
 
     bool check_time() {
-        // Check global stop flag (set by UCI thread via SearchController)
-        if (g_search_controller.should_stop()) {
+        // Check stop flag (set by UCI thread via SearchController)
+        if (controller.should_stop() || (abort && abort->load(std::memory_order_relaxed))) {
+            stop_search = true;
+            return true;
+        }
+        if (node_limit && nodes_searched >= node_limit) {
             stop_search = true;
             return true;
         }
@@ -131,18 +167,44 @@ struct SearchContext {
             auto now = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count();
             // Use overridden time limit if set (for ponderhit), otherwise use local
-            int effective_limit = g_search_controller.get_time_limit_override();
+            int effective_limit = controller.get_time_limit_override();
             if (effective_limit <= 0) {
                 effective_limit = time_limit_ms;
             }
             if (elapsed >= effective_limit) {
                 stop_search = true;
-                std::cerr << "info string stopping: elapsed=" << elapsed << "ms limit=" << effective_limit << "ms" << std::endl;
+                if (!silent) std::cerr << "info string stopping: elapsed=" << elapsed << "ms limit=" << effective_limit << "ms" << std::endl;
             }
         }
         return stop_search;
     }
 
+    s64 elapsed_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Print the root move being searched (only in long searches)
+    void report_currmove(int depth, Move32 move, int number) {
+        if (silent || depth <= report_after_depth || elapsed_ms() < InfoWriter::CURRMOVE_DELAY_MS) return;
+        info.format_currmove(depth, move, number);
+        info.write(out);
+    }
+
+    // Print the current PV with its score
+    void report_pv(int depth, int score, ScoreBound bound, const Move32* pv, int length) {
+        if (silent || depth <= report_after_depth) return;
+        info.format_pv(depth, seldepth, score, bound, nodes_searched, elapsed_ms(), tt.hashfull(), pv, length);
+        info.write(out);
+    }
+
+    bool is_excluded(Move32 move) const {
+        for (int i = 0; i < exclude_count; ++i) {
+            if (exclude[i].same_move(move)) return true;
+        }
+        return false;
+    }
+
     void update_killer(int ply, Move32 move) {
         if (move.is_capture()) return;
         if (killers[ply][0].same_move(move)) return;
@@ -362,6 +424,29 @@ static bool is_repetition(const SearchContext& ctx) {
     return false;
 }
 
+// Append a record to the search-tree log (compiles away unless built with CACHEMISS_TREE_LOG)
+static inline void tree_log(const SearchContext& ctx, TreeLogKind kind, u32 node_id, int depth, int ply,
+                            int alpha, int beta, int score, Move32 move, int move_index,
+                            int reduction = 0, u8 flags = 0, TreeNodeType node_type = NODE_PV) {
+    if constexpr (TREE_LOG_ENABLED) {
+        TreeLogRecord record{};
+        record.hash = ctx.board.hash;
+        record.node_id = node_id;
+        record.move = move.data;
+        record.alpha = static_cast<s16>(std::clamp(alpha, -INFINITY_SCORE, INFINITY_SCORE));
+        record.beta = static_cast<s16>(std::clamp(beta, -INFINITY_SCORE, INFINITY_SCORE));
+        record.score = static_cast<s16>(std::clamp(score, -INFINITY_SCORE, INFINITY_SCORE));
+        record.depth = static_cast<u8>(std::clamp(depth, 0, 255));
+        record.ply = static_cast<u8>(ply);
+        record.kind = kind;
+        record.node_type = node_type;
+        record.move_index = static_cast<u8>(std::min(move_index, 255));
+        record.reduction = static_cast<s8>(reduction);
+        record.flags = flags;
+        g_tree_log.write(record);
+    }
+}
+
 // Forward declarations
 static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int ply, bool is_pv_node, bool can_null = true);
 
@@ -369,6 +454,7 @@ static int quiescence(SearchContext& ctx, int alpha, int beta, int ply) {
     if (ctx.check_time()) return 0;
 
     ctx.nodes_searched++;
+    if (ply > ctx.seldepth) ctx.seldepth = ply;
 
     bool in_chk = in_check(ctx.board);
 
@@ -464,6 +550,7 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
     if (ctx.check_time()) return 0;
 
     ctx.nodes_searched++;
+    if (ply > ctx.seldepth) ctx.seldepth = ply;
     ctx.init_pv(ply);
 
     const bool is_root = (ply == 0);
@@ -497,6 +584,11 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
     // Compute in_check once for NMP, checkmate detection, and check extension
     bool in_chk = in_check(ctx.board);
 
+    // Search-tree log bookkeeping (unused unless built with CACHEMISS_TREE_LOG)
+    u32 tree_node_id = 0;
+    if constexpr (TREE_LOG_ENABLED) tree_node_id = g_tree_log.next_node_id();
+    const int tree_alpha = alpha;
+
     // Check extension: extend search by 1 ply when in check (not at root)
     int extension = (!is_root && in_chk) ? 1 : 0;
     int new_depth = depth - 1 + extension;
@@ -525,6 +617,9 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
 
             if (ctx.stop_search) return 0;
 
+            tree_log(ctx, TREE_MOVE, tree_node_id, depth, ply, tree_alpha, beta, null_score,
+                     Move32(0), 0, R, TREE_NULL_MOVE);
+
             // Don't trust NMP if score is mate-related (could miss forced mates)
             // Also don't trust if score is near draw
             if (null_score >= beta && null_score < MATE_SCORE - MAX_PLY &&
@@ -536,16 +631,24 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
 
     int best_score = -INFINITY_SCORE;
     Move32 best_move(0);
+    int best_index = 0;
     int moves_searched = 0;
     bool found_pv = false;
 
     // At root, also consider prev_best_move for move ordering
+    // A root searched without some of its moves mustn't leave its result in the TT
+    const bool store_tt = !(is_root && ctx.exclude_count > 0);
+
     MovePicker picker(ctx, ply, tt_move, is_root ? ctx.prev_best_move : Move32(0));
     while (Move32 move = picker.next()) {
+        if (is_root && ctx.is_excluded(move)) continue;
+
         // SEE pruning: at shallow depths, skip captures that lose significant material
         // Don't prune: at root, when in check, promotions (too valuable)
         if (!is_root && depth <= 2 && !in_chk && move.is_capture() && !move.is_promotion()) {
-            if (!see_ge(ctx.board, move, -100)) {  // Losing more than a pawn
+            if (!see_ge(ctx.board, move, -SEE_PRUNE_MARGIN)) {  // Losing more than a pawn
+                tree_log(ctx, TREE_MOVE, tree_node_id, depth, ply, tree_alpha, beta, 0,
+                         move, 0, 0, TREE_SEE_PRUNED);
                 continue;
             }
         }
@@ -560,6 +663,7 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
         }
 
         moves_searched++;
+        if (is_root) ctx.report_currmove(depth, move, moves_searched);
 
         // Determine if this move is a candidate for LMR
         bool is_quiet = !move.is_capture() && !move.is_promotion();
@@ -583,6 +687,8 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
                        && !gives_check;
 
         int score;
+        int applied_reduction = 0;
+        u8 research_flags = 0;
 
         if (can_reduce) {
             // Calculate reduction from LMR table
@@ -596,23 +702,27 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
 
             // Ensure we don't reduce below minimum
             int reduced_depth = std::max(LMR_MIN_REDUCED_DEPTH, new_depth - R);
+            applied_reduction = new_depth - reduced_depth;
 
             // Search with reduced depth
             score = -alpha_beta(ctx, reduced_depth, -alpha - 1, -alpha, ply + 1, false);
 
             // Re-search at full depth if it beats alpha
             if (score > alpha && R > 0 && !ctx.stop_search) {
+                research_flags |= TREE_RESEARCH_DEPTH;
                 score = -alpha_beta(ctx, new_depth, -alpha - 1, -alpha, ply + 1, false);
             }
 
             // Full PV re-search if still beats alpha in PV node
             if (score > alpha && score < beta && is_pv_node && !ctx.stop_search) {
+                research_flags |= TREE_RESEARCH_WINDOW;
                 score = -alpha_beta(ctx, new_depth, -beta, -alpha, ply + 1, true);
             }
         } else if (found_pv) {
             // Standard PVS for non-reduced moves after PV is found
             score = -alpha_beta(ctx, new_depth, -alpha - 1, -alpha, ply + 1, false);
             if (score > alpha && score < beta && !ctx.stop_search) {
+                research_flags |= TREE_RESEARCH_WINDOW;
                 score = -alpha_beta(ctx, new_depth, -beta, -alpha, ply + 1, true);
             }
         } else {
@@ -638,15 +748,21 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
             return is_root ? best_score : 0;
         }
 
+        tree_log(ctx, TREE_MOVE, tree_node_id, depth, ply, tree_alpha, beta, score,
+                 move, moves_searched, applied_reduction, research_flags);
+
         if (score > best_score) {
             best_score = score;
             best_move = move;
+            best_index = moves_searched;
         }
 
         if (score >= beta) {
             ctx.update_killer(ply, move);
             ctx.update_history(ctx.board.turn, move, depth);
-            ctx.tt.store(ctx.board.hash, depth, ply, beta, TT_LOWER, move);
+            if (store_tt) ctx.tt.store(ctx.board.hash, depth, ply, beta, TT_LOWER, move);
+            tree_log(ctx, TREE_NODE, tree_node_id, depth, ply, tree_alpha, beta, beta,
+                     move, moves_searched, 0, 0, NODE_CUT);
             return beta;
         }
 
@@ -662,14 +778,24 @@ static int alpha_beta(SearchContext& ctx, int depth, int alpha, int beta, int pl
     }
 
     TTFlag flag = found_pv ? TT_EXACT : TT_UPPER;
-    ctx.tt.store(ctx.board.hash, depth, ply, best_score, flag, best_move);
+    if (store_tt) ctx.tt.store(ctx.board.hash, depth, ply, best_score, flag, best_move);
+    tree_log(ctx, TREE_NODE, tree_node_id, depth, ply, tree_alpha, beta, best_score,
+             best_move, best_index, 0, 0, found_pv ? NODE_PV : NODE_ALL);
 
     return best_score;
 }
 
-SearchResult search(Board& board, TTable& tt, int time_limit_ms, int depth_limit,
+SearchResult search(Board& board, TTable& tt, const SearchLimits& limits,
                     const u64* hash_history, int hash_history_len) {
-    SearchContext ctx(board, tt, time_limit_ms, hash_history, hash_history_len);
+    if constexpr (SEARCH_TUNING_ENABLED) {
+        refresh_search_tables();  // First search on this thread, or parameters set elsewhere
+    }
+    SearchContext ctx(board, tt, limits.time_ms, limits.nodes, hash_history, hash_history_len, limits.silent,
+                      limits.abort, limits.controller ? *limits.controller : g_search_controller,
+                      limits.out ? *limits.out : std::cout);
+    ctx.exclude = limits.exclude;
+    ctx.exclude_count = limits.exclude_count;
+    ctx.report_after_depth = limits.report_after_depth;
 
     SearchResult result;
     result.best_move = Move32(0);
@@ -677,8 +803,9 @@ SearchResult search(Board& board, TTable& tt, int time_limit_ms, int depth_limit
     result.depth = 0;
     result.pv_length = 0;
 
-    int max_depth = (depth_limit > 0) ? depth_limit : MAX_PLY;
+    int max_depth = (limits.depth > 0) ? limits.depth : MAX_PLY;
     for (int depth = 1; depth <= max_depth; ++depth) {
+        trace::Span iteration_span("iteration", {"depth", depth});
         int alpha, beta, delta;
 
         // Aspiration windows: use narrow window around previous score after depth 1
@@ -697,12 +824,22 @@ SearchResult search(Board& board, TTable& tt, int time_limit_ms, int depth_limit
         // Aspiration window loop: widen on fail-low or fail-high
         while (true) {
             // Call alpha_beta with ply=0 for root search
-            score = alpha_beta(ctx, depth, alpha, beta, 0, true);
+            {
+                trace::Span aspiration_span("aspiration", {"alpha", alpha}, {"beta", beta});
+                score = alpha_beta(ctx, depth, alpha, beta, 0, true);
+            }
 
             if (ctx.stop_search) break;
 
+            // Report the failed window in long searches so the GUI sees progress
+            if ((score <= alpha || score >= beta) && ctx.elapsed_ms() >= InfoWriter::BOUND_DELAY_MS) {
+                ctx.report_pv(depth, score, score <= alpha ? ScoreBound::Upper : ScoreBound::Lower,
+                              ctx.pv_table[0], ctx.pv_length[0]);
+            }
+
             // Fail low: widen alpha
             if (score <= alpha) {
+                result.fail_lows++;
                 alpha = std::max(-INFINITY_SCORE, alpha - delta);
                 delta *= 2;
                 continue;
@@ -710,6 +847,7 @@ SearchResult search(Board& board, TTable& tt, int time_limit_ms, int depth_limit
 
             // Fail high: widen beta
             if (score >= beta) {
+                result.fail_highs++;
                 beta = std::min(INFINITY_SCORE, beta + delta);
                 delta *= 2;
                 continue;
@@ -745,28 +883,29 @@ SearchResult search(Board& board, TTable& tt, int time_limit_ms, int depth_limit
             result.pv[i] = ctx.pv_table[0][i];
         }
 
-        // Save best move for next iteration's move ordering
-        ctx.prev_best_move = move;
-
         // Print UCI info
         auto now = std::chrono::steady_clock::now();
         auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - ctx.start_time).count();
 
-        std::cout << "info depth " << depth
-                  << " score cp " << score
-                  << " nodes " << ctx.nodes_searched
-                  << " time " << elapsed_ms
-                  << " pv";
-
-        for (int i = 0; i < result.pv_length; ++i) {
-            std::cout << " " << result.pv[i].to_uci();
+        // Record iteration outcome for telemetry
+        if (depth > 1 && !move.same_move(ctx.prev_best_move)) {
+            result.best_move_changes++;
         }
-        std::cout << std::endl;
+        result.iterations[depth - 1] = {move, score, static_cast<int>(elapsed_ms)};
+
+        // Save best move for next iteration's move ordering
+        ctx.prev_best_move = move;
+
+        ctx.report_pv(depth, score, ScoreBound::Exact, result.pv, result.pv_length);
 
         if (score >= MATE_SCORE - MAX_PLY || score <= -MATE_SCORE + MAX_PLY) {
             break;
         }
     }
 
+    result.nodes = ctx.nodes_searched;
+    result.seldepth = ctx.seldepth;
+    result.elapsed_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - ctx.start_time).count());
     return result;
 }
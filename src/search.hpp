@@ -4,9 +4,24 @@
 #include "move.hpp"
 #include "ttable.hpp"
 #include <atomic>
+#include <iosfwd>
 
 constexpr int MAX_PLY = 64;
 
+// Mate in n plies from the root scores MATE_SCORE - n (negated when the side
+// to move is the one mated); anything within MAX_PLY of it is a mate score
+constexpr int MATE_SCORE = 29000;
+
+constexpr bool is_mate_score(int score) {
+    return score >= MATE_SCORE - MAX_PLY || score <= -MATE_SCORE + MAX_PLY;
+}
+
+// Full moves to mate for a mate score, as UCI "score mate" reports it:
+// positive when the side to move mates, negative when it gets mated
+constexpr int mate_in_moves(int score) {
+    return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+}
+
 // ============================================================================
 // SearchController - encapsulates search control state for thread-safe access
 // ============================================================================
@@ -51,16 +66,51 @@ private:
 // Global search controller instance - used by UCI and search threads
 extern SearchController g_search_controller;
 
+// Outcome of one completed iterative-deepening iteration
+struct IterationInfo {
+    Move32 best_move;
+    int score;
+    int time_ms;            // Elapsed time when the iteration completed
+};
+
 struct SearchResult {
     Move32 best_move;
     int score;
     int depth;
     Move32 pv[MAX_PLY];    // Principal variation line
     int pv_length = 0;      // Number of moves in PV
+
+    // Statistics (for telemetry and UCI info output)
+    u64 nodes = 0;
+    int seldepth = 0;           // Deepest ply reached (including quiescence)
+    int elapsed_ms = 0;
+    int fail_lows = 0;          // Aspiration window fail-lows (all iterations)
+    int fail_highs = 0;         // Aspiration window fail-highs (all iterations)
+    int best_move_changes = 0;  // Iterations whose best move differs from the previous one
+    IterationInfo iterations[MAX_PLY];  // iterations[d - 1] = result of depth d
+};
+
+// Limits for one search; whichever is reached first stops it
+struct SearchLimits {
+    int time_ms = 10000;
+    int depth = 0;          // 0 = unlimited
+    u64 nodes = 0;          // 0 = unlimited (checked every node, so node-limited searches are reproducible)
+    bool silent = false;    // No info output (searches driven in-process, e.g. by tools/match)
+    const std::atomic<bool>* abort = nullptr;  // Also stop once this is set (e.g. ponderhit on another candidate)
+    SearchController* controller = nullptr;    // Stop/ponderhit source (null: g_search_controller)
+    std::ostream* out = nullptr;               // Where info lines go (null: std::cout)
+    const Move32* exclude = nullptr;           // Root moves not to search (MultiPV lines after the first)
+    int exclude_count = 0;
+    int report_after_depth = 0;  // Info lines only for deeper iterations (a search that continues another)
 };
 
 // Search for the best move with iterative deepening.
-// Stops after time_limit_ms milliseconds or depth_limit (0 = unlimited).
 // hash_history/hash_history_len: prior position hashes for repetition detection.
-SearchResult search(Board& board, TTable& tt, int time_limit_ms = 10000, int depth_limit = 0,
+SearchResult search(Board& board, TTable& tt, const SearchLimits& limits,
                     const u64* hash_history = nullptr, int hash_history_len = 0);
+
+// Stops after time_limit_ms milliseconds or depth_limit (0 = unlimited).
+inline SearchResult search(Board& board, TTable& tt, int time_limit_ms = 10000, int depth_limit = 0,
+                           const u64* hash_history = nullptr, int hash_history_len = 0) {
+    return search(board, tt, SearchLimits{time_limit_ms, depth_limit, 0}, hash_history, hash_history_len);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+// ============================================================================
+// Search parameter registry
+// ============================================================================
+// Every tunable search constant is listed once below as
+//   X(name, default, min, max)
+// Release builds turn each entry into a constexpr int, so the search compiles
+// exactly as with hand-written constants. Tuning builds (-DCACHEMISS_TUNE=ON)
+// turn them into variables and expose them as UCI spin options named after
+// the parameter, which tools/match -spsa drives. Tuning builds keep the values
+// per thread so independent searches can run different settings side by side
+// (tools/match -inprocess); a thread that searches on behalf of another copies
+// them over with get_search_params/set_search_params.
+//
+// LMR reductions come from R = LMR_BASE/100 + ln(depth) * ln(moves) / (LMR_DIVISOR/100);
+// changing either rebuilds the table (see refresh_search_tables).
+
+#define SEARCH_PARAMS(X)                       \
+    X(ASPIRATION_WINDOW,        50,   10,  200) \
+    X(NMP_MIN_DEPTH,             3,    1,    8) \
+    X(NMP_HIGH_DEPTH,            6,    2,   12) \
+    X(NMP_REDUCTION_LOW,         2,    1,    5) \
+    X(NMP_REDUCTION_HIGH,        3,    1,    6) \
+    X(NMP_DRAW_THRESHOLD,       50,    0,  200) \
+    X(LMR_MIN_MOVES,             4,    1,   12) \
+    X(LMR_MIN_DEPTH,             3,    1,    8) \
+    X(LMR_PV_REDUCTION,          1,    0,    3) \
+    X(LMR_MIN_REDUCED_DEPTH,     1,    1,    3) \
+    X(LMR_BASE,                 50,    0,  150) \
+    X(LMR_DIVISOR,             225,  100,  400) \
+    X(KILLER_SCORE_1,         9000, 6500, 9900) \
+    X(KILLER_SCORE_2,         8000, 6500, 9900) \
+    X(HISTORY_MAX,            6000, 1000, 6400) \
+    X(SEE_PRUNE_MARGIN,        100,    0,  400)
+
+#ifdef CACHEMISS_TUNE
+inline constexpr bool SEARCH_TUNING_ENABLED = true;
+#define SEARCH_PARAM_DECLARE(name, def, lo, hi) inline thread_local int name = def;
+#else
+inline constexpr bool SEARCH_TUNING_ENABLED = false;
+#define SEARCH_PARAM_DECLARE(name, def, lo, hi) inline constexpr int name = def;
+#endif
+
+namespace search_params {
+SEARCH_PARAMS(SEARCH_PARAM_DECLARE)
+}  // namespace search_params
+
+#undef SEARCH_PARAM_DECLARE
+
+// Print "option name <param> type spin ..." for every parameter (tuning builds only)
+inline void print_search_param_options(std::ostream& out) {
+    if constexpr (SEARCH_TUNING_ENABLED) {
+#define SEARCH_PARAM_OPTION(name, def, lo, hi) \
+        out << "option name " #name " type spin default " << def << " min " << lo << " max " << hi << '\n';
+        SEARCH_PARAMS(SEARCH_PARAM_OPTION)
+#undef SEARCH_PARAM_OPTION
+    }
+}
+
+// Set a parameter by name (tuning builds only). Out-of-range values are clamped.
+// Returns false if the name isn't a search parameter.
+inline bool set_search_param([[maybe_unused]] const std::string& name, [[maybe_unused]] int value) {
+#ifdef CACHEMISS_TUNE
+#define SEARCH_PARAM_SET(pname, def, lo, hi)                    \
+    if (name == #pname) {                                        \
+        search_params::pname = value < lo ? lo : value > hi ? hi : value; \
+        return true;                                             \
+    }
+    SEARCH_PARAMS(SEARCH_PARAM_SET)
+#undef SEARCH_PARAM_SET
+#endif
+    return false;
+}
+
+// Whether a name is a search parameter (always false in release builds)
+inline bool is_search_param([[maybe_unused]] const std::string& name) {
+#ifdef CACHEMISS_TUNE
+#define SEARCH_PARAM_IS(pname, def, lo, hi) \
+    if (name == #pname) return true;
+    SEARCH_PARAMS(SEARCH_PARAM_IS)
+#undef SEARCH_PARAM_IS
+#endif
+    return false;
+}
+
+// Snapshot of every parameter
+struct SearchParamValues {
+#define SEARCH_PARAM_FIELD(name, def, lo, hi) int name = def;
+    SEARCH_PARAMS(SEARCH_PARAM_FIELD)
+#undef SEARCH_PARAM_FIELD
+};
+
+// Values in effect on the calling thread (the defaults in release builds)
+inline SearchParamValues get_search_params() {
+    SearchParamValues values;
+#ifdef CACHEMISS_TUNE
+#define SEARCH_PARAM_GET(name, def, lo, hi) values.name = search_params::name;
+    SEARCH_PARAMS(SEARCH_PARAM_GET)
+#undef SEARCH_PARAM_GET
+#endif
+    return values;
+}
+
+// Install values on the calling thread (tuning builds only; no-op otherwise)
+inline void set_search_params([[maybe_unused]] const SearchParamValues& values) {
+#ifdef CACHEMISS_TUNE
+#define SEARCH_PARAM_PUT(name, def, lo, hi) search_params::name = values.name;
+    SEARCH_PARAMS(SEARCH_PARAM_PUT)
+#undef SEARCH_PARAM_PUT
+#endif
+}
+
+// Recompute tables derived from parameters (LMR) on the calling thread if the
+// parameters they depend on changed; call after set_search_param(s)
+void refresh_search_tables();
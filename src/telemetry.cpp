@@ -0,0 +1,98 @@
+#include "telemetry.hpp"
+#include <chrono>
+
+TelemetryLog g_telemetry;
+
+static const char* ponder_outcome_name(PonderOutcome outcome) {
+    switch (outcome) {
+        case PonderOutcome::Hit:  return "hit";
+        case PonderOutcome::Miss: return "miss";
+        default:                  return nullptr;
+    }
+}
+
+bool TelemetryLog::open(const std::string& path) {
+    close();
+    if (path.empty() || path == "<empty>") {
+        return true;
+    }
+
+    file = std::fopen(path.c_str(), "a");
+    if (!file) {
+        return false;
+    }
+    stopping = false;
+    writer = std::thread(&TelemetryLog::writer_loop, this);
+    return true;
+}
+
+void TelemetryLog::close() {
+    if (!file) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void TelemetryLog::log(TelemetryRecord record) {
+    if (!file) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(std::move(record));
+    }
+    cv.notify_one();
+}
+
+void TelemetryLog::writer_loop() {
+    std::deque<TelemetryRecord> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty() && stopping) return;
+            batch.swap(queue);
+        }
+        for (const auto& record : batch) {
+            write_record(record);
+        }
+        batch.clear();
+        std::fflush(file);
+    }
+}
+
+void TelemetryLog::write_record(const TelemetryRecord& record) {
+    const SearchResult& r = record.result;
+    auto now = std::chrono::system_clock::now();
+    long long timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count();
+    u64 nps = r.elapsed_ms > 0 ? r.nodes * 1000 / static_cast<u64>(r.elapsed_ms) : 0;
+    double tt_hit_rate = record.tt_probes > 0 ? static_cast<double>(record.tt_hits) / record.tt_probes : 0.0;
+
+    std::fprintf(file, "{\"ts\":%lld", timestamp_ms);
+    if (record.session > 0) std::fprintf(file, ",\"session\":%d", record.session);
+    std::fprintf(file, ",\"fen\":\"%s\",\"moves_played\":%d,\"ponder\":%s",
+                 record.fen.c_str(), record.moves_played, record.ponder ? "true" : "false");
+    if (const char* outcome = ponder_outcome_name(record.ponder_outcome)) {
+        std::fprintf(file, ",\"ponder_outcome\":\"%s\"", outcome);
+    }
+    std::fprintf(file, ",\"time_allocated_ms\":%d,\"time_used_ms\":%d,\"search_ms\":%d",
+                 record.time_allocated_ms, record.time_used_ms, r.elapsed_ms);
+    std::fprintf(file, ",\"bestmove\":\"%s\",\"score\":%d,\"depth\":%d,\"seldepth\":%d",
+                 r.best_move.to_uci().c_str(), r.score, r.depth, r.seldepth);
+    std::fprintf(file, ",\"nodes\":%llu,\"nps\":%llu,\"tt_hit_rate\":%.4f,\"hashfull\":%d",
+                 (unsigned long long)r.nodes, (unsigned long long)nps, tt_hit_rate, record.hashfull);
+    std::fprintf(file, ",\"fail_lows\":%d,\"fail_highs\":%d,\"best_move_changes\":%d",
+                 r.fail_lows, r.fail_highs, r.best_move_changes);
+
+    std::fputs(",\"iterations\":[", file);
+    for (int d = 0; d < r.depth; ++d) {
+        const IterationInfo& it = r.iterations[d];
+        std::fprintf(file, "%s{\"depth\":%d,\"move\":\"%s\",\"score\":%d,\"time_ms\":%d}",
+                     d > 0 ? "," : "", d + 1, it.best_move.to_uci().c_str(), it.score, it.time_ms);
+    }
+    std::fputs("]}\n", file);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "search.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// Per-move search telemetry (JSONL)
+// ============================================================================
+// One record per "go", queued by the UCI thread and formatted/written by a
+// background thread so logging never delays bestmove output. The engine
+// server opens the log once from its command line (sessions can't change
+// it) and tags each record with its session.
+
+enum class PonderOutcome { None, Hit, Miss };
+
+struct TelemetryRecord {
+    int session = 0;             // Engine server session; 0 = stand-alone engine
+    std::string fen;
+    int moves_played = 0;
+    bool ponder = false;
+    PonderOutcome ponder_outcome = PonderOutcome::None;
+    int time_allocated_ms = 0;   // Time the time manager gave this move
+    int time_used_ms = 0;        // Wall time from "go" to "bestmove"
+    u64 tt_hits = 0;
+    u64 tt_probes = 0;
+    int hashfull = 0;            // Permille, sampled after the search
+    SearchResult result;
+};
+
+class TelemetryLog {
+    std::thread writer;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<TelemetryRecord> queue;
+    FILE* file = nullptr;
+    bool stopping = false;
+
+    void writer_loop();
+    void write_record(const TelemetryRecord& record);
+
+public:
+    ~TelemetryLog() { close(); }
+
+    // Open (append) the log and start the writer thread.
+    // An empty path or "<empty>" just closes the current log.
+    bool open(const std::string& path);
+
+    // Drain the queue and stop the writer thread
+    void close();
+
+    bool is_open() const { return file != nullptr; }
+
+    // Queue a record (no-op if the log is closed)
+    void log(TelemetryRecord record);
+};
+
+extern TelemetryLog g_telemetry;
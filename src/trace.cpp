@@ -0,0 +1,212 @@
+#include "trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+// Events per thread buffer (~1 MB); further events are counted and dropped
+constexpr size_t BUFFER_EVENTS = 16384;
+
+struct Event {
+    const char* name;
+    u64 ts;
+    u64 dur;
+    Arg args[2];
+    char phase;  // 'X' = complete span, 'i' = instant
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{new Event[BUFFER_EVENTS]};
+    std::atomic<size_t> count{0};
+    u64 dropped = 0;
+    int tid = 0;
+    const char* thread_name = nullptr;
+    bool name_written = false;
+    std::atomic<bool> in_use{true};
+};
+
+// Guards the buffer registry and the output file (never taken while recording)
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+FILE* out = nullptr;
+bool first_event = true;
+
+const auto epoch = std::chrono::steady_clock::now();
+
+// Releases the thread's buffer on thread exit. Pending events stay in the
+// buffer until the next flush(); only then can another thread reuse it.
+struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadSlot() {
+        if (buffer) buffer->in_use.store(false, std::memory_order_release);
+    }
+};
+thread_local ThreadSlot slot;
+
+ThreadBuffer* acquire_buffer() {
+    if (slot.buffer) return slot.buffer;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& buf : buffers) {
+        if (!buf->in_use.load(std::memory_order_acquire) &&
+            buf->count.load(std::memory_order_relaxed) == 0) {
+            buf->in_use.store(true, std::memory_order_relaxed);
+            buf->thread_name = nullptr;
+            buf->name_written = false;
+            slot.buffer = buf.get();
+            return slot.buffer;
+        }
+    }
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    buffers.back()->tid = static_cast<int>(buffers.size());
+    slot.buffer = buffers.back().get();
+    return slot.buffer;
+}
+
+void record(const Event& event) {
+    ThreadBuffer* buf = acquire_buffer();
+    size_t n = buf->count.load(std::memory_order_relaxed);
+    if (n >= BUFFER_EVENTS) {
+        buf->dropped++;
+        return;
+    }
+    buf->events[n] = event;
+    buf->count.store(n + 1, std::memory_order_release);
+}
+
+void write_separator() {
+    if (!first_event) std::fputs(",\n", out);
+    first_event = false;
+}
+
+void write_args(const Arg* args) {
+    if (!args[0].key && !args[1].key) return;
+    std::fputs(",\"args\":{", out);
+    bool first = true;
+    for (int i = 0; i < 2; ++i) {
+        if (!args[i].key) continue;
+        std::fprintf(out, "%s\"%s\":%lld", first ? "" : ",", args[i].key, (long long)args[i].value);
+        first = false;
+    }
+    std::fputc('}', out);
+}
+
+// Write and reset all buffers. Caller holds registry_mutex.
+void flush_locked() {
+    for (auto& buf : buffers) {
+        size_t n = buf->count.load(std::memory_order_acquire);
+        if (out) {
+            if (buf->thread_name && !buf->name_written) {
+                write_separator();
+                std::fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                                  "\"args\":{\"name\":\"%s\"}}", buf->tid, buf->thread_name);
+                buf->name_written = true;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                const Event& e = buf->events[i];
+                write_separator();
+                std::fprintf(out, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%d",
+                             e.name, e.phase, (unsigned long long)e.ts, buf->tid);
+                if (e.phase == 'X') {
+                    std::fprintf(out, ",\"dur\":%llu", (unsigned long long)e.dur);
+                } else {
+                    std::fputs(",\"s\":\"t\"", out);
+                }
+                write_args(e.args);
+                std::fputc('}', out);
+            }
+            if (buf->dropped > 0) {
+                write_separator();
+                std::fprintf(out, "{\"name\":\"trace buffer full\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,"
+                                  "\"pid\":1,\"tid\":%d,\"args\":{\"dropped\":%llu}}",
+                             (unsigned long long)now_us(), buf->tid, (unsigned long long)buf->dropped);
+            }
+        }
+        buf->dropped = 0;
+        buf->count.store(0, std::memory_order_release);
+    }
+    if (out) std::fflush(out);
+}
+
+void close_locked() {
+    if (out) {
+        flush_locked();
+        std::fputs("\n]\n", out);
+        std::fclose(out);
+        out = nullptr;
+    }
+    g_enabled.store(false, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+u64 now_us() {
+    auto elapsed = std::chrono::steady_clock::now() - epoch;
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+bool open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    close_locked();
+    if (path.empty() || path == "<empty>") {
+        return true;
+    }
+
+    out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    std::fputs("[\n", out);
+    first_event = true;
+
+    // Discard anything recorded before this file was opened
+    for (auto& buf : buffers) {
+        buf->count.store(0, std::memory_order_relaxed);
+        buf->dropped = 0;
+        buf->name_written = false;
+    }
+    g_enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void close() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    close_locked();
+}
+
+void set_thread_name(const char* name) {
+    if (!enabled()) return;
+    ThreadBuffer* buf = acquire_buffer();
+    if (buf->thread_name != name) {
+        buf->thread_name = name;
+        buf->name_written = false;
+    }
+}
+
+void complete(const char* name, u64 start_us, Arg a, Arg b) {
+    if (!enabled()) return;
+    u64 end = now_us();
+    record({name, start_us, end - start_us, {a, b}, 'X'});
+}
+
+void instant(const char* name, Arg a, Arg b) {
+    if (!enabled()) return;
+    record({name, now_us(), 0, {a, b}, 'i'});
+}
+
+void instant_at(const char* name, u64 ts_us, Arg a, Arg b) {
+    if (!enabled()) return;
+    record({name, ts_us, 0, {a, b}, 'i'});
+}
+
+void flush() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    flush_locked();
+}
+
+}  // namespace trace
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "cachemiss.hpp"
+#include <atomic>
+#include <string>
+
+// ============================================================================
+// Chrome trace-event timeline export
+// ============================================================================
+// Records spans and instant events in the Chrome trace-event JSON format
+// (load the file in chrome://tracing or https://ui.perfetto.dev).
+//
+// Each thread appends to its own fixed-size buffer without locking, so
+// recording costs a clock read and a few stores. flush() writes all buffers
+// to the trace file; it must only be called while no other thread is
+// recording (e.g. after the search thread has been joined).
+
+namespace trace {
+
+// Global on/off switch - checked inline before any recording work
+inline std::atomic<bool> g_enabled{false};
+
+inline bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+// Open (truncate) the trace file and start recording.
+// An empty path or "<empty>" stops tracing. Returns false if the file can't be opened.
+bool open(const std::string& path);
+
+// Flush pending events, terminate the JSON array and close the file
+void close();
+
+// Microseconds since the trace epoch (process start)
+u64 now_us();
+
+// Name the calling thread in the timeline (e.g. "uci", "search")
+void set_thread_name(const char* name);
+
+// Optional integer argument attached to an event
+struct Arg {
+    const char* key = nullptr;
+    s64 value = 0;
+};
+
+// Record a complete span that started at start_us and ends now.
+// name and arg keys must be string literals (only the pointer is stored).
+void complete(const char* name, u64 start_us, Arg a = {}, Arg b = {});
+
+// Record an instant event
+void instant(const char* name, Arg a = {}, Arg b = {});
+
+// Record an instant event that happened at ts_us (a now_us() value taken
+// earlier, e.g. by another thread that must not record itself)
+void instant_at(const char* name, u64 ts_us, Arg a = {}, Arg b = {});
+
+// Write all buffered events to the trace file and reset the buffers
+void flush();
+
+// RAII span: records [construction, destruction) when tracing is enabled
+class Span {
+    const char* name;
+    u64 start;
+    Arg a, b;
+
+public:
+    explicit Span(const char* span_name, Arg arg_a = {}, Arg arg_b = {})
+        : name(enabled() ? span_name : nullptr), start(name ? now_us() : 0), a(arg_a), b(arg_b) {}
+
+    ~Span() {
+        if (name) complete(name, start, a, b);
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+};
+
+}  // namespace trace
@@ -0,0 +1,34 @@
+#include "tree_log.hpp"
+#include <cstring>
+
+TreeLogWriter g_tree_log;
+
+bool TreeLogWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    TreeLogHeader header;
+    std::memcpy(header.magic, TREE_LOG_MAGIC, sizeof(header.magic));
+    header.record_size = sizeof(TreeLogRecord);
+    header.reserved = 0;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    if (!buffer) buffer.reset(new TreeLogRecord[BUFFER_RECORDS]);
+    count = 0;
+    node_counter = 0;
+    return true;
+}
+
+void TreeLogWriter::flush() {
+    if (!file || count == 0) return;
+    std::fwrite(buffer.get(), sizeof(TreeLogRecord), count, file);
+    count = 0;
+}
+
+void TreeLogWriter::close() {
+    if (!file) return;
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
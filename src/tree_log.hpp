@@ -0,0 +1,90 @@
+#pragma once
+
+#include "cachemiss.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// ============================================================================
+// Binary search-tree log for offline pruning analysis
+// ============================================================================
+// Built only with -DCACHEMISS_TREE_LOG=ON; otherwise every hook in the search
+// compiles away. The file is a TreeLogHeader followed by fixed-size
+// TreeLogRecords in native byte order. Analyse with tools/tree_stats.
+
+#ifdef CACHEMISS_TREE_LOG
+inline constexpr bool TREE_LOG_ENABLED = true;
+#else
+inline constexpr bool TREE_LOG_ENABLED = false;
+#endif
+
+enum TreeLogKind : u8 {
+    TREE_MOVE = 0,  // A child searched from a node (or a null move / pruned move)
+    TREE_NODE = 1,  // A node finished its move loop; written after all its children
+};
+
+enum TreeNodeType : u8 { NODE_PV = 0, NODE_CUT = 1, NODE_ALL = 2 };
+
+// Flags for TreeLogRecord::flags
+enum TreeLogFlag : u8 {
+    TREE_RESEARCH_DEPTH  = 1 << 0,  // Reduced move re-searched at full depth
+    TREE_RESEARCH_WINDOW = 1 << 1,  // Re-searched with the full (alpha, beta) window
+    TREE_NULL_MOVE       = 1 << 2,  // Null-move search; reduction holds R
+    TREE_SEE_PRUNED      = 1 << 3,  // Capture skipped by SEE pruning (not searched)
+};
+
+struct TreeLogHeader {
+    char magic[8];     // "CMTREE1\0"
+    u32 record_size;   // sizeof(TreeLogRecord)
+    u32 reserved;
+};
+
+struct TreeLogRecord {
+    u64 hash;          // Position hash of the node
+    u32 node_id;       // Sequential id of the node; move records carry their parent's id
+    u32 move;          // TREE_MOVE: move searched; TREE_NODE: best move (0 if none)
+    s16 alpha;         // Window on entry to the node
+    s16 beta;
+    s16 score;         // TREE_MOVE: score of the child; TREE_NODE: final score
+    u8 depth;
+    u8 ply;
+    u8 kind;           // TreeLogKind
+    u8 node_type;      // TREE_NODE: TreeNodeType
+    u8 move_index;     // TREE_MOVE: 1-based index of the move; TREE_NODE: index of best move
+    s8 reduction;      // LMR reduction (or null-move R) applied
+    u8 flags;          // TreeLogFlag bits
+    u8 _padding[3];
+};
+static_assert(sizeof(TreeLogRecord) == 32, "TreeLogRecord must be 32 bytes");
+
+constexpr char TREE_LOG_MAGIC[8] = {'C', 'M', 'T', 'R', 'E', 'E', '1', '\0'};
+
+// Buffered writer: records are collected in a large buffer and written with
+// one fwrite per BUFFER_RECORDS records.
+class TreeLogWriter {
+    FILE* file = nullptr;
+    std::unique_ptr<TreeLogRecord[]> buffer;
+    size_t count = 0;
+    u32 node_counter = 0;
+
+public:
+    static constexpr size_t BUFFER_RECORDS = 1 << 16;  // 2 MB
+
+    ~TreeLogWriter() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    void flush();
+    bool is_open() const { return file != nullptr; }
+
+    u32 next_node_id() { return node_counter++; }
+
+    void write(const TreeLogRecord& record) {
+        if (!file) return;
+        buffer[count++] = record;
+        if (count == BUFFER_RECORDS) flush();
+    }
+};
+
+// Global tree log (the search is single-threaded)
+extern TreeLogWriter g_tree_log;
@@ -1,19 +1,63 @@
 #include "ttable.hpp"
+#include "search.hpp"  // MATE_SCORE, MAX_PLY for ply adjustment
+#include <algorithm>
 #include <bit>
+#include <new>
+#include <cstring>
+#include <thread>
+#include <vector>
 
-// Mate score constants for ply adjustment
-// These must match the values in search.cpp
-constexpr int MATE_SCORE = 29000;
-constexpr int MAX_PLY = 64;
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 TTable::TTable(size_t mb) {
+    resize(mb);
+    clear();
+}
+
+void TTable::resize(size_t mb) {
     size_t bytes = mb * 1024 * 1024;
     size_t count = bytes / sizeof(TTEntry);
     // Round down to power of 2
     count = size_t(1) << (63 - std::countl_zero(count));
+
+    // Free the old table first so peak memory doesn't hold both
+    table.reset();
+
+    // Align to 2 MB so the table can be backed by transparent huge pages
+    constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+    size_t alloc_bytes = std::max(count * sizeof(TTEntry), HUGE_PAGE);
+    void* mem = std::aligned_alloc(HUGE_PAGE, alloc_bytes);
+    if (!mem) throw std::bad_alloc();
+#ifdef __linux__
+    madvise(mem, alloc_bytes, MADV_HUGEPAGE);
+#endif
+    table.reset(static_cast<TTEntry*>(mem));
+    entry_count = count;
     mask = count - 1;
-    table.resize(count);
-    clear();
+}
+
+void TTable::rescale(size_t mb) {
+    TTable next;
+    next.resize(mb);
+    if (next.entry_count <= entry_count) {
+        std::memcpy(static_cast<void*>(next.table.get()), table.get(), next.entry_count * sizeof(TTEntry));
+        for (size_t i = next.entry_count; i < entry_count; ++i) {
+            TTEntry& slot = next.table[i & next.mask];
+            if (table[i].depth > slot.depth) slot = table[i];
+        }
+    } else {
+        // The index bits that decide between the new slots aren't stored, so
+        // every candidate slot gets a copy; a copy in the wrong slot is no
+        // more likely to match than a hash collision
+        for (size_t i = 0; i < next.entry_count; ++i) {
+            next.table[i] = table[i & mask];
+        }
+    }
+    table = std::move(next.table);
+    entry_count = next.entry_count;
+    mask = next.mask;
 }
 
 bool TTable::probe(u64 hash, int depth, int ply, int alpha, int beta, int& score, Move32& best_move) {
@@ -112,8 +156,29 @@ void TTable::store(u64 hash, int depth, int ply, int score, TTFlag flag, Move32
     entry.best_move = best_move;
 }
 
-void TTable::clear() {
-    std::fill(table.begin(), table.end(), TTEntry{0, 0, 0, 0, Move32(0), 0});
+void TTable::clear(int threads) {
+    // Below 64 MB per thread the thread start-up costs more than it saves
+    constexpr size_t MIN_BYTES_PER_THREAD = 64 * 1024 * 1024;
+    size_t bytes = entry_count * sizeof(TTEntry);
+    size_t max_threads = std::max<size_t>(1, bytes / MIN_BYTES_PER_THREAD);
+    size_t num_threads = std::clamp<size_t>(threads, 1, max_threads);
+
+    size_t chunk = entry_count / num_threads;
+    auto clear_range = [this](size_t begin, size_t end) {
+        std::memset(static_cast<void*>(&table[begin]), 0, (end - begin) * sizeof(TTEntry));
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; ++t) {
+        size_t begin = t * chunk;
+        size_t end = (t + 1 == num_threads) ? entry_count : begin + chunk;
+        workers.emplace_back(clear_range, begin, end);
+    }
+    clear_range(0, num_threads > 1 ? chunk : entry_count);
+    for (auto& w : workers) {
+        w.join();
+    }
+
     current_generation = 0;
     reset_stats();
 }
@@ -124,12 +189,23 @@ void TTable::reset_stats() {
 
 size_t TTable::count_occupied() const {
     size_t count = 0;
-    for (const auto& entry : table) {
-        if (entry.hash_verify != 0) count++;
+    for (size_t i = 0; i < entry_count; ++i) {
+        if (table[i].hash_verify != 0) count++;
     }
     return count;
 }
 
 double TTable::occupancy_percent() const {
-    return table.empty() ? 0.0 : (100.0 * count_occupied() / table.size());
+    return entry_count == 0 ? 0.0 : (100.0 * count_occupied() / entry_count);
+}
+
+int TTable::hashfull() const {
+    size_t sample = std::min<size_t>(1000, entry_count);
+    if (sample == 0) return 0;
+    u8 current_gen_6bit = current_generation & 0x3F;
+    size_t count = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        if (table[i].hash_verify != 0 && (table[i].flags >> 2) == current_gen_6bit) count++;
+    }
+    return static_cast<int>(count * 1000 / sample);
 }
@@ -2,7 +2,8 @@
 
 #include "cachemiss.hpp"
 #include "move.hpp"
-#include <vector>
+#include <cstdlib>
+#include <memory>
 
 enum TTFlag : u8 { TT_EXACT = 0, TT_LOWER = 1, TT_UPPER = 2 };
 
@@ -27,14 +28,31 @@ struct TTStats {
 };
 
 class TTable {
-    std::vector<TTEntry> table;
-    size_t mask;
+    struct FreeDeleter {
+        void operator()(TTEntry* p) const { std::free(p); }
+    };
+
+    // Allocated without initialization so pages are only faulted in by clear()
+    std::unique_ptr<TTEntry[], FreeDeleter> table;
+    size_t entry_count = 0;
+    size_t mask = 0;
     u8 current_generation = 0;
     mutable TTStats stats;
 
 public:
+    // Empty table; resize() and clear() before use
+    TTable() = default;
     explicit TTable(size_t mb);
 
+    // Reallocate for a new size. Entries are undefined until clear() is called,
+    // which lets the caller fault the pages in later (e.g. on a warm-up thread).
+    void resize(size_t mb);
+
+    // Reallocate for a new size keeping what the table holds: shrinking folds
+    // the entries that now share a slot (the deepest stays), growing copies
+    // each entry to every slot it may belong to
+    void rescale(size_t mb);
+
     // Call before each new search to age existing entries
     void new_search() { current_generation++; }
 
@@ -52,11 +70,24 @@ public:
     bool probe(u64 hash, int depth, int ply, int alpha, int beta, int& score, Move32& best_move);
 
     void store(u64 hash, int depth, int ply, int score, TTFlag flag, Move32 best_move);
-    void clear();
+
+    // Entry stored for hash, or nullptr; for inspecting results outside the
+    // search (not counted in the stats, score not ply-adjusted)
+    const TTEntry* find(u64 hash) const {
+        const TTEntry& entry = table[hash & mask];
+        return entry.hash_verify == static_cast<u32>(hash >> 32) ? &entry : nullptr;
+    }
+
+    // Zero all entries; with threads > 1 the table is split into chunks that are
+    // written in parallel (also prefaults the pages of a freshly resized table)
+    void clear(int threads = 1);
     void reset_stats();
 
     const TTStats& get_stats() const { return stats; }
-    size_t size() const { return table.size(); }
+    size_t size() const { return entry_count; }
     size_t count_occupied() const;
     double occupancy_percent() const;
+
+    // Permille of the first 1000 entries written in the current generation (UCI "hashfull")
+    int hashfull() const;
 };
@@ -1,20 +1,31 @@
 #include "uci.hpp"
 #include "board.hpp"
+#include "cgroup.hpp"
+#include "cpu.hpp"
+#include "engine_server.hpp"
 #include "eval.hpp"
+#include "info_writer.hpp"
 #include "move.hpp"
+#include "pawn_cache.hpp"
+#include "perft.hpp"
 #include "search.hpp"
+#include "search_params.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
 #include "ttable.hpp"
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 
-#include <sys/select.h>
-#include <unistd.h>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <climits>
 #include <cmath>
 #include <vector>
 
@@ -27,16 +38,7 @@ static std::string trim_right(const std::string& s) {
 static const char* ENGINE_NAME = "CacheMiss";
 static const char* ENGINE_AUTHOR = "Helge";
 
-// UCI options
-static int move_overhead_ms = 100;
-static bool ponder_enabled = false;
-
-// Search state
-static std::atomic<bool> search_running{false};
-static SearchResult last_result;
-static std::mutex result_mutex;  // Protects last_result from data races
-static int moves_played = 0;     // Track game progress for time management
-static std::chrono::steady_clock::time_point search_start_time;  // For ponderhit elapsed calculation
+constexpr int MAX_PONDER_CANDIDATES = 8;
 
 // Estimate moves remaining based on game phase
 static int estimate_moves_remaining(int moves_played) {
@@ -46,57 +48,287 @@ static int estimate_moves_remaining(int moves_played) {
     return 20;                          // Endgame
 }
 
-// Non-blocking check if stdin has input available
-static bool input_available() {
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(STDIN_FILENO, &fds);
-    struct timeval tv = {0, 0};
-    return select(1, &fds, nullptr, nullptr, &tv) > 0;
+// ============================================================================
+// UCI session
+// ============================================================================
+// All protocol state of one GUI connection. The stand-alone engine runs a
+// single session on stdin/stdout; the engine server (engine_server.hpp) runs
+// one per socket, each with its own hash table, pawn cache and search
+// controller, so sessions never see each other's stop or ponderhit.
+
+namespace {
+
+struct InputLine {
+    std::string text;
+    u64 received_us;  // trace::now_us() when the line was read
+};
+
+// Multi-candidate pondering: one opponent reply
+struct PonderCandidate {
+    Board board;               // Position after the reply
+    std::vector<u64> hashes;   // Repetition history for it
+};
+
+class UciSession {
+public:
+    UciSession(std::istream& input, std::ostream& output, size_t hash, const SessionShare* server)
+        : in(input), out(output), search_out(server ? server->search_out : output), share(server), hash_mb(hash) {}
+
+    // Answer commands until quit or end of input
+    void run();
+
+private:
+    std::istream& in;
+    std::ostream& out;         // Written by the UCI thread
+    std::ostream& search_out;  // Written by the search thread (the same stream unless served)
+    const SessionShare* share;  // Server resources (null: stand-alone engine)
+
+    // Position and tables
+    Board board;
+    TTable tt;
+    PawnCache pawn_cache;
+    std::vector<u64> game_hashes;
+    PositionCache position_cache;
+    SearchController controller;
+    ThrottleMonitor throttle{cgroup_limits()};
+
+    // UCI options
+    size_t hash_mb;          // Hash the GUI asked for
+    size_t table_mb = 0;     // Hash actually allocated (the server may grant less)
+    int move_overhead_ms = 100;
+    bool ponder_enabled = false;
+    int ponder_candidates = 1;  // Opponent replies pondered at once ("Ponder Candidates")
+
+    // Search state
+    std::atomic<bool> search_running{false};
+    SearchResult last_result;
+    std::mutex result_mutex;  // Protects last_result from data races
+    int moves_played = 0;     // Track game progress for time management
+    PonderOutcome ponder_outcome = PonderOutcome::None;  // How the current ponder search ended
+
+    // Shared with the input thread, which applies ponderhit while the UCI thread is blocked
+    std::atomic<std::chrono::steady_clock::rep> search_start_ticks{0};  // For ponderhit elapsed calculation
+    std::atomic<bool> ponder_search{false};     // Running search is a ponder search not yet converted
+    std::atomic<int> ponder_time_ms{0};         // Time limit a ponderhit converts the search to
+    std::atomic<bool> candidate_ponder{false};  // Running ponder search covers several replies
+    std::atomic<bool> candidate_hit{false};     // ... and ponderhit arrived: back to the predicted one
+    std::atomic<std::chrono::steady_clock::rep> ponderhit_ticks{0};
+    std::atomic<bool> preempted{false};         // The server took the ponder search's slot
+    std::atomic<u64> queued_ticket{0};          // Scheduler ticket while the search waits for a slot
+
+    // Input
+    std::mutex input_mutex;
+    std::condition_variable input_cv;
+    std::deque<InputLine> input_queue;
+    bool input_eof = false;
+    bool rebalance = false;  // The server asked for this session's table to follow its share
+    std::thread input_thread;
+
+    std::thread warmup_thread;
+
+    std::chrono::steady_clock::time_point search_start_time() const {
+        return std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(search_start_ticks.load(std::memory_order_relaxed)));
+    }
+
+    void stop_search();
+    size_t hash_size();
+    void report_hash_limit();
+    void follow_hash_share();
+    void apply_ponderhit();
+    void input_reader();
+    bool next_input(std::string& line);
+    void parse_setoption(const std::string& line, bool& hash_changed);
+    void output_bestmove();
+    SearchResult unsearched_result();
+    bool wait_for_search_end(bool& is_pondering);
+    std::vector<PonderCandidate> make_ponder_candidates();
+    SearchResult ponder_candidate_search(std::vector<PonderCandidate>& candidates);
+    bool run_search(SearchLimits limits, bool ponder, std::vector<PonderCandidate>& candidates,
+                    bool& is_pondering);
+    bool handle_go_command(const std::string& line);
+    void wait_for_warmup();
+    void start_warmup();
+};
+
+}  // namespace
+
+// Hash size to allocate: what the GUI asked for within the container's
+// memory limit, or the server's grant of it (its pool is already clamped)
+size_t UciSession::hash_size() {
+    if (share) return share->hash.acquire(share->id, hash_mb);
+    size_t limit_mb = max_hash_mb(cgroup_limits());
+    return limit_mb > 0 ? std::min(hash_mb, limit_mb) : hash_mb;
+}
+
+void UciSession::report_hash_limit() {
+    if (share || table_mb >= hash_mb) return;
+    out << "info string hash " << hash_mb << " MB is over " << HASH_MEMORY_PERCENT
+        << "% of the container memory limit (" << (cgroup_limits().memory_bytes >> 20) << " MB), using "
+        << table_mb << " MB" << std::endl;
+}
+
+// Between moves a server session's table follows its share of the budget:
+// it shrinks when other games start and grows into memory they've freed
+void UciSession::follow_hash_share() {
+    if (!share) return;
+    size_t size = hash_size();
+    if (size == table_mb) return;
+    tt.rescale(size);
+    table_mb = size;
+}
+
+// ============================================================================
+// Input
+// ============================================================================
+// A single thread blocks on the session's input and queues every line for the
+// UCI thread. stop, ponderhit and quit also act on the search controller
+// right there, so they reach a running search as soon as the line arrives.
+// The UCI thread sleeps on the queue's condition variable instead of polling.
+
+// Convert a ponder search into a normal timed search (first caller wins)
+void UciSession::apply_ponderhit() {
+    if (!ponder_search.exchange(false)) return;
+    if (candidate_ponder.load(std::memory_order_relaxed)) {
+        // The candidate search restarts the predicted reply with the move's time
+        ponderhit_ticks.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        candidate_hit.store(true, std::memory_order_release);
+        std::cerr << "info string received: ponderhit (continuing the predicted reply, "
+                  << ponder_time_ms.load(std::memory_order_relaxed) << "ms)" << std::endl;
+        return;
+    }
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - search_start_time()).count();
+    int adding = ponder_time_ms.load(std::memory_order_relaxed);
+    int new_limit = static_cast<int>(elapsed_ms) + adding;
+    controller.set_time_limit(new_limit);
+    std::cerr << "info string received: ponderhit (elapsed=" << elapsed_ms
+              << "ms, adding=" << adding << "ms, limit=" << new_limit << "ms)" << std::endl;
+}
+
+// Stop the running search, or give up its wait for a server slot
+void UciSession::stop_search() {
+    controller.request_stop();
+    if (!share) return;
+    u64 ticket = queued_ticket.load();
+    if (ticket != 0) share->scheduler.cancel(ticket);
+}
+
+void UciSession::input_reader() {
+    std::string line;
+    while (std::getline(in, line)) {
+        line = trim_right(line);
+        if (line.empty()) continue;
+        u64 received = trace::now_us();
+
+        if (search_running.load(std::memory_order_acquire)) {
+            if (line == "stop" || line == "quit") {
+                stop_search();
+                ponder_search.store(false);
+            } else if (line == "ponderhit") {
+                apply_ponderhit();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(input_mutex);
+            input_queue.push_back({line, received});
+        }
+        input_cv.notify_one();
+        if (line == "quit") return;  // Nothing after quit is read
+    }
+    // The GUI is gone: a ponder search would never get its stop/ponderhit
+    if (ponder_search.exchange(false)) {
+        stop_search();
+    }
+    {
+        std::lock_guard<std::mutex> lock(input_mutex);
+        input_eof = true;
+    }
+    input_cv.notify_one();
+}
+
+// Block until the next input line; false at end of input. Meanwhile the
+// table follows the server share when another session asks for memory.
+bool UciSession::next_input(std::string& line) {
+    std::unique_lock<std::mutex> lock(input_mutex);
+    while (true) {
+        input_cv.wait(lock, [this] { return !input_queue.empty() || input_eof || rebalance; });
+        if (!input_queue.empty() || input_eof) break;
+        rebalance = false;
+        lock.unlock();
+        wait_for_warmup();
+        follow_hash_share();
+        lock.lock();
+    }
+    if (input_queue.empty()) return false;
+    line = std::move(input_queue.front().text);
+    input_queue.pop_front();
+    return true;
 }
 
 // Parse "position" command
 // position startpos [moves e2e4 e7e5 ...]
 // position fen <fen> [moves e2e4 e7e5 ...]
-void parse_position_command(const std::string& line, Board& board, std::vector<u64>& game_hashes) {
+void parse_position_command(const std::string& line, Board& board, std::vector<u64>& game_hashes,
+                            PositionCache* cache) {
     std::istringstream iss(line);
     std::string token;
     iss >> token;  // "position"
 
-    if (!(iss >> token)) return;
-
-    if (token == "startpos") {
-        board = Board();  // Default starting position
-        iss >> token;     // Possibly "moves"
-    } else if (token == "fen") {
-        // Collect FEN string (up to 6 parts)
-        std::string fen;
-        for (int i = 0; i < 6 && (iss >> token); ++i) {
-            if (token == "moves") break;
-            if (!fen.empty()) fen += ' ';
-            fen += token;
-        }
-        board = Board(fen);
-        // If we collected all 6 FEN parts, check if there's a "moves" token next
-        if (token != "moves") {
-            iss >> token;  // Try to read "moves"
-        }
-    }
-
-    // Reset hash history with initial position
-    game_hashes.clear();
-    game_hashes.push_back(board.hash);
-
-    // Apply moves if present
-    if (token == "moves") {
-        while (iss >> token) {
-            Move32 move = parse_uci_move(token, board);
-            if (move.data != 0) {
-                game_hashes.push_back(board.hash);
-                (void)make_move(board, move);
-            }
+    // Split into the base position and the move list
+    std::string base;
+    std::vector<std::string> moves;
+    bool in_moves = false;
+    while (iss >> token) {
+        if (in_moves) {
+            moves.push_back(token);
+        } else if (token == "moves") {
+            in_moves = true;
+        } else {
+            if (!base.empty()) base += ' ';
+            base += token;
         }
     }
+    if (base.empty()) return;
+
+    // Fast path: same base, the previous move list is a prefix of this one and
+    // nothing has touched the board since
+    size_t first_new = 0;
+    if (cache && cache->valid && cache->base == base && cache->moves.size() <= moves.size() &&
+        board.hash == cache->hash && game_hashes.size() == cache->hash_count &&
+        std::equal(cache->moves.begin(), cache->moves.end(), moves.begin())) {
+        first_new = cache->moves.size();
+    } else {
+        if (base == "startpos") {
+            board = Board();  // Default starting position
+        } else if (base.rfind("fen ", 0) == 0) {
+            board = Board(base.substr(4));
+        } else {
+            moves.clear();
+        }
+
+        // Reset hash history with initial position
+        game_hashes.clear();
+        game_hashes.push_back(board.hash);
+    }
+
+    // Apply the (new) moves
+    for (size_t i = first_new; i < moves.size(); ++i) {
+        Move32 move = parse_uci_move(moves[i], board);
+        if (move.data != 0) {
+            game_hashes.push_back(board.hash);
+            (void)make_move(board, move);
+        }
+    }
+
+    if (cache) {
+        cache->base = std::move(base);
+        cache->moves = std::move(moves);
+        cache->hash = board.hash;
+        cache->hash_count = game_hashes.size();
+        cache->valid = true;
+    }
 }
 
 // Parse "go" command and return time in ms and ponder flag
@@ -115,6 +347,7 @@ GoParams parse_go_command(const std::string& line, const Board& board, int moves
     int winc = 0, binc = 0;
     int movestogo = 0;
     int depth = 0;
+    u64 nodes = 0;
     bool infinite = false;
     bool is_ponder = false;
 
@@ -133,6 +366,8 @@ GoParams parse_go_command(const std::string& line, const Board& board, int moves
             iss >> movestogo;
         } else if (token == "depth") {
             iss >> depth;
+        } else if (token == "nodes") {
+            iss >> nodes;
         } else if (token == "infinite") {
             infinite = true;
         } else if (token == "ponder") {
@@ -189,23 +424,23 @@ GoParams parse_go_command(const std::string& line, const Board& board, int moves
 
     // For infinite or ponder, use very long time but remember normal_time for ponderhit
     if (infinite) {
-        return {999999999, 999999999, depth, false};
+        return {999999999, 999999999, depth, false, nodes};
     }
     if (is_ponder) {
-        return {999999999, normal_time, depth, true};  // Long time for ponder, but save normal time
+        return {999999999, normal_time, depth, true, nodes};  // Long time for ponder, but save normal time
     }
 
-    // If only depth specified, use very long time
-    if (depth > 0 && movetime == 0 && wtime == 0 && btime == 0) {
-        return {999999999, 999999999, depth, false};
+    // If only depth and/or nodes specified, use very long time
+    if ((depth > 0 || nodes > 0) && movetime == 0 && wtime == 0 && btime == 0) {
+        return {999999999, 999999999, depth, false, nodes};
     }
 
-    return {normal_time, normal_time, depth, false};
+    return {normal_time, normal_time, depth, false, nodes};
 }
 
 // Parse "setoption name <name> value <value>"
 // Handles multi-word option names like "Move Overhead"
-static void parse_setoption(const std::string& line, size_t& hash_mb, bool& hash_changed) {
+void UciSession::parse_setoption(const std::string& line, bool& hash_changed) {
     std::istringstream iss(line);
     std::string token;
     iss >> token;  // "setoption"
@@ -245,15 +480,38 @@ static void parse_setoption(const std::string& line, size_t& hash_mb, bool& hash
         }
     } else if (name == "Ponder") {
         ponder_enabled = (value == "true");
+    } else if (name == "Ponder Candidates" && !value.empty()) {
+        ponder_candidates = std::clamp(std::stoi(value), 1, MAX_PONDER_CANDIDATES);
+    } else if ((name == "Telemetry File" || name == "Trace File") && share) {
+        // Both logs are per process: one session must not swap them under the others
+        out << "info string " << name << " is not available in server sessions"
+            << (name == "Telemetry File" ? "; start the server with --telemetry" : "") << std::endl;
+    } else if (name == "Telemetry File") {
+        if (!g_telemetry.open(value)) {
+            out << "info string cannot open telemetry file " << value << std::endl;
+        }
+    } else if (name == "Trace File") {
+        if (!trace::open(value)) {
+            out << "info string cannot open trace file " << value << std::endl;
+        }
+    } else if (is_search_param(name)) {
+        // Other options (UCI_Chess960, ...) are ignored; their values may not be numbers
+        int param = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), param);
+        if (error == std::errc() && end == value.data() + value.size() && set_search_param(name, param)) {
+            refresh_search_tables();
+        }
     }
 }
 
 // Output bestmove with optional ponder move
 // Acquires result_mutex to safely read last_result
 // Validates ponder move is legal in position after best_move
-static void output_bestmove(const Board& board) {
+void UciSession::output_bestmove() {
     std::lock_guard<std::mutex> lock(result_mutex);
-    std::cout << "bestmove " << last_result.best_move.to_uci();
+    trace::instant("bestmove");
+    // "0000": no legal move
+    out << "bestmove " << (last_result.best_move.data != 0 ? last_result.best_move.to_uci() : "0000");
 
     if (ponder_enabled && last_result.pv_length >= 2) {
         // Validate ponder move is legal in position after best_move
@@ -272,158 +530,495 @@ static void output_bestmove(const Board& board) {
         }
 
         if (ponder_valid) {
-            std::cout << " ponder " << last_result.pv[1].to_uci();
+            out << " ponder " << last_result.pv[1].to_uci();
         }
     }
-    std::cout << std::endl;
+    out << std::endl;
 }
 
-// Poll for stop/ponderhit/quit while search is running
-// Returns true if should exit UCI loop (quit received)
-static bool poll_during_search(bool& is_pondering, int ponder_time_ms) {
-    while (search_running.load(std::memory_order_acquire)) {
-        if (input_available()) {
-            std::string input_cmd;
-            if (!std::getline(std::cin, input_cmd)) break;
-            input_cmd = trim_right(input_cmd);
-
-            if (input_cmd == "stop") {
-                std::cerr << "info string received: stop" << std::endl;
-                g_search_controller.request_stop();
-                is_pondering = false;
-            }
-            else if (input_cmd == "ponderhit") {
-                auto now = std::chrono::steady_clock::now();
-                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - search_start_time).count();
-                int new_limit = static_cast<int>(elapsed_ms) + ponder_time_ms;
-                std::cerr << "info string received: ponderhit (elapsed=" << elapsed_ms
-                          << "ms, adding=" << ponder_time_ms << "ms, limit=" << new_limit << "ms)" << std::endl;
-                is_pondering = false;
-                g_search_controller.set_time_limit(new_limit);
-            }
-            else if (input_cmd == "quit") {
-                std::cerr << "info string received: quit" << std::endl;
-                g_search_controller.request_stop();
-                return true;  // Signal to exit UCI loop
-            }
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-    return false;
+// Result for a search stopped before it got a server slot: bestmove must
+// still be playable. A depth-1 search takes well under a millisecond, so it
+// runs without a slot, on a controller of its own (the session's is stopped).
+SearchResult UciSession::unsearched_result() {
+    SearchController quick;
+    SearchLimits limits{999999999, 1, 0, true, nullptr, &quick, &search_out};
+    return search(board, tt, limits, game_hashes.data(), static_cast<int>(game_hashes.size()));
 }
 
-// Wait for stop/ponderhit after ponder search finished naturally
+// Block until the search is over: it has finished and, for a ponder search,
+// stop or ponderhit has arrived. Other commands that arrive meanwhile are
+// answered (isready) or held back until bestmove has been sent.
 // Returns true if should exit UCI loop (quit received)
-static bool wait_for_ponder_end(bool& is_pondering) {
-    while (is_pondering) {
-        std::cerr << "info string ponder search finished, waiting for stop/ponderhit" << std::endl;
-        std::string input_cmd;
-        if (!std::getline(std::cin, input_cmd)) break;
-        input_cmd = trim_right(input_cmd);
-
-        if (input_cmd == "stop") {
-            std::cerr << "info string received: stop (after ponder finished)" << std::endl;
+bool UciSession::wait_for_search_end(bool& is_pondering) {
+    std::deque<InputLine> deferred;
+    bool should_quit = false;
+    bool announced = false;
+
+    std::unique_lock<std::mutex> lock(input_mutex);
+    while (true) {
+        input_cv.wait(lock, [&] {
+            return !input_queue.empty() ||
+                   (!search_running.load(std::memory_order_acquire) && (!is_pondering || input_eof || !announced));
+        });
+
+        if (input_queue.empty()) {
+            // Search has finished
+            if (!is_pondering || input_eof) break;
+            std::cerr << "info string ponder search finished, waiting for stop/ponderhit" << std::endl;
+            announced = true;
+            continue;
+        }
+
+        InputLine input = std::move(input_queue.front());
+        input_queue.pop_front();
+        bool finished = !search_running.load(std::memory_order_acquire);
+
+        if (input.text == "stop") {
+            trace::instant_at("stop", input.received_us);
+            std::cerr << "info string received: stop" << (finished ? " (after search finished)" : "") << std::endl;
+            stop_search();
+            ponder_search.store(false);
+            if (is_pondering) ponder_outcome = PonderOutcome::Miss;
             is_pondering = false;
         }
-        else if (input_cmd == "ponderhit") {
-            std::cerr << "info string received: ponderhit (after ponder finished)" << std::endl;
+        else if (input.text == "ponderhit") {
+            trace::instant_at("ponderhit", input.received_us);
+            if (finished) {
+                std::cerr << "info string received: ponderhit (after search finished)" << std::endl;
+                ponder_search.store(false);
+            } else {
+                apply_ponderhit();  // No-op if the input thread got there first
+            }
+            if (is_pondering) ponder_outcome = PonderOutcome::Hit;
             is_pondering = false;
         }
-        else if (input_cmd == "quit") {
-            return true;  // Exit UCI loop
+        else if (input.text == "quit") {
+            trace::instant_at("quit", input.received_us);
+            std::cerr << "info string received: quit" << std::endl;
+            stop_search();
+            should_quit = true;
+            break;
+        }
+        else if (input.text == "isready") {
+            out << "readyok" << std::endl;
+        }
+        else {
+            deferred.push_back(std::move(input));
+        }
+    }
+
+    // Put held-back commands back in front of anything that arrived later
+    input_queue.insert(input_queue.begin(), std::make_move_iterator(deferred.begin()),
+                       std::make_move_iterator(deferred.end()));
+    return should_quit;
+}
+
+// ============================================================================
+// Multi-candidate pondering
+// ============================================================================
+// With "Ponder Candidates" > 1 a ponder search covers the predicted reply and
+// the opponent's next most likely replies. They are searched one depth at a
+// time in turn, all into the shared TT, so the opponent's time is split
+// between them. ponderhit aborts whichever candidate is running and searches
+// the predicted reply with the move's normal time, starting from what the TT
+// already holds. After a miss the next "go" is for the reply actually played;
+// if it was a candidate, its iterations are TT hits.
+
+std::vector<Move32> rank_ponder_replies(const Board& parent, const TTable& tt, Move32 predicted, int count) {
+    struct Reply {
+        Move32 move;
+        int score;
+        int depth;
+    };
+    std::vector<Reply> replies;
+    Board board = parent;
+    MoveList moves = generate_moves<MoveType::All>(board);
+    for (int i = 0; i < moves.size; ++i) {
+        if (moves[i].same_move(predicted)) continue;
+        UndoInfo undo = make_move(board, moves[i]);
+        if (!is_illegal(board)) {
+            if (const TTEntry* entry = tt.find(board.hash)) {
+                replies.push_back({moves[i], entry->score, entry->depth});
+            }
         }
+        unmake_move(board, moves[i], undo);
     }
-    return false;
+
+    // Lowest score for us first; the deeper entry first among equal scores
+    std::stable_sort(replies.begin(), replies.end(), [](const Reply& a, const Reply& b) {
+        return a.score != b.score ? a.score < b.score : a.depth > b.depth;
+    });
+    std::vector<Move32> ranked;
+    for (size_t i = 0; i < replies.size() && static_cast<int>(i) < count; ++i) {
+        ranked.push_back(replies[i].move);
+    }
+    return ranked;
 }
 
-// Handle "go" command: start search, poll for commands, output bestmove
-// Returns true if should exit UCI loop (quit received)
-static bool handle_go_command(const std::string& line, Board& board, TTable& tt,
-                              const std::vector<u64>& game_hashes) {
-    GoParams params = parse_go_command(line, board, moves_played, move_overhead_ms);
-    bool is_pondering = params.is_ponder;
-    int ponder_time_ms = params.normal_time_ms;
+// The predicted reply (the current position) first, then the ranked others.
+// Empty if the position doesn't end with the opponent's move.
+std::vector<PonderCandidate> UciSession::make_ponder_candidates() {
+    const PositionCache& position = position_cache;
+    std::vector<PonderCandidate> candidates;
+    if (!position.valid || position.moves.empty()) return candidates;
+
+    Board parent;
+    std::vector<u64> parent_hashes;
+    std::string line = "position " + position.base + " moves";
+    for (size_t i = 0; i + 1 < position.moves.size(); ++i) {
+        line += " " + position.moves[i];
+    }
+    parse_position_command(line, parent, parent_hashes);
+    Move32 predicted = parse_uci_move(position.moves.back(), parent);
+    if (predicted.data == 0) return candidates;
 
-    g_search_controller.reset();
+    candidates.push_back({board, game_hashes});
+    std::string names = position.moves.back();
+    for (Move32 reply : rank_ponder_replies(parent, tt, predicted, ponder_candidates - 1)) {
+        PonderCandidate candidate{parent, parent_hashes};
+        candidate.hashes.push_back(parent.hash);
+        (void)make_move(candidate.board, reply);
+        candidates.push_back(std::move(candidate));
+        names += " " + reply.to_uci();
+    }
+    std::cerr << "info string pondering " << candidates.size() << " replies: " << names << std::endl;
+    return candidates;
+}
+
+// Ponder search over several candidates; returns the predicted reply's result
+SearchResult UciSession::ponder_candidate_search(std::vector<PonderCandidate>& candidates) {
+    constexpr int PONDER_TIME_MS = 999999999;  // Until stop or ponderhit
+    SearchResult result{};
+    InfoWriter info;
+    u64 nodes = 0;  // Over every slice, for the reported nps
+    bool hit = false;
+    for (int depth = 1; depth <= MAX_PLY && !hit; ++depth) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (controller.should_stop()) return result;
+            hit = candidate_hit.load(std::memory_order_acquire);
+            if (hit) break;
+
+            // Each slice deepens from depth 1 again (cheap with the TT from the
+            // last round), so slices run silently and the predicted reply
+            // reports one line per new depth instead
+            SearchLimits limits{PONDER_TIME_MS, depth, 0, true, &candidate_hit, &controller, &search_out};
+            PonderCandidate& candidate = candidates[i];
+            SearchResult slice = search(candidate.board, tt, limits, candidate.hashes.data(),
+                                        static_cast<int>(candidate.hashes.size()));
+            nodes += slice.nodes;
+            if (i == 0 && slice.depth > result.depth) {
+                result = slice;
+                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - search_start_time()).count();
+                info.format_pv(result.depth, result.seldepth, result.score, ScoreBound::Exact, nodes, elapsed_ms,
+                               tt.hashfull(), result.pv, result.pv_length);
+                info.write(search_out);
+            }
+        }
+    }
+    if (!hit) return result;  // Every candidate searched to MAX_PLY
+
+    auto since_hit = std::chrono::steady_clock::now().time_since_epoch().count() -
+                     ponderhit_ticks.load(std::memory_order_relaxed);
+    int since_hit_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::duration(since_hit)).count());
+    SearchLimits limits{std::max(1, ponder_time_ms.load(std::memory_order_relaxed) - since_hit_ms), 0, 0,
+                        false, nullptr, &controller, &search_out};
+    limits.report_after_depth = result.depth;  // The GUI has seen those depths already
+    PonderCandidate& predicted = candidates[0];
+    SearchResult continued = search(predicted.board, tt, limits, predicted.hashes.data(),
+                                    static_cast<int>(predicted.hashes.size()));
+    // The restart may not get past the depth the predicted reply reached while pondering
+    return continued.depth >= result.depth ? continued : result;
+}
+
+// Run one search on its own thread and wait for it (and, when pondering, for
+// stop/ponderhit). Under the engine server the search first waits for a slot.
+// Returns true if should exit UCI loop (quit received)
+bool UciSession::run_search(SearchLimits limits, bool ponder, std::vector<PonderCandidate>& candidates,
+                            bool& is_pondering) {
+    controller.reset();
     tt.new_search();
-    search_running.store(true, std::memory_order_relaxed);
-    search_start_time = std::chrono::steady_clock::now();
+    limits.controller = &controller;
+    limits.out = &search_out;
+    search_running.store(true, std::memory_order_release);
+
+    std::thread search_thread([this, limits, ponder, &candidates, params = get_search_params()]() mutable {
+        trace::set_thread_name("search");
+        set_search_params(params);  // Tuning builds keep setoption values per thread
+        t_pawn_cache = &pawn_cache;
+
+        u64 ticket = 0;
+        bool admitted = true;
+        if (share) {
+            auto queued = std::chrono::steady_clock::now();
+            ticket = share->scheduler.enqueue(ponder ? INT_MAX : limits.time_ms, ponder, [this] {
+                // Only while still pondering: after ponderhit this is the move's own search
+                if (ponder_search.exchange(false)) {
+                    preempted.store(true);
+                    controller.request_stop();
+                }
+            });
+            // stop/quit while queued (a ponder miss, the GUI leaving) ends the
+            // wait instead of holding bestmove until another game's search is done
+            queued_ticket.store(ticket);
+            admitted = share->scheduler.wait(ticket, [this] { return controller.should_stop(); });
+            queued_ticket.store(0);
+            if (admitted && !ponder) {
+                // Time spent queued came off our clock
+                auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - queued).count();
+                limits.time_ms = std::max(1, limits.time_ms - static_cast<int>(waited_ms));
+            }
+        }
 
-    std::thread search_thread([&board, &tt, time_ms = params.time_ms, depth_limit = params.depth_limit,
-                               hash_data = game_hashes.data(), hash_len = (int)game_hashes.size()]() {
-        SearchResult result = search(board, tt, time_ms, depth_limit, hash_data, hash_len);
+        SearchResult result;
+        if (!admitted) {
+            result = unsearched_result();
+        } else if (candidates.size() > 1) {
+            result = ponder_candidate_search(candidates);
+        } else {
+            result = search(board, tt, limits, game_hashes.data(), static_cast<int>(game_hashes.size()));
+        }
+        if (share && admitted) share->scheduler.release(ticket);
         {
             std::lock_guard<std::mutex> lock(result_mutex);
             last_result = result;
         }
-        search_running.store(false, std::memory_order_release);
+        {
+            // Under the queue mutex so the waiting UCI thread can't miss the wakeup
+            std::lock_guard<std::mutex> lock(input_mutex);
+            search_running.store(false, std::memory_order_release);
+        }
+        input_cv.notify_one();
     });
 
-    bool should_quit = poll_during_search(is_pondering, ponder_time_ms);
+    bool should_quit = wait_for_search_end(is_pondering);
     search_thread.join();
+    ponder_search.store(false);
+    candidate_ponder.store(false, std::memory_order_relaxed);
+    return should_quit;
+}
 
-    if (should_quit) {
-        return true;
+// Handle "go" command: start search, poll for commands, output bestmove
+// Returns true if should exit UCI loop (quit received)
+bool UciSession::handle_go_command(const std::string& line) {
+    // A throttled CPU quota can stall the search for up to a period at any
+    // moment; keep that much in reserve while it keeps happening
+    int throttle_margin_ms = throttle.margin_ms();
+    if (throttle_margin_ms > 0) {
+        std::cerr << "info string CPU quota throttled " << throttle.last_throttled_us() / 1000
+                  << "ms since the last move, move overhead +" << throttle_margin_ms << "ms" << std::endl;
     }
+    GoParams params = parse_go_command(line, board, moves_played, move_overhead_ms + throttle_margin_ms);
+    trace::set_thread_name("uci");
+    trace::instant("go", {"time_ms", params.time_ms}, {"ponder", params.is_ponder});
+    bool is_pondering = params.is_ponder;
+    ponder_outcome = PonderOutcome::None;
+
+    tt.reset_stats();
+    search_start_ticks.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    ponder_time_ms.store(params.normal_time_ms, std::memory_order_relaxed);
+    ponder_search.store(params.is_ponder);
+    preempted.store(false);
+
+    std::vector<PonderCandidate> candidates;
+    if (params.is_ponder && ponder_candidates > 1 && params.depth_limit == 0 && params.node_limit == 0) {
+        candidates = make_ponder_candidates();
+    }
+    candidate_ponder.store(candidates.size() > 1, std::memory_order_relaxed);
+    candidate_hit.store(false, std::memory_order_relaxed);
+
+    SearchLimits limits{params.time_ms, params.depth_limit, params.node_limit};
+    bool should_quit = run_search(limits, params.is_ponder, candidates, is_pondering);
 
-    if (wait_for_ponder_end(is_pondering)) {
+    if (!should_quit && ponder_outcome == PonderOutcome::Hit && preempted.load()) {
+        // The server gave this ponder search's slot to another game's move
+        // before ponderhit came: think again, now on our own clock
+        std::cerr << "info string ponder search was preempted, searching " << params.normal_time_ms << "ms"
+                  << std::endl;
+        candidates.clear();
+        bool pondering = false;
+        SearchLimits retry{params.normal_time_ms, params.depth_limit, params.node_limit};
+        should_quit = run_search(retry, false, candidates, pondering);
+    }
+
+    if (should_quit) {
         return true;
     }
 
-    output_bestmove(board);
+    output_bestmove();
+
+    if (g_telemetry.is_open()) {
+        TelemetryRecord record;
+        record.session = share ? share->id : 0;
+        record.fen = board.to_fen();
+        record.moves_played = moves_played;
+        record.ponder = params.is_ponder;
+        record.ponder_outcome = ponder_outcome;
+        record.time_allocated_ms = params.normal_time_ms;
+        record.time_used_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - search_start_time()).count());
+        record.tt_hits = tt.get_stats().hits;
+        record.tt_probes = tt.get_stats().hits + tt.get_stats().misses;
+        record.hashfull = tt.hashfull();
+        {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            record.result = last_result;
+        }
+        g_telemetry.log(std::move(record));
+    }
     moves_played++;
+    follow_hash_share();  // On the opponent's clock
+
+    // Search thread is joined, so no thread is recording - safe to write the trace out
+    trace::flush();
     return false;
 }
 
-void uci_loop(size_t hash_mb) {
-    Board board;
-    TTable tt(hash_mb);
-    std::vector<u64> game_hashes;
+// ============================================================================
+// Warm-up
+// ============================================================================
+// A freshly allocated hash table is not backed by physical pages until it is
+// written, and the slider attack tables live in not-yet-touched rodata. Without
+// warm-up the first search pays for those page faults on the clock. The
+// warm-up runs on its own thread right after startup (and after Hash changes)
+// so "uci" is answered immediately; "isready" and anything that needs the
+// table waits for it.
+
+void UciSession::wait_for_warmup() {
+    if (warmup_thread.joinable()) {
+        warmup_thread.join();
+    }
+}
+
+void UciSession::start_warmup() {
+    wait_for_warmup();
+    warmup_thread = std::thread([this] {
+        trace::set_thread_name("warmup");
+        trace::Span span("warmup");
+
+        tt.clear(available_cpus());
+
+        // The pawn cache needs no pass of its own: its constructor zeroes
+        // every entry, so its pages are resident before the first search
+
+        // One read per page of the magic attack tables
+        constexpr size_t PER_PAGE = 4096 / sizeof(Bitboard);
+        Bitboard sink = 0;
+        for (size_t i = 0; i < ROOK_ATTACKS.size(); i += PER_PAGE) sink ^= ROOK_ATTACKS[i];
+        for (size_t i = 0; i < BISHOP_ATTACKS.size(); i += PER_PAGE) sink ^= BISHOP_ATTACKS[i];
+        asm volatile("" : : "r"(sink));
+
+        // Shallow perft to warm move generation code and the branch predictors
+        Board warm_board;
+        perft(warm_board, 3);
+    });
+}
+
+void UciSession::run() {
+    table_mb = hash_size();
+    if (share) {
+        share->hash.on_rebalance(share->id, [this] {
+            {
+                std::lock_guard<std::mutex> lock(input_mutex);
+                rebalance = true;
+            }
+            input_cv.notify_one();
+        });
+    }
+    tt.resize(table_mb);
+    start_warmup();
+    input_thread = std::thread(&UciSession::input_reader, this);
 
     std::string line;
-    while (std::getline(std::cin, line)) {
-        line = trim_right(line);
-        if (line.empty()) continue;
+    while (next_input(line)) {
 
         std::istringstream iss(line);
         std::string cmd;
         iss >> cmd;
 
         if (cmd == "uci") {
-            std::cout << "id name " << ENGINE_NAME << std::endl;
-            std::cout << "id author " << ENGINE_AUTHOR << std::endl;
-            std::cout << "option name Hash type spin default 512 min 1 max 65536" << std::endl;
-            std::cout << "option name Move Overhead type spin default 100 min 0 max 5000" << std::endl;
-            std::cout << "option name Ponder type check default false" << std::endl;
-            std::cout << "uciok" << std::endl;
+            out << "id name " << ENGINE_NAME << std::endl;
+            out << "id author " << ENGINE_AUTHOR << std::endl;
+            out << "info string CPU dispatch " << cpu_dispatch_level() << std::endl;
+            const CgroupLimits& limits = cgroup_limits();
+            if (limits.memory_bytes > 0 || limits.cpu_quota_us > 0) {
+                out << "info string container limits: memory ";
+                if (limits.memory_bytes > 0) {
+                    out << (limits.memory_bytes >> 20) << " MB";
+                } else {
+                    out << "unlimited";
+                }
+                out << ", CPU quota ";
+                if (limits.cpu_quota_us > 0) {
+                    out << limits.cpu_quota_us << "/" << limits.cpu_period_us << "us";
+                } else {
+                    out << "unlimited";
+                }
+                out << " (cgroup v" << limits.version << ")" << std::endl;
+            }
+            report_hash_limit();
+            if (share) {
+                out << "info string engine server: hash " << table_mb << " of " << share->hash.total_mb()
+                    << " MB, " << share->scheduler.slots() << " search slots" << std::endl;
+            }
+            out << "option name Hash type spin default 512 min 1 max 65536" << std::endl;
+            out << "option name Move Overhead type spin default 100 min 0 max 5000" << std::endl;
+            out << "option name Ponder type check default false" << std::endl;
+            out << "option name Ponder Candidates type spin default 1 min 1 max "
+                << MAX_PONDER_CANDIDATES << std::endl;
+            if (!share) {
+                out << "option name Trace File type string default <empty>" << std::endl;
+                out << "option name Telemetry File type string default <empty>" << std::endl;
+            }
+            print_search_param_options(out);
+            out << "uciok" << std::endl;
         }
         else if (cmd == "isready") {
-            std::cout << "readyok" << std::endl;
+            wait_for_warmup();
+            out << "readyok" << std::endl;
         }
         else if (cmd == "ucinewgame") {
-            tt.clear();
-            g_pawn_cache.clear();
+            wait_for_warmup();
+            // The table is cleared anyway: follow the server share by plain reallocation
+            size_t size = hash_size();
+            if (size != table_mb) {
+                table_mb = size;
+                tt.resize(table_mb);
+                out << "info string hash " << table_mb << " MB" << std::endl;
+            }
+            tt.clear(available_cpus());
+            pawn_cache.clear();
             board = Board();
+            position_cache = PositionCache();
             moves_played = 0;
         }
         else if (cmd == "setoption") {
+            wait_for_warmup();
             bool hash_changed = false;
-            parse_setoption(line, hash_mb, hash_changed);
+            parse_setoption(line, hash_changed);
             if (hash_changed) {
-                tt = TTable(hash_mb);
+                table_mb = hash_size();
+                tt.resize(table_mb);
+                if (share && table_mb != hash_mb) {
+                    out << "info string hash " << table_mb << " MB (server share)" << std::endl;
+                }
+                report_hash_limit();
+                start_warmup();
             }
         }
         else if (cmd == "position") {
-            parse_position_command(line, board, game_hashes);
+            parse_position_command(line, board, game_hashes, &position_cache);
         }
         else if (cmd == "go") {
-            if (handle_go_command(line, board, tt, game_hashes)) {
-                return;  // Quit received during search
+            wait_for_warmup();
+            if (handle_go_command(line)) {
+                break;  // Quit received during search
             }
         }
         else if (cmd == "stop") {
-            g_search_controller.request_stop();
+            controller.request_stop();
         }
         else if (cmd == "ponderhit") {
             // Ponderhit received when not searching - ignore
@@ -435,4 +1030,17 @@ void uci_loop(size_t hash_mb) {
             std::cerr << "Unknown command: " << cmd << std::endl;
         }
     }
+    wait_for_warmup();
+    input_thread.join();  // Already done: it stops after quit or at end of input
+    if (share) share->hash.release(share->id);  // Before the rebalance call's `this` goes
+}
+
+void uci_session(std::istream& in, std::ostream& out, size_t hash_mb, const SessionShare* share) {
+    UciSession(in, out, hash_mb, share).run();
+}
+
+void uci_loop(size_t hash_mb) {
+    uci_session(std::cin, std::cout, hash_mb);
+    trace::close();
+    g_telemetry.close();
 }
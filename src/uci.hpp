@@ -1,14 +1,34 @@
 #pragma once
 
 #include "board.hpp"
+#include "move.hpp"
 #include <cstddef>
+#include <iosfwd>
 #include <string>
 #include <vector>
 
-// Run the UCI protocol loop
+class TTable;
+class HashPool;
+class SearchScheduler;
+
+// Run the UCI protocol loop on stdin/stdout
 // hash_mb: size of hash table in megabytes
 void uci_loop(size_t hash_mb = 512);
 
+// What a session run by the engine server (engine_server.hpp) shares with the
+// other sessions: its hash table is sized from the pool and every search
+// waits for a slot
+struct SessionShare {
+    HashPool& hash;
+    SearchScheduler& scheduler;
+    int id;
+    std::ostream& search_out;  // The search thread's stream to the client (the session's own is the UCI thread's)
+};
+
+// Run one UCI session on `in`/`out` until quit or end of input.
+// share: server resources (null: a stand-alone engine using hash_mb)
+void uci_session(std::istream& in, std::ostream& out, size_t hash_mb, const SessionShare* share = nullptr);
+
 // =============================================================================
 // Testable UCI components
 // =============================================================================
@@ -19,12 +39,35 @@ struct GoParams {
     int normal_time_ms;    // Time we'd use for a normal search (for ponderhit)
     int depth_limit;       // Max depth to search (0 = unlimited)
     bool is_ponder;
+    u64 node_limit = 0;    // Max nodes to search (0 = unlimited)
 };
 
 // Parse "go" command and return time parameters
 // Exposed for testing
 GoParams parse_go_command(const std::string& line, const Board& board, int moves_played, int move_overhead_ms);
 
+// State left by the previous "position" command. During a game each command
+// repeats the previous one plus the moves played since, so only those new
+// moves need to be applied.
+struct PositionCache {
+    std::string base;                 // "startpos" or "fen <fen>"
+    std::vector<std::string> moves;   // Move tokens applied on top of base
+    u64 hash = 0;                     // Board hash after the moves
+    size_t hash_count = 0;            // game_hashes size after the moves
+    bool valid = false;
+};
+
 // Parse "position" command and update board state
+// With a cache, a command that extends the previous one only applies the new
+// moves to board/game_hashes; anything else rebuilds from scratch.
+// Exposed for testing
+void parse_position_command(const std::string& line, Board& board, std::vector<u64>& game_hashes,
+                            PositionCache* cache = nullptr);
+
+// Opponent replies in `parent` (the position before the predicted ponder
+// move) that are pondered besides `predicted`: the `count` most likely, by
+// the scores the previous search left in the TT for the positions after them
+// (the opponent picks the lowest score for us). Replies without an entry are
+// left out.
 // Exposed for testing
-void parse_position_command(const std::string& line, Board& board, std::vector<u64>& game_hashes);
+std::vector<Move32> rank_ponder_replies(const Board& parent, const TTable& tt, Move32 predicted, int count);
@@ -0,0 +1,101 @@
+// test_capi.cpp - libcachemiss C API tests
+#include "test_framework.hpp"
+#include "libcachemiss.h"
+#include <cstring>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// Position Tests
+// ============================================================================
+
+static void test_capi_set_position() {
+    cachemiss_engine* engine = cachemiss_create(1);
+    ASSERT_TRUE(engine != nullptr);
+
+    const char* moves[] = {"e2e4", "e7e5", "g1f3"};
+    ASSERT_EQ(cachemiss_set_position(engine, nullptr, moves, 3), CACHEMISS_OK);
+    char fen[128];
+    ASSERT_GT(cachemiss_get_fen(engine, fen, sizeof(fen)), 0);
+    ASSERT_EQ(std::string(fen).substr(0, 49), std::string("rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R"));
+
+    // Errors leave the position alone
+    const char* illegal[] = {"e2e4", "e2e4"};
+    ASSERT_EQ(cachemiss_set_position(engine, nullptr, illegal, 2), CACHEMISS_ILLEGAL_MOVE);
+    ASSERT_EQ(cachemiss_set_position(engine, "8/8/8/8/8/8/8/8 w - - 0 1", nullptr, 0), CACHEMISS_INVALID_FEN);
+    ASSERT_EQ(cachemiss_set_position(engine, "not a fen", nullptr, 0), CACHEMISS_INVALID_FEN);
+    ASSERT_EQ(cachemiss_make_move(engine, "e1e2"), CACHEMISS_ILLEGAL_MOVE);  // Own piece there
+    char after[128];
+    cachemiss_get_fen(engine, after, sizeof(after));
+    ASSERT_EQ(std::string(after), std::string(fen));
+
+    ASSERT_EQ(cachemiss_make_move(engine, "b8c6"), CACHEMISS_OK);
+    cachemiss_destroy(engine);
+}
+
+static void test_capi_legal_moves_and_eval() {
+    cachemiss_engine* engine = cachemiss_create(1);
+    char moves[CACHEMISS_MAX_MOVES][CACHEMISS_MOVE_CHARS];
+    ASSERT_EQ(cachemiss_legal_moves(engine, moves), 20);
+
+    // Only the king can move out of this check
+    ASSERT_EQ(cachemiss_set_position(engine, "4k3/8/8/8/8/8/8/r3K3 w - - 0 1", nullptr, 0), CACHEMISS_OK);
+    int count = cachemiss_legal_moves(engine, moves);
+    ASSERT_EQ(count, 3);  // Off the first rank: d2, e2, f2
+    for (int i = 0; i < count; ++i) ASSERT_EQ(std::strncmp(moves[i], "e1", 2), 0);
+
+    // A rook up for the side to move
+    ASSERT_EQ(cachemiss_set_position(engine, "4k3/8/8/8/8/8/8/R3K3 w - - 0 1", nullptr, 0), CACHEMISS_OK);
+    ASSERT_GT(cachemiss_evaluate(engine), 300);
+    cachemiss_destroy(engine);
+}
+
+// ============================================================================
+// Search Tests
+// ============================================================================
+
+static void test_capi_search_mate() {
+    cachemiss_engine* engine = cachemiss_create(1);
+    ASSERT_EQ(cachemiss_set_position(engine, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", nullptr, 0), CACHEMISS_OK);
+    cachemiss_limits limits = {4, 0, 0};
+    cachemiss_result result;
+    ASSERT_EQ(cachemiss_search(engine, &limits, &result), CACHEMISS_OK);
+    ASSERT_EQ(std::string(result.best_move), std::string("a1a8"));
+    ASSERT_EQ(result.mate, 1);
+    ASSERT_EQ(result.pv_length, 1);
+    ASSERT_GT(result.nodes, 0ULL);
+    cachemiss_destroy(engine);
+}
+
+static void test_capi_instances_in_parallel() {
+    // Node-limited searches give the same result alone and side by side
+    cachemiss_limits limits = {0, 20000, 0};
+    auto run = [&limits](cachemiss_result& result) {
+        cachemiss_engine* engine = cachemiss_create(1);
+        const char* moves[] = {"d2d4", "g8f6"};
+        cachemiss_set_position(engine, nullptr, moves, 2);
+        cachemiss_search(engine, &limits, &result);
+        cachemiss_destroy(engine);
+    };
+    cachemiss_result alone, first, second;
+    run(alone);
+    std::thread a(run, std::ref(first));
+    std::thread b(run, std::ref(second));
+    a.join();
+    b.join();
+
+    ASSERT_EQ(alone.nodes, 20000ULL);
+    for (const cachemiss_result* r : {&first, &second}) {
+        ASSERT_EQ(std::string(r->best_move), std::string(alone.best_move));
+        ASSERT_EQ(r->nodes, alone.nodes);
+        ASSERT_EQ(r->score_cp, alone.score_cp);
+    }
+}
+
+// Registration function
+void register_capi_tests() {
+    REGISTER_TEST(CAPI, SetPosition, test_capi_set_position);
+    REGISTER_TEST(CAPI, LegalMovesAndEval, test_capi_legal_moves_and_eval);
+    REGISTER_TEST(CAPI, SearchMate, test_capi_search_mate);
+    REGISTER_TEST(CAPI, InstancesInParallel, test_capi_instances_in_parallel);
+}
@@ -0,0 +1,78 @@
+// test_cgroup.cpp - Container (cgroup v1/v2) limit detection tests
+#include "test_framework.hpp"
+#include "cgroup.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Fake /proc/self/cgroup plus cgroup files under a scratch mount point
+static std::string make_cgroup_tree(const std::string& name, const std::string& proc_cgroup,
+                                    const std::vector<std::pair<std::string, std::string>>& files) {
+    std::string root = "/tmp/cachemiss_test_cgroup_" + name;
+    std::filesystem::remove_all(root);
+    for (const auto& [path, content] : files) {
+        std::filesystem::create_directories(std::filesystem::path(root + "/mnt/" + path).parent_path());
+        std::ofstream(root + "/mnt/" + path) << content;
+    }
+    std::ofstream(root + "/cgroup") << proc_cgroup;
+    return root;
+}
+
+static void test_cgroup_v2_limits() {
+    // The tightest limit on the path wins, wherever it is set
+    std::string root = make_cgroup_tree("v2", "0::/bot/engine\n", {
+        {"cgroup.controllers", "cpu memory"},
+        {"bot/memory.max", "1073741824"},
+        {"bot/cpu.max", "150000 100000"},
+        {"bot/engine/memory.max", "max"},
+        {"bot/engine/cpu.max", "max 100000"},
+        {"bot/cpu.stat", "usage_usec 500\nnr_throttled 3\nthrottled_usec 42000\n"},
+    });
+    CgroupLimits limits = read_cgroup_limits(root + "/cgroup", root + "/mnt");
+    ASSERT_EQ(limits.version, 2);
+    ASSERT_EQ(limits.memory_bytes, 1073741824ULL);
+    ASSERT_EQ(limits.cpu_quota_us, 150000ULL);
+    ASSERT_EQ(limits.cpus(), 2);
+    ASSERT_EQ(max_hash_mb(limits), size_t(512));
+    ASSERT_EQ(read_throttled_us(limits.cpu_stat_path), 42000ULL);
+    std::filesystem::remove_all(root);
+}
+
+static void test_cgroup_v1_limits() {
+    // Unlimited memory and quota (-1) read as no limit
+    std::string root = make_cgroup_tree("v1", "5:memory:/docker/abc\n3:cpu,cpuacct:/docker/abc\n", {
+        {"memory/docker/abc/memory.limit_in_bytes", "9223372036854771712"},
+        {"cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "-1"},
+        {"cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000"},
+    });
+    CgroupLimits limits = read_cgroup_limits(root + "/cgroup", root + "/mnt");
+    ASSERT_EQ(limits.version, 1);
+    ASSERT_EQ(limits.memory_bytes, 0ULL);
+    ASSERT_EQ(limits.cpus(), 0);
+    ASSERT_EQ(max_hash_mb(limits), size_t(0));
+
+    std::ofstream(root + "/mnt/memory/docker/abc/memory.limit_in_bytes") << "268435456";
+    std::ofstream(root + "/mnt/cpu,cpuacct/docker/abc/cpu.cfs_quota_us") << "50000";
+    limits = read_cgroup_limits(root + "/cgroup", root + "/mnt");
+    ASSERT_EQ(max_hash_mb(limits), size_t(128));
+    ASSERT_EQ(limits.cpus(), 1);
+
+    // Throttling since the previous move reserves one period
+    std::string stat = root + "/mnt/cpu,cpuacct/docker/abc/cpu.stat";
+    std::ofstream(stat) << "nr_periods 10\nnr_throttled 0\nthrottled_time 0\n";
+    ThrottleMonitor monitor(limits);
+    ASSERT_EQ(monitor.margin_ms(), 0);
+    std::ofstream(stat) << "nr_periods 20\nnr_throttled 2\nthrottled_time 30000000\n";
+    ASSERT_EQ(monitor.margin_ms(), 100);
+    ASSERT_EQ(monitor.last_throttled_us(), 30000ULL);
+    ASSERT_EQ(monitor.margin_ms(), 0);
+    std::filesystem::remove_all(root);
+}
+
+// Registration function
+void register_cgroup_tests() {
+    REGISTER_TEST(Cgroup, V2Limits, test_cgroup_v2_limits);
+    REGISTER_TEST(Cgroup, V1Limits, test_cgroup_v1_limits);
+}
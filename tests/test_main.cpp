@@ -13,6 +13,9 @@ void register_hash_tests();
 void register_board_tests();
 void register_perft_tests();
 void register_uci_tests();
+void register_trace_tests();
+void register_capi_tests();
+void register_cgroup_tests();
 
 int main(int argc, char* argv[]) {
     // Initialize zobrist hashing before any tests
@@ -33,6 +36,9 @@ int main(int argc, char* argv[]) {
     register_board_tests();
     register_perft_tests();
     register_uci_tests();
+    register_trace_tests();
+    register_capi_tests();
+    register_cgroup_tests();
 
     // Run tests
     return TestRunner::instance().run(filter);
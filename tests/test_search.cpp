@@ -1,13 +1,14 @@
 // test_search.cpp - Search feature tests
 #include "test_framework.hpp"
+#include "analyze.hpp"
 #include "board.hpp"
+#include "eval.hpp"
 #include "move.hpp"
 #include "search.hpp"
 #include "ttable.hpp"
 #include <chrono>
-
-// Constants from search.cpp
-constexpr int MATE_SCORE = 29000;
+#include <sstream>
+#include <thread>
 
 // Square indices
 constexpr int E1 = 4, E8 = 60;
@@ -211,6 +212,118 @@ static void test_depth_limit() {
     ASSERT_GE(result.depth, 5);
 }
 
+static void test_node_limit() {
+    Board board;
+
+    // A node limit stops the search at the same point every time
+    TTable tt(1);
+    SearchLimits limits;
+    limits.nodes = 20000;
+    auto first = search(board, tt, limits);
+    tt.clear();
+    auto second = search(board, tt, limits);
+
+    ASSERT_TRUE(first.best_move.data != 0);
+    ASSERT_EQ(first.nodes, 20000ULL);
+    ASSERT_EQ(second.nodes, first.nodes);
+    ASSERT_EQ(second.best_move.data, first.best_move.data);
+}
+
+static void test_independent_search_threads() {
+    // Searches with their own TT and pawn cache can run side by side
+    // (tools/match -inprocess) and match a search run alone
+    SearchLimits limits;
+    limits.nodes = 20000;
+    limits.silent = true;
+    Board reference_board;
+    TTable reference_tt(1);
+    auto reference = search(reference_board, reference_tt, limits);
+
+    SearchResult results[2];
+    std::thread threads[2];
+    for (int i = 0; i < 2; ++i) {
+        threads[i] = std::thread([&limits, &result = results[i]] {
+            PawnCache pawn_cache(1);
+            t_pawn_cache = &pawn_cache;
+            Board board;
+            TTable tt(1);
+            result = search(board, tt, limits);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    for (const auto& result : results) {
+        ASSERT_EQ(result.nodes, reference.nodes);
+        ASSERT_EQ(result.best_move.data, reference.best_move.data);
+        ASSERT_EQ(result.score, reference.score);
+    }
+}
+
+static void test_excluded_root_moves() {
+    // Without the winning capture the search reports another move, and
+    // leaves no root entry that a full search could mistake for its own
+    Board board("7k/8/4n3/3P4/8/8/8/K7 w - - 0 1");
+    Move32 capture = parse_uci_move("d5e6", board);
+    TTable tt(1);
+    SearchLimits limits;
+    limits.depth = 4;
+    limits.silent = true;
+    limits.exclude = &capture;
+    limits.exclude_count = 1;
+    auto result = search(board, tt, limits);
+
+    ASSERT_TRUE(result.best_move.data != 0);
+    ASSERT_FALSE(result.best_move.same_move(capture));
+    ASSERT_TRUE(tt.find(board.hash) == nullptr);
+}
+
+static void test_analyze_in_input_order() {
+    std::istringstream in(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1\n"
+        "# comment\n"
+        "7k/8/4n3/3P4/8/8/8/K7 w - - bm dxe6; id \"capture\";\n"
+        "R5k1/5ppp/8/8/8/8/8/4K3 b - - 0 1\n");
+    std::ostringstream out;
+    AnalyzeOptions options;
+    options.threads = 3;
+    options.depth = 3;
+    options.multipv = 2;
+    ASSERT_EQ(analyze_positions(in, out, options), size_t(3));
+
+    std::istringstream results(out.str());
+    std::string first, second, third;
+    std::getline(results, first);
+    std::getline(results, second);
+    std::getline(results, third);
+    ASSERT_EQ(first.rfind("{\"line\":1,", 0), size_t(0));
+    ASSERT_EQ(second.rfind("{\"line\":3,\"id\":\"capture\"", 0), size_t(0));
+    ASSERT_TRUE(second.find("\"bestmove\":\"d5e6\"") != std::string::npos);
+    ASSERT_TRUE(second.find("},{\"move\"") != std::string::npos);  // Two lines
+    ASSERT_EQ(third.rfind("{\"line\":4,", 0), size_t(0));
+    ASSERT_TRUE(third.find("\"bestmove\":null") != std::string::npos);  // Checkmated
+}
+
+static void test_analyze_rejects_positions_without_kings() {
+    std::istringstream in(
+        "hello world foo bar\n"
+        "8/8/8/8/8/8/8/8 w - -\n"
+        "4k3/8/8/8/8/8/8/4K2K w - - 0 1\n"
+        "4k3/8/8/8/8/8/8/4K3 w - - 0 1\n");
+    std::ostringstream out;
+    AnalyzeOptions options;
+    options.depth = 2;
+    ASSERT_EQ(analyze_positions(in, out, options), size_t(4));
+
+    std::istringstream results(out.str());
+    std::string line;
+    for (int i = 1; i <= 3; ++i) {
+        std::getline(results, line);
+        ASSERT_EQ(line, "{\"line\":" + std::to_string(i) + ",\"error\":\"not a FEN or EPD record\"}");
+    }
+    std::getline(results, line);
+    ASSERT_TRUE(line.find("\"bestmove\":\"") != std::string::npos);
+}
+
 // ============================================================================
 // PV Tests
 // ============================================================================
@@ -286,6 +399,30 @@ static void test_tt_new_search_call() {
     ASSERT_TRUE(true);
 }
 
+static void test_tt_resize_and_parallel_clear() {
+    TTable tt(1);
+    Board board;
+    Move32 move(0);
+    for (u64 i = 1; i <= 1000; ++i) {
+        tt.store(i * 0x9E3779B97F4A7C15ULL, 5, 0, 10, TT_EXACT, move);
+    }
+    ASSERT_GT(tt.count_occupied(), 0u);
+
+    // Resize leaves entries undefined until clear; clear with several threads
+    tt.resize(128);
+    ASSERT_EQ(tt.size(), size_t(128) * 1024 * 1024 / sizeof(TTEntry));
+    tt.clear(4);
+    ASSERT_EQ(tt.count_occupied(), 0u);
+
+    // Table is usable after the parallel clear
+    u64 hash = board.hash;
+    tt.store(hash, 5, 0, 42, TT_EXACT, move);
+    int score = 0;
+    Move32 best(0);
+    ASSERT_TRUE(tt.probe(hash, 5, 0, -100, 100, score, best));
+    ASSERT_EQ(score, 42);
+}
+
 // Registration function
 void register_search_tests() {
     REGISTER_TEST(Search, MateInOne, test_mate_in_one);
@@ -303,10 +440,16 @@ void register_search_tests() {
 
     REGISTER_TEST(Search, RespectsTime, test_search_respects_time);
     REGISTER_TEST(Search, DepthLimit, test_depth_limit);
+    REGISTER_TEST(Search, NodeLimit, test_node_limit);
+    REGISTER_TEST(Search, IndependentSearchThreads, test_independent_search_threads);
+    REGISTER_TEST(Search, ExcludedRootMoves, test_excluded_root_moves);
+    REGISTER_TEST(Search, AnalyzeInInputOrder, test_analyze_in_input_order);
+    REGISTER_TEST(Search, AnalyzeRejectsPositionsWithoutKings, test_analyze_rejects_positions_without_kings);
 
     REGISTER_TEST(Search, PVNotEmpty, test_pv_not_empty);
     REGISTER_TEST(Search, PVIsLegal, test_pv_is_legal);
 
     REGISTER_TEST(Search, TTImprovesSearch, test_tt_improves_search);
     REGISTER_TEST(Search, TTNewSearchCall, test_tt_new_search_call);
+    REGISTER_TEST(Search, TTResizeAndParallelClear, test_tt_resize_and_parallel_clear);
 }
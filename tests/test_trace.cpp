@@ -0,0 +1,87 @@
+// test_trace.cpp - Chrome trace-event export tests
+#include "test_framework.hpp"
+#include "trace.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static size_t count_occurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// ============================================================================
+// Trace Output Tests
+// ============================================================================
+
+static void test_trace_disabled_records_nothing() {
+    std::string path = "/tmp/cachemiss_test_trace_disabled.json";
+    trace::instant("before_open");
+    ASSERT_TRUE(trace::open(path));
+    trace::close();
+
+    std::string json = read_file(path);
+    ASSERT_EQ(count_occurrences(json, "before_open"), 0u);
+    std::remove(path.c_str());
+}
+
+static void test_trace_spans_and_instants() {
+    std::string path = "/tmp/cachemiss_test_trace.json";
+    ASSERT_TRUE(trace::open(path));
+    ASSERT_TRUE(trace::enabled());
+
+    {
+        trace::Span span("iteration", {"depth", 7});
+    }
+    trace::instant("stop");
+    trace::close();
+    ASSERT_FALSE(trace::enabled());
+
+    std::string json = read_file(path);
+    ASSERT_EQ(json.front(), '[');
+    ASSERT_EQ(json.substr(json.size() - 2), "]\n");
+    ASSERT_EQ(count_occurrences(json, "\"name\":\"iteration\",\"ph\":\"X\""), 1u);
+    ASSERT_EQ(count_occurrences(json, "\"args\":{\"depth\":7}"), 1u);
+    ASSERT_EQ(count_occurrences(json, "\"name\":\"stop\",\"ph\":\"i\""), 1u);
+    std::remove(path.c_str());
+}
+
+static void test_trace_keeps_events_of_exited_threads() {
+    std::string path = "/tmp/cachemiss_test_trace_threads.json";
+    ASSERT_TRUE(trace::open(path));
+
+    // Buffers outlive their thread until the next flush
+    for (int i = 0; i < 2; ++i) {
+        std::thread worker([] {
+            trace::set_thread_name("search");
+            trace::Span span("aspiration", {"alpha", -50}, {"beta", 50});
+        });
+        worker.join();
+        trace::flush();
+    }
+    trace::close();
+
+    std::string json = read_file(path);
+    ASSERT_EQ(count_occurrences(json, "\"name\":\"aspiration\""), 2u);
+    ASSERT_EQ(count_occurrences(json, "\"args\":{\"name\":\"search\"}"), 2u);
+    std::remove(path.c_str());
+}
+
+// Registration function
+void register_trace_tests() {
+    REGISTER_TEST(Trace, DisabledRecordsNothing, test_trace_disabled_records_nothing);
+    REGISTER_TEST(Trace, SpansAndInstants, test_trace_spans_and_instants);
+    REGISTER_TEST(Trace, KeepsEventsOfExitedThreads, test_trace_keeps_events_of_exited_threads);
+}
@@ -1,9 +1,18 @@
 // test_uci.cpp - UCI protocol parsing tests
 #include "test_framework.hpp"
 #include "board.hpp"
+#include "engine_server.hpp"
 #include "move.hpp"
+#include "info_writer.hpp"
 #include "uci.hpp"
 #include "search.hpp"
+#include "telemetry.hpp"
+#include "trace.hpp"
+#include "ttable.hpp"
+#include <atomic>
+#include <climits>
+#include <sstream>
+#include <thread>
 
 // Helper to apply UCI move
 static void apply_move(Board& board, const std::string& uci) {
@@ -57,6 +66,51 @@ static void test_position_fen_moves() {
     ASSERT_EQ(board.hash, expected.hash);
 }
 
+// Parse line both with the cache and from scratch; board and hashes must match
+static void assert_same_as_fresh(const std::string& line, Board& board, std::vector<u64>& hashes,
+                                 PositionCache& cache) {
+    parse_position_command(line, board, hashes, &cache);
+
+    Board fresh;
+    std::vector<u64> fresh_hashes;
+    parse_position_command(line, fresh, fresh_hashes);
+
+    ASSERT_EQ(board.hash, fresh.hash);
+    ASSERT_EQ(board.to_fen(), fresh.to_fen());
+    ASSERT_TRUE(hashes == fresh_hashes);
+}
+
+static void test_position_incremental_extends() {
+    Board board;
+    std::vector<u64> hashes;
+    PositionCache cache;
+    assert_same_as_fresh("position startpos moves e2e4 e7e5", board, hashes, cache);
+    assert_same_as_fresh("position startpos moves e2e4 e7e5 g1f3", board, hashes, cache);
+    assert_same_as_fresh("position startpos moves e2e4 e7e5 g1f3 b8c6 f1b5", board, hashes, cache);
+    ASSERT_EQ(cache.moves.size(), 5u);
+
+    // Same position again (e.g. a repeated "position" before "go")
+    assert_same_as_fresh("position startpos moves e2e4 e7e5 g1f3 b8c6 f1b5", board, hashes, cache);
+}
+
+static void test_position_incremental_fallback() {
+    Board board;
+    std::vector<u64> hashes;
+    PositionCache cache;
+    assert_same_as_fresh("position startpos moves e2e4 e7e5 g1f3", board, hashes, cache);
+
+    // Takeback, diverging move list and a different base all rebuild
+    assert_same_as_fresh("position startpos moves e2e4 e7e5", board, hashes, cache);
+    assert_same_as_fresh("position startpos moves d2d4 d7d5", board, hashes, cache);
+    assert_same_as_fresh("position fen r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w KQkq - 0 1 moves e1g1",
+                         board, hashes, cache);
+
+    // A board changed behind the cache's back is rebuilt too
+    board = Board();
+    assert_same_as_fresh("position fen r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w KQkq - 0 1 moves e1g1 e8c8",
+                         board, hashes, cache);
+}
+
 // ============================================================================
 // Go Command Parsing Tests
 // ============================================================================
@@ -79,6 +133,16 @@ static void test_go_infinite() {
     ASSERT_FALSE(params.is_ponder);
 }
 
+static void test_go_nodes() {
+    Board board;
+    GoParams params = parse_go_command("go nodes 20000", board, 0, 100);
+
+    // Node-limited search runs without a time limit
+    ASSERT_EQ(params.node_limit, 20000ULL);
+    ASSERT_GT(params.time_ms, 100000000);
+    ASSERT_FALSE(params.is_ponder);
+}
+
 static void test_go_ponder() {
     Board board;
     GoParams params = parse_go_command("go ponder wtime 60000 btime 60000", board, 0, 100);
@@ -237,15 +301,286 @@ static void test_ponder_stores_normal_time() {
     ASSERT_LT(params.normal_time_ms, 10000);
 }
 
+static void test_rank_ponder_replies() {
+    // After 1. e4: the opponent's replies, scored from white's point of view
+    Board parent;
+    apply_move(parent, "e2e4");
+    TTable tt(1);
+    auto store_reply = [&](const std::string& reply, int score, int depth) {
+        Board child = parent;
+        apply_move(child, reply);
+        tt.store(child.hash, depth, 0, score, TT_LOWER, Move32(0));
+    };
+    store_reply("e7e5", -10, 6);  // Predicted reply
+    store_reply("c7c5", 20, 4);
+    store_reply("e7e6", 35, 4);
+    store_reply("g8f6", 20, 5);
+    store_reply("a7a6", 90, 3);
+
+    Move32 predicted = parse_uci_move("e7e5", parent);
+    std::vector<Move32> ranked = rank_ponder_replies(parent, tt, predicted, 3);
+
+    // Lowest score for white first, deeper entry first on a tie; unscored and
+    // predicted replies left out
+    ASSERT_EQ(ranked.size(), 3u);
+    ASSERT_EQ(ranked[0].to_uci(), "g8f6");
+    ASSERT_EQ(ranked[1].to_uci(), "c7c5");
+    ASSERT_EQ(ranked[2].to_uci(), "e7e6");
+    ASSERT_EQ(rank_ponder_replies(parent, tt, predicted, 8).size(), 4u);
+}
+
+// ============================================================================
+// Setoption Tests
+// ============================================================================
+
+static void test_setoption_ignores_unknown_options() {
+    // GUIs send options we don't have, with values that aren't numbers
+    std::istringstream in("setoption name UCI_Chess960 value false\n"
+                          "setoption name UCI_AnalyseMode value true\n"
+                          "setoption name LMR_BASE value fast\n"
+                          "isready\n");
+    std::ostringstream out;
+    uci_session(in, out, 1);
+    ASSERT_TRUE(out.str().find("readyok") != std::string::npos);
+}
+
+// ============================================================================
+// Info Output Tests
+// ============================================================================
+
+static void test_info_score_cp_and_fields() {
+    Board board;
+    Move32 pv[2] = {parse_uci_move("e2e4", board), Move32(0)};
+    apply_move(board, "e2e4");
+    pv[1] = parse_uci_move("e7e5", board);
+
+    InfoWriter info;
+    std::string line(info.format_pv(5, 9, 34, ScoreBound::Exact, 20000, 100, 12, pv, 2));
+    ASSERT_EQ(line, std::string("info depth 5 seldepth 9 score cp 34 nodes 20000 nps 200000 "
+                                "hashfull 12 time 100 pv e2e4 e7e5"));
+}
+
+static void test_info_score_mate_and_bounds() {
+    InfoWriter info;
+    // Mate in 2 (3 plies) for us, mated in 1 (2 plies) against us
+    std::string win(info.format_pv(4, 4, 29000 - 3, ScoreBound::Exact, 100, 0, 0, nullptr, 0));
+    ASSERT_TRUE(win.find("score mate 2 ") != std::string::npos);
+    std::string loss(info.format_pv(4, 4, -29000 + 2, ScoreBound::Exact, 100, 0, 0, nullptr, 0));
+    ASSERT_TRUE(loss.find("score mate -1 ") != std::string::npos);
+
+    std::string lower(info.format_pv(8, 12, 50, ScoreBound::Lower, 100, 0, 0, nullptr, 0));
+    ASSERT_TRUE(lower.find("score cp 50 lowerbound ") != std::string::npos);
+    std::string upper(info.format_pv(8, 12, -50, ScoreBound::Upper, 100, 0, 0, nullptr, 0));
+    ASSERT_TRUE(upper.find("score cp -50 upperbound ") != std::string::npos);
+}
+
+static void test_info_currmove_promotion() {
+    Board board("8/P7/8/8/8/8/8/k6K w - - 0 1");
+    InfoWriter info;
+    std::string line(info.format_currmove(12, parse_uci_move("a7a8q", board), 3));
+    ASSERT_EQ(line, std::string("info depth 12 currmove a7a8q currmovenumber 3"));
+}
+
+// ============================================================================
+// Engine Server Tests
+// ============================================================================
+
+static void test_hash_pool_partitions() {
+    HashPool pool(256);
+    ASSERT_EQ(pool.acquire(1, 512), size_t(256));  // Alone: the whole budget
+    ASSERT_EQ(pool.acquire(2, 512), size_t(128));  // Its share, before session 1 gives any back
+    ASSERT_EQ(pool.acquire(1, 512), size_t(128));  // Session 1 rebalanced: its even share
+    ASSERT_EQ(pool.acquire(2, 512), size_t(128));
+    ASSERT_EQ(pool.allocated_mb(), size_t(256));
+
+    pool.release(1);
+    ASSERT_EQ(pool.acquire(2, 64), size_t(64));    // Never more than asked for
+    ASSERT_EQ(pool.acquire(2, 512), size_t(256));
+}
+
+static void test_hash_pool_rebalances_on_join() {
+    // A session joining a fully allocated pool gets its share at once, and
+    // only the sessions holding more than theirs are asked to shrink
+    HashPool pool(300);
+    int calls[4] = {0, 0, 0, 0};
+    for (int id = 1; id <= 3; ++id) pool.on_rebalance(id, [&calls, id] { calls[id]++; });
+    ASSERT_EQ(pool.acquire(1, 512), size_t(300));
+    ASSERT_EQ(pool.acquire(2, 100), size_t(100));  // Under its share
+    ASSERT_EQ(calls[1], 1);
+    ASSERT_EQ(pool.acquire(1, 512), size_t(150));
+    ASSERT_EQ(pool.allocated_mb(), size_t(250));
+
+    ASSERT_EQ(pool.acquire(3, 512), size_t(100));
+    ASSERT_EQ(calls[1], 2);  // 150 > 100
+    ASSERT_EQ(calls[2], 0);  // 100 is its share
+    ASSERT_EQ(calls[3], 0);
+    ASSERT_EQ(pool.acquire(1, 512), size_t(100));
+    ASSERT_EQ(pool.allocated_mb(), size_t(300));
+
+    pool.release(1);  // Released sessions are not called again
+    pool.acquire(3, 512);
+    pool.acquire(2, 512);
+    ASSERT_EQ(calls[1], 2);
+}
+
+static void test_tt_rescale_keeps_entries() {
+    TTable tt(2);
+    Board board;
+    Move32 move = parse_uci_move("e2e4", board);
+    tt.store(board.hash, 7, 0, 25, TT_EXACT, move);
+
+    tt.rescale(1);  // Shrink: the entry folds into the smaller table
+    const TTEntry* entry = tt.find(board.hash);
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry->depth, 7);
+    ASSERT_TRUE(entry->best_move.same_move(move));
+
+    tt.rescale(4);  // Grow: still found wherever its index now points
+    entry = tt.find(board.hash);
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry->score, 25);
+}
+
+static void test_scheduler_urgency_order() {
+    SearchScheduler scheduler(1);
+    u64 first = scheduler.acquire(1000, false);
+
+    std::vector<int> order;
+    std::mutex order_mutex;
+    auto waiter = [&](int urgency_ms) {
+        return std::thread([&, urgency_ms] {
+            u64 ticket = scheduler.acquire(urgency_ms, false);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(urgency_ms);
+            }
+            scheduler.release(ticket);
+        });
+    };
+    std::thread slow = waiter(5000);
+    while (scheduler.waiting() < 1) std::this_thread::yield();
+    std::thread fast = waiter(50);
+    while (scheduler.waiting() < 2) std::this_thread::yield();
+
+    scheduler.release(first);
+    slow.join();
+    fast.join();
+    ASSERT_EQ(order.size(), size_t(2));
+    ASSERT_EQ(order[0], 50);  // Less time to think goes first
+    ASSERT_EQ(order[1], 5000);
+}
+
+static void test_scheduler_preempts_ponder() {
+    SearchScheduler scheduler(1);
+    std::atomic<bool> stopped{false};
+    u64 ponder = scheduler.acquire(INT_MAX, true, [&] { stopped.store(true); });
+
+    std::thread timed([&] { scheduler.release(scheduler.acquire(100, false)); });
+    while (!stopped.load()) std::this_thread::yield();  // The timed search asked for the slot
+    scheduler.release(ponder);
+    timed.join();
+    ASSERT_EQ(scheduler.running(), 0);
+}
+
+static void test_scheduler_cancels_waiting() {
+    // A queued search stopped by its session leaves the queue at once
+    SearchScheduler scheduler(1);
+    u64 busy = scheduler.acquire(60000, false);
+
+    u64 ticket = scheduler.enqueue(INT_MAX, true);
+    std::atomic<int> admitted{-1};
+    std::thread waiter([&] { admitted.store(scheduler.wait(ticket) ? 1 : 0); });
+    while (scheduler.waiting() < 1) std::this_thread::yield();
+    scheduler.cancel(ticket);
+    waiter.join();
+    ASSERT_EQ(admitted.load(), 0);
+    ASSERT_EQ(scheduler.waiting(), 0);
+
+    // ... also when its stop flag was set before it started waiting
+    std::atomic<bool> stop{true};
+    ASSERT_FALSE(scheduler.wait(scheduler.enqueue(100, false), [&] { return stop.load(); }));
+    ASSERT_EQ(scheduler.waiting(), 0);
+    ASSERT_EQ(scheduler.running(), 1);
+    scheduler.release(busy);
+}
+
+static void test_sessions_run_side_by_side() {
+    // Two sessions at once, each with its own position, table and output
+    auto session = [](const std::string& position, std::string& output) {
+        std::istringstream in("uci\nisready\n" + position + "\ngo depth 3\n");
+        std::ostringstream out;
+        uci_session(in, out, 1);
+        output = out.str();
+    };
+    std::string out_a, out_b;
+    std::thread a(session, "position startpos", std::ref(out_a));
+    std::thread b(session, "position fen 6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1", std::ref(out_b));
+    a.join();
+    b.join();
+
+    ASSERT_TRUE(out_a.find("uciok") != std::string::npos);
+    ASSERT_TRUE(out_a.find("readyok") != std::string::npos);
+    ASSERT_TRUE(out_a.find("bestmove ") != std::string::npos);
+    ASSERT_TRUE(out_b.find("bestmove a1a8") != std::string::npos);  // Back-rank mate
+}
+
+static void test_stop_while_queued_plays_a_move() {
+    // Every slot is busy: stop ends the wait, and bestmove is still legal
+    HashPool pool(4);
+    SearchScheduler scheduler(1);
+    u64 busy = scheduler.acquire(60000, false);
+    std::ostringstream search_out;
+    SessionShare share{pool, scheduler, 1, search_out};
+    std::istringstream in("position startpos moves e2e4\n"
+                          "go wtime 60000 btime 60000\n"
+                          "stop\n");
+    std::ostringstream out;
+    uci_session(in, out, 1, &share);
+    scheduler.release(busy);
+
+    std::string text = out.str();
+    size_t at = text.find("bestmove ");
+    ASSERT_TRUE(at != std::string::npos);
+    Board board;
+    apply_move(board, "e2e4");
+    Move32 move = parse_uci_move(text.substr(at + 9, 4), board);
+    ASSERT_TRUE(move.data != 0);
+}
+
+static void test_server_session_refuses_process_logs() {
+    // Telemetry and trace are per process: a server session can't open them
+    HashPool pool(4);
+    SearchScheduler scheduler(1);
+    std::ostringstream search_out;
+    SessionShare share{pool, scheduler, 1, search_out};
+    std::istringstream in("uci\n"
+                          "setoption name Telemetry File value /tmp/cachemiss_test_session.jsonl\n"
+                          "setoption name Trace File value /tmp/cachemiss_test_session.json\n"
+                          "isready\n");
+    std::ostringstream out;
+    uci_session(in, out, 1, &share);
+
+    std::string text = out.str();
+    ASSERT_TRUE(text.find("option name Telemetry File") == std::string::npos);
+    ASSERT_TRUE(text.find("info string Telemetry File is not available in server sessions") != std::string::npos);
+    ASSERT_TRUE(text.find("info string Trace File is not available in server sessions") != std::string::npos);
+    ASSERT_TRUE(text.find("readyok") != std::string::npos);
+    ASSERT_FALSE(g_telemetry.is_open());
+    ASSERT_FALSE(trace::enabled());
+}
+
 // Registration function
 void register_uci_tests() {
     REGISTER_TEST(UCI, PositionStartpos, test_position_startpos);
     REGISTER_TEST(UCI, PositionStartposMoves, test_position_startpos_moves);
     REGISTER_TEST(UCI, PositionFen, test_position_fen);
     REGISTER_TEST(UCI, PositionFenMoves, test_position_fen_moves);
+    REGISTER_TEST(UCI, PositionIncrementalExtends, test_position_incremental_extends);
+    REGISTER_TEST(UCI, PositionIncrementalFallback, test_position_incremental_fallback);
 
     REGISTER_TEST(UCI, GoMovetime, test_go_movetime);
     REGISTER_TEST(UCI, GoInfinite, test_go_infinite);
+    REGISTER_TEST(UCI, GoNodes, test_go_nodes);
     REGISTER_TEST(UCI, GoPonder, test_go_ponder);
     REGISTER_TEST(UCI, GoTimeWhite, test_go_time_white);
     REGISTER_TEST(UCI, GoTimeBlack, test_go_time_black);
@@ -263,4 +598,20 @@ void register_uci_tests() {
 
     REGISTER_TEST(UCI, PonderhitSetsTime, test_ponderhit_sets_time);
     REGISTER_TEST(UCI, PonderStoresNormalTime, test_ponder_stores_normal_time);
+    REGISTER_TEST(UCI, RankPonderReplies, test_rank_ponder_replies);
+    REGISTER_TEST(UCI, SetoptionIgnoresUnknownOptions, test_setoption_ignores_unknown_options);
+
+    REGISTER_TEST(UCI, InfoScoreCpAndFields, test_info_score_cp_and_fields);
+    REGISTER_TEST(UCI, InfoScoreMateAndBounds, test_info_score_mate_and_bounds);
+    REGISTER_TEST(UCI, InfoCurrmovePromotion, test_info_currmove_promotion);
+
+    REGISTER_TEST(UCI, HashPoolPartitions, test_hash_pool_partitions);
+    REGISTER_TEST(UCI, HashPoolRebalancesOnJoin, test_hash_pool_rebalances_on_join);
+    REGISTER_TEST(UCI, TTRescaleKeepsEntries, test_tt_rescale_keeps_entries);
+    REGISTER_TEST(UCI, SchedulerUrgencyOrder, test_scheduler_urgency_order);
+    REGISTER_TEST(UCI, SchedulerPreemptsPonder, test_scheduler_preempts_ponder);
+    REGISTER_TEST(UCI, SchedulerCancelsWaiting, test_scheduler_cancels_waiting);
+    REGISTER_TEST(UCI, SessionsRunSideBySide, test_sessions_run_side_by_side);
+    REGISTER_TEST(UCI, StopWhileQueuedPlaysAMove, test_stop_while_queued_plays_a_move);
+    REGISTER_TEST(UCI, ServerSessionRefusesProcessLogs, test_server_session_refuses_process_logs);
 }
@@ -0,0 +1,664 @@
+// PGN annotator
+// Searches every position of every game in a PGN file and marks the moves that
+// lost the most against the engine's choice. Each game is analysed from its
+// last move backwards without clearing the hash table in between, so when an
+// earlier position is searched the table already holds the refutations found
+// deeper into the game. Games are spread over a pool of worker threads, each
+// with its own hash table, pawn cache and search controller, and are written
+// in input order.
+//
+// Moves whose score drop (best move vs. move played, from the mover's point of
+// view) reaches -threshold get a "?" ("??" from -blunder); their positions go
+// to an EPD file with the engine's move as "bm" and the played move as "am",
+// ready for bench and test suites.
+//
+// Usage: ./annotate <input.pgn> <output.pgn> [options]
+
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "pawn_cache.hpp"
+#include "search.hpp"
+#include "ttable.hpp"
+#include "zobrist.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Scores are capped here before computing drops, so a move from +25 to +12
+// (or from mate to a big win) is not flagged
+constexpr int SCORE_CAP = 1000;
+
+// Parse SAN move and find matching legal move
+Move32 parse_san_move(const std::string& san, Board& board) {
+    if (san.empty()) return Move32(0);
+
+    // Handle castling
+    if (san == "O-O" || san == "0-0") {
+        MoveList moves = generate_moves(board);
+        for (int i = 0; i < moves.size; ++i) {
+            Move32& m = moves[i];
+            if (m.is_castling()) {
+                int from_file = m.from() % 8;
+                int to_file = m.to() % 8;
+                if (to_file > from_file) {  // Kingside
+                    UndoInfo undo = make_move(board, m);
+                    if (!is_illegal(board)) {
+                        unmake_move(board, m, undo);
+                        return m;
+                    }
+                    unmake_move(board, m, undo);
+                }
+            }
+        }
+        return Move32(0);
+    }
+
+    if (san == "O-O-O" || san == "0-0-0") {
+        MoveList moves = generate_moves(board);
+        for (int i = 0; i < moves.size; ++i) {
+            Move32& m = moves[i];
+            if (m.is_castling()) {
+                int from_file = m.from() % 8;
+                int to_file = m.to() % 8;
+                if (to_file < from_file) {  // Queenside
+                    UndoInfo undo = make_move(board, m);
+                    if (!is_illegal(board)) {
+                        unmake_move(board, m, undo);
+                        return m;
+                    }
+                    unmake_move(board, m, undo);
+                }
+            }
+        }
+        return Move32(0);
+    }
+
+    // Parse SAN components
+    size_t pos = 0;
+    Piece piece = Piece::Pawn;
+    int disambig_file = -1;
+    int disambig_rank = -1;
+    int to_file = -1;
+    int to_rank = -1;
+    Piece promotion = Piece::None;
+
+    // Check for piece letter
+    if (pos < san.size() && san[pos] >= 'A' && san[pos] <= 'Z' && san[pos] != 'O') {
+        switch (san[pos]) {
+            case 'N': piece = Piece::Knight; break;
+            case 'B': piece = Piece::Bishop; break;
+            case 'R': piece = Piece::Rook; break;
+            case 'Q': piece = Piece::Queen; break;
+            case 'K': piece = Piece::King; break;
+            default: return Move32(0);  // Invalid piece
+        }
+        pos++;
+    }
+
+    // Parse file/rank disambiguation and target square
+    // Format can be: e4, xe4, 1e4, exe4, R1e4, Rexe4, etc.
+    std::string coords;
+    for (size_t i = pos; i < san.size(); ++i) {
+        char c = san[i];
+        if (c >= 'a' && c <= 'h') {
+            coords += c;
+        } else if (c >= '1' && c <= '8') {
+            coords += c;
+        } else if (c == 'x') {
+            // Capture marker, skip
+        } else if (c == '+' || c == '#') {
+            // Check/checkmate markers, skip
+        } else if (c == '=') {
+            // Promotion follows
+            if (i + 1 < san.size()) {
+                switch (san[i + 1]) {
+                    case 'Q': promotion = Piece::Queen; break;
+                    case 'R': promotion = Piece::Rook; break;
+                    case 'B': promotion = Piece::Bishop; break;
+                    case 'N': promotion = Piece::Knight; break;
+                }
+            }
+            break;
+        }
+    }
+
+    // Last two characters of coords should be target square
+    if (coords.size() >= 2) {
+        size_t target_start = coords.size() - 2;
+        if (coords[target_start] >= 'a' && coords[target_start] <= 'h' &&
+            coords[target_start + 1] >= '1' && coords[target_start + 1] <= '8') {
+            to_file = coords[target_start] - 'a';
+            to_rank = coords[target_start + 1] - '1';
+
+            // Remaining coords are disambiguation
+            for (size_t i = 0; i < target_start; ++i) {
+                if (coords[i] >= 'a' && coords[i] <= 'h') {
+                    disambig_file = coords[i] - 'a';
+                } else if (coords[i] >= '1' && coords[i] <= '8') {
+                    disambig_rank = coords[i] - '1';
+                }
+            }
+        }
+    }
+
+    if (to_file < 0 || to_rank < 0) {
+        return Move32(0);
+    }
+
+    int to_sq = to_rank * 8 + to_file;
+
+    // Find matching legal move
+    MoveList moves = generate_moves(board);
+    for (int i = 0; i < moves.size; ++i) {
+        Move32& m = moves[i];
+
+        // Check target square
+        if (m.to() != to_sq) continue;
+
+        // Check piece type
+        Piece moving_piece = board.pieces_on_square[m.from()];
+        if (moving_piece != piece) continue;
+
+        // Check disambiguation
+        int from_file = m.from() % 8;
+        int from_rank = m.from() / 8;
+        if (disambig_file >= 0 && from_file != disambig_file) continue;
+        if (disambig_rank >= 0 && from_rank != disambig_rank) continue;
+
+        // Check promotion
+        if (promotion != Piece::None) {
+            if (m.promotion() != promotion) continue;
+        } else {
+            if (m.is_promotion()) continue;  // SAN didn't specify promotion but move is promotion
+        }
+
+        // Verify move is legal
+        UndoInfo undo = make_move(board, m);
+        bool legal = !is_illegal(board);
+        unmake_move(board, m, undo);
+
+        if (legal) {
+            return m;
+        }
+    }
+
+    return Move32(0);
+}
+
+struct Config {
+    std::string input_file;
+    std::string output_file;
+    std::string epd_file;
+    std::string player;      // Only flag this player's moves (White/Black tag)
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int depth = 10;
+    u64 nodes = 0;
+    size_t hash_mb = 16;     // Per worker
+    int threshold = 100;
+    int blunder = 300;
+    int max_games = 0;       // 0 = unlimited
+};
+
+struct Game {
+    std::vector<std::pair<std::string, std::string>> headers;  // In file order
+    std::vector<std::string> moves;                            // SAN, annotations stripped
+    std::string result = "*";
+
+    std::string header(const std::string& tag) const {
+        for (const auto& [name, value] : headers) {
+            if (name == tag) return value;
+        }
+        return "";
+    }
+};
+
+// Split movetext into moves, skipping move numbers, comments, NAGs and variations
+void parse_movetext(const std::string& text, Game& game) {
+    int variation_depth = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+        if (c == '{' || c == ';') {
+            size_t end = text.find(c == '{' ? '}' : '\n', i);
+            i = end == std::string::npos ? text.size() : end + 1;
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            variation_depth = std::max(0, variation_depth + (c == '(' ? 1 : -1));
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end])) &&
+               !std::strchr("{};()", text[end])) {
+            ++end;
+        }
+        std::string token = text.substr(i, end - i);
+        i = end;
+        if (variation_depth > 0 || token[0] == '$') continue;
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+            game.result = token;
+            continue;
+        }
+
+        // Move numbers ("12." / "12...") may be glued to the move
+        size_t start = 0;
+        while (start < token.size() && (std::isdigit(static_cast<unsigned char>(token[start])) || token[start] == '.')) {
+            ++start;
+        }
+        if (start == token.size()) continue;
+        if (start > 0 && token[start - 1] == '.') token = token.substr(start);
+
+        while (!token.empty() && std::strchr("+#!?", token.back())) token.pop_back();
+        if (token == "0-0") token = "O-O";
+        if (token == "0-0-0") token = "O-O-O";
+        if (!token.empty()) game.moves.push_back(token);
+    }
+}
+
+class PGNReader {
+    std::istream& in;
+    std::string line;
+    bool has_line = false;
+
+public:
+    explicit PGNReader(std::istream& input) : in(input) {}
+
+    bool next_game(Game& game) {
+        game = Game();
+        bool in_movetext = false;
+        bool any = false;
+        std::string movetext;
+        while (has_line || std::getline(in, line)) {
+            has_line = false;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] == '%') continue;  // Escaped line
+
+            if (!line.empty() && line[0] == '[') {
+                if (in_movetext) {
+                    has_line = true;  // Start of the next game
+                    break;
+                }
+                size_t space = line.find(' ');
+                size_t quote1 = line.find('"');
+                size_t quote2 = line.rfind('"');
+                if (space != std::string::npos && quote1 != std::string::npos && quote2 > quote1) {
+                    game.headers.emplace_back(line.substr(1, space - 1),
+                                              line.substr(quote1 + 1, quote2 - quote1 - 1));
+                }
+                any = true;
+            } else if (line.find_first_not_of(" \t") != std::string::npos) {
+                in_movetext = true;
+                any = true;
+                movetext += line + '\n';
+            }
+        }
+        parse_movetext(movetext, game);
+        return any;
+    }
+};
+
+// Searcher state owned by one worker thread
+struct Worker {
+    TTable tt;
+    PawnCache pawn_cache;
+    SearchController controller;
+};
+
+struct Analysis {
+    int score = 0;       // Side to move's point of view
+    int depth = 0;
+    Move32 best_move;    // None in checkmate/stalemate
+};
+
+bool in_check(const Board& board) {
+    return is_attacked(board.king_sq[(int)board.turn], opposite(board.turn), board);
+}
+
+bool has_legal_move(Board& board) {
+    MoveList moves = generate_moves(board);
+    for (int i = 0; i < moves.size; ++i) {
+        UndoInfo undo = make_move(board, moves[i]);
+        bool legal = !is_illegal(board);
+        unmake_move(board, moves[i], undo);
+        if (legal) return true;
+    }
+    return false;
+}
+
+// SAN with check/mate suffix
+std::string to_san(const Board& board, Move32 move) {
+    std::string san = move.to_string(board);
+    Board after = board;
+    (void)make_move(after, move);
+    if (in_check(after)) san += has_legal_move(after) ? "+" : "#";
+    return san;
+}
+
+// "+1.25" / "-M3" from White's point of view, for a side-to-move score
+std::string format_score(int score, Color side_to_move) {
+    int sign = side_to_move == Color::White ? 1 : -1;
+    std::ostringstream ss;
+    if (is_mate_score(score)) {
+        int mate = mate_in_moves(score);
+        ss << ((mate > 0) == (sign > 0) ? "+M" : "-M") << std::abs(mate);
+    } else {
+        ss << std::showpos << std::fixed << std::setprecision(2) << sign * score / 100.0;
+    }
+    return ss.str();
+}
+
+struct GameOutput {
+    std::string pgn;
+    std::string epd;
+    int analysed_moves = 0;
+    int flagged = 0;
+};
+
+GameOutput annotate_game(Worker& worker, const Config& cfg, const Game& game, size_t game_number) {
+    // Replay the game; stop at the first move that doesn't parse. A game
+    // whose FEN tag isn't a usable position is copied without analysis.
+    std::string start_fen = game.header("FEN");
+    Board start;
+    bool valid_start = start_fen.empty() || parse_fen(start_fen, start);
+    std::vector<Board> positions{start};
+    std::vector<Move32> moves;
+    std::vector<u64> hashes;  // hashes[i] = positions[i].hash
+    for (const auto& san : game.moves) {
+        if (!valid_start) break;
+        Board board = positions.back();
+        Move32 move = parse_san_move(san, board);
+        if (move.data == 0) break;
+        hashes.push_back(board.hash);
+        (void)make_move(board, move);
+        moves.push_back(move);
+        positions.push_back(board);
+    }
+    int n = static_cast<int>(moves.size());
+
+    // Last position first: the table keeps what later searches learned
+    worker.tt.clear();
+    worker.controller.reset();
+    SearchLimits limits;
+    limits.time_ms = 999999999;
+    limits.depth = cfg.depth;
+    limits.nodes = cfg.nodes;
+    limits.silent = true;
+    limits.controller = &worker.controller;
+
+    std::vector<Analysis> analysis(n + 1);
+    for (int i = n; valid_start && i >= 0; --i) {
+        Board board = positions[i];
+        if (!has_legal_move(board)) {
+            analysis[i].score = in_check(board) ? -MATE_SCORE : 0;
+            continue;
+        }
+        worker.tt.new_search();
+        SearchResult result = search(board, worker.tt, limits, hashes.data(), i);
+        analysis[i] = {result.score, result.depth, result.best_move};
+    }
+
+    // Flag the moves
+    std::string white = game.header("White");
+    std::string black = game.header("Black");
+    GameOutput out;
+    out.analysed_moves = n;
+    std::vector<std::string> nags(n), comments(n);
+    for (int i = 0; i < n; ++i) {
+        const Board& board = positions[i];
+        Color mover = board.turn;
+        const Analysis& after = analysis[i + 1];
+        if (after.best_move.data != 0) {  // No score after a move that ends the game
+            comments[i] = format_score(after.score, positions[i + 1].turn) + "/" + std::to_string(after.depth);
+        }
+
+        const Analysis& before = analysis[i];
+        if (before.best_move.data == 0 || before.best_move.data == moves[i].data) continue;
+        int best = std::clamp(before.score, -SCORE_CAP, SCORE_CAP);
+        int played = std::clamp(-after.score, -SCORE_CAP, SCORE_CAP);
+        int drop = best - played;
+        if (drop < cfg.threshold) continue;
+        if (!cfg.player.empty() && cfg.player != (mover == Color::White ? white : black)) continue;
+
+        std::string best_san = to_san(board, before.best_move);
+        nags[i] = drop >= cfg.blunder ? "??" : "?";
+        comments[i] += (comments[i].empty() ? "best " : " best ") + best_san + " " + format_score(before.score, mover);
+        out.flagged++;
+
+        std::istringstream fields(board.to_fen());
+        std::string placement, side, castling, ep;
+        fields >> placement >> side >> castling >> ep;
+        out.epd += placement + " " + side + " " + castling + " " + ep + " bm " + best_san +
+                   "; am " + to_san(board, moves[i]) + "; id \"game " + std::to_string(game_number) +
+                   " ply " + std::to_string(i + 1) + "\"; c0 \"" + white + " - " + black + ", drop " +
+                   std::to_string(drop) + "\";\n";
+    }
+
+    // Annotated PGN
+    constexpr size_t LINE_WIDTH = 80;
+    std::string& pgn = out.pgn;
+    bool has_annotator = false;
+    for (const auto& [tag, value] : game.headers) {
+        pgn += "[" + tag + " \"" + value + "\"]\n";
+        has_annotator |= tag == "Annotator";
+    }
+    if (!has_annotator) pgn += "[Annotator \"CacheMiss\"]\n";
+    pgn += '\n';
+
+    std::string line;
+    auto emit = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > LINE_WIDTH) {
+            pgn += line + '\n';
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += token;
+    };
+    // Move number from the FEN's 6th field
+    int fullmove = 1;
+    if (!start_fen.empty()) {
+        std::istringstream fields(start_fen);
+        std::string skip;
+        for (int f = 0; f < 5; ++f) fields >> skip;
+        if (!(fields >> fullmove) || fullmove < 1) fullmove = 1;
+    }
+    bool first = true;
+    for (int i = 0; i < n; ++i) {
+        const Board& board = positions[i];
+        std::string san = to_san(board, moves[i]) + nags[i];
+        if (board.turn == Color::White) {
+            emit(std::to_string(fullmove) + ". " + san);
+        } else {
+            emit(first ? std::to_string(fullmove) + "... " + san : san);
+            fullmove++;
+        }
+        if (!comments[i].empty()) emit("{" + comments[i] + "}");
+        first = false;
+    }
+    // Moves after one that doesn't parse are kept as they were
+    for (size_t i = n; i < game.moves.size(); ++i) {
+        if (i == static_cast<size_t>(n)) {
+            emit(valid_start ? "{cannot parse " + game.moves[i] + "; not analysed}" : "{invalid FEN; not analysed}");
+        }
+        emit(game.moves[i]);
+    }
+    emit(game.result);
+    pgn += line + "\n\n";
+    return out;
+}
+
+void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <input.pgn> <output.pgn> [options]\n"
+              << "Options:\n"
+              << "  -epd <file>        Write flagged positions as EPD (bm/am/id)\n"
+              << "  -threads <n>       Games analysed in parallel (default: all CPUs)\n"
+              << "  -depth <d>         Search depth per position (default: 10)\n"
+              << "  -nodes <n>         Node limit per position (default: none)\n"
+              << "  -hash <mb>         Hash table per thread (default: 16)\n"
+              << "  -threshold <cp>    Score drop marked '?' (default: 100)\n"
+              << "  -blunder <cp>      Score drop marked '\?\?' (default: 300)\n"
+              << "  -player <name>     Only flag moves of this player\n"
+              << "  -max-games <n>     Max games to annotate (default: unlimited)\n";
+}
+
+int main(int argc, char* argv[]) {
+    zobrist::init();
+
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Config cfg;
+    cfg.input_file = argv[1];
+    cfg.output_file = argv[2];
+
+    for (int i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "-epd") == 0 && i + 1 < argc) {
+            cfg.epd_file = argv[++i];
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            cfg.threads = std::max(1, std::stoi(argv[++i]));
+        } else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+            cfg.depth = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+            cfg.nodes = std::stoull(argv[++i]);
+        } else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
+            cfg.hash_mb = std::max(1, std::stoi(argv[++i]));
+        } else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc) {
+            cfg.threshold = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-blunder") == 0 && i + 1 < argc) {
+            cfg.blunder = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-player") == 0 && i + 1 < argc) {
+            cfg.player = argv[++i];
+        } else if (strcmp(argv[i], "-max-games") == 0 && i + 1 < argc) {
+            cfg.max_games = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (cfg.nodes > 0 && cfg.depth == 10) cfg.depth = 0;  // -nodes alone replaces the default depth
+
+    std::ifstream infile(cfg.input_file);
+    if (!infile) {
+        std::cerr << "Error: Cannot open " << cfg.input_file << std::endl;
+        return 1;
+    }
+    std::ofstream outfile(cfg.output_file);
+    if (!outfile) {
+        std::cerr << "Error: Cannot write to " << cfg.output_file << std::endl;
+        return 1;
+    }
+    std::ofstream epdfile;
+    if (!cfg.epd_file.empty()) {
+        epdfile.open(cfg.epd_file);
+        if (!epdfile) {
+            std::cerr << "Error: Cannot write to " << cfg.epd_file << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Annotating " << cfg.input_file << " with " << cfg.threads << " threads, "
+              << cfg.hash_mb << " MB hash each\n";
+
+    // Games read ahead of the oldest unfinished one; bounds memory on huge inputs
+    const size_t window = static_cast<size_t>(cfg.threads) * 4;
+
+    struct Job {
+        size_t index;
+        Game game;
+    };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::map<size_t, GameOutput> finished;  // Games waiting for an earlier one
+    size_t next_output = 0;
+    bool input_done = false;
+    u64 total_moves = 0;
+    int total_flagged = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < cfg.threads; ++t) {
+        workers.emplace_back([&] {
+            Worker worker;
+            worker.tt.resize(cfg.hash_mb);
+            t_pawn_cache = &worker.pawn_cache;
+            while (true) {
+                Job job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return !jobs.empty() || input_done; });
+                    if (jobs.empty()) return;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                GameOutput output = annotate_game(worker, cfg, job.game, job.index + 1);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                finished[job.index] = std::move(output);
+                bool wrote = false;
+                for (auto it = finished.begin(); it != finished.end() && it->first == next_output;) {
+                    outfile << it->second.pgn;
+                    if (epdfile.is_open()) epdfile << it->second.epd;
+                    total_moves += it->second.analysed_moves;
+                    total_flagged += it->second.flagged;
+                    it = finished.erase(it);
+                    ++next_output;
+                    wrote = true;
+                }
+                if (wrote) {
+                    outfile.flush();
+                    if (epdfile.is_open()) epdfile.flush();
+                    if (next_output % 100 == 0) std::cout << "Annotated " << next_output << " games" << std::endl;
+                    cv.notify_all();  // The reader may be waiting for the window to move
+                }
+            }
+        });
+    }
+
+    PGNReader reader(infile);
+    Game game;
+    size_t count = 0;
+    while ((cfg.max_games == 0 || count < static_cast<size_t>(cfg.max_games)) && reader.next_game(game)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return count - next_output < window; });
+        jobs.push_back({count++, std::move(game)});
+        lock.unlock();
+        cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        input_done = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Annotated " << count << " games (" << total_moves << " moves) in " << std::fixed
+              << std::setprecision(1) << seconds << " s, flagged " << total_flagged << " moves\n";
+    if (!cfg.epd_file.empty()) std::cout << "Wrote flagged positions to " << cfg.epd_file << "\n";
+    return 0;
+}
@@ -1,25 +1,41 @@
 #include "board.hpp"
+#include "eval.hpp"
 #include "move.hpp"
+#include "search.hpp"
+#include "search_params.hpp"
+#include "ttable.hpp"
+#include "uci.hpp"
 #include "zobrist.hpp"
 
 #include <algorithm>
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <random>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <sched.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/wait.h>
 #include <poll.h>
 #include <csignal>
@@ -69,9 +85,11 @@ public:
 };
 
 static ConsoleBuffer console_buffer;
+static bool console_to_stderr = false;  // Headless: there is no console panel
 
 void console_msg(const std::string& msg) {
     console_buffer.add(msg);
+    if (console_to_stderr) std::cerr << msg << std::endl;
 }
 
 void log_init(const std::string& filename) {
@@ -149,82 +167,242 @@ void close_signal_pipe() {
     }
 }
 
+// ============================================================================
+// CPU affinity
+// ============================================================================
+// Engines can be pinned so each concurrent game has its own core(s) instead
+// of migrating between CPUs or sharing a core with a hyperthread sibling.
+
+struct CpuTopology {
+    std::vector<int> cpus;  // Usable logical CPUs, in pinning order
+    int logical = 0;        // Logical CPUs this process may run on
+    int physical = 0;       // Distinct physical cores among them
+};
+
+static int read_sysfs_int(const std::string& path, int fallback) {
+    std::ifstream in(path);
+    int value;
+    return (in >> value) ? value : fallback;
+}
+
+// CPUs we are allowed to run on, ordered so the first thread of every
+// physical core comes before any SMT sibling. With avoid_smt only the first
+// thread of each core is kept.
+CpuTopology detect_cpus(bool avoid_smt) {
+    CpuTopology topo;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+        return topo;
+    }
+
+    // (sibling index, cpu) so that e.g. cpus 0-7 come before their siblings 8-15
+    std::vector<std::pair<int, int>> ordered;
+    std::map<std::pair<int, int>, int> threads_per_core;  // (package, core) -> threads seen
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &mask)) continue;
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        int package = read_sysfs_int(base + "physical_package_id", 0);
+        int core = read_sysfs_int(base + "core_id", cpu);
+        int sibling = threads_per_core[{package, core}]++;
+        topo.logical++;
+        if (avoid_smt && sibling > 0) continue;
+        ordered.emplace_back(sibling, cpu);
+    }
+    topo.physical = static_cast<int>(threads_per_core.size());
+
+    std::sort(ordered.begin(), ordered.end());
+    for (const auto& [sibling, cpu] : ordered) {
+        topo.cpus.push_back(cpu);
+    }
+    return topo;
+}
+
+// CPU for each engine of each game slot (-1 = not pinned). A game gets two
+// cores when there are enough, otherwise its engines share one core (only the
+// side to move is searching); with more games than CPUs cores are reused.
+std::vector<std::array<int, 2>> plan_affinity(const CpuTopology& topo, int slots) {
+    std::vector<std::array<int, 2>> plan(slots, {-1, -1});
+    int n = static_cast<int>(topo.cpus.size());
+    if (n == 0) return plan;
+    for (int s = 0; s < slots; ++s) {
+        if (n >= 2 * slots) {
+            plan[s] = {topo.cpus[2 * s], topo.cpus[2 * s + 1]};
+        } else {
+            int cpu = topo.cpus[s % n];
+            plan[s] = {cpu, cpu};
+        }
+    }
+    return plan;
+}
+
+// Warnings for running `slots` concurrent games on this machine
+std::vector<std::string> oversubscription_warnings(const CpuTopology& topo, int slots, bool avoid_smt) {
+    std::vector<std::string> warnings;
+    int usable = static_cast<int>(topo.cpus.size());
+    if (usable > 0 && slots > usable) {
+        warnings.push_back("WARNING: " + std::to_string(slots) + " concurrent games on " + std::to_string(usable) +
+                           " CPUs - engines will compete for CPU time (oversubscribed)");
+    } else if (!avoid_smt && topo.physical > 0 && slots > topo.physical) {
+        warnings.push_back("WARNING: " + std::to_string(slots) + " concurrent games on " +
+                           std::to_string(topo.physical) + " physical cores - SMT siblings will share cores (see -nosmt)");
+    }
+    return warnings;
+}
+
 // Move result with stats (declared before Engine class so it can be used as return type)
 struct MoveResult {
     std::string bestmove;
     int depth = 0;
     u64 nodes = 0;
+    int elapsed_ms = 0;  // Wall time from sending "go" to reading "bestmove"
+    int score = 0;       // Last reported score, from the mover's point of view
+    bool mate = false;   // score is "mate <moves>" rather than centipawns
+    bool has_score = false;
 };
 
-// UCI Engine wrapper - manages subprocess communication
-class Engine {
-    FILE* to_engine;
-    int from_engine_fd;  // Raw file descriptor for reading (no FILE* buffering issues)
-    int stderr_fd;       // File descriptor for engine's stderr
-    std::string read_buffer;  // Our own line buffer
-    std::string name;
-    std::string path;
-    pid_t child_pid;
-    static int instance_counter;
-    int instance_id;
-    int current_game_id = -1;  // Set by caller to include in logs
-    std::thread stderr_thread;
-    std::atomic<bool> stopping{false};
+// How each move is limited. Clock mode keeps per-side clocks and charges each
+// engine the measured go -> bestmove latency; the node and depth modes are
+// independent of CPU load.
+struct TimeControl {
+    enum class Mode { MoveTime, Clock, Nodes, Depth };
+    Mode mode = Mode::MoveTime;
+    int movetime_ms = 100;
+    int base_ms = 0;        // Clock: starting time per side
+    int inc_ms = 0;         // Clock: increment per move
+    int margin_ms = 0;      // Clock: overrun tolerated before a time forfeit
+    u64 nodes = 0;
+    int depth = 0;
 
-    std::string log_prefix() const {
-        if (current_game_id >= 0) {
-            return "Engine[" + std::to_string(instance_id) + "] Game[" + std::to_string(current_game_id + 1) + "]";
+    std::string go_command(int wtime_ms, int btime_ms) const {
+        switch (mode) {
+            case Mode::Clock:
+                return "go wtime " + std::to_string(wtime_ms) + " btime " + std::to_string(btime_ms) +
+                       " winc " + std::to_string(inc_ms) + " binc " + std::to_string(inc_ms);
+            case Mode::Nodes: return "go nodes " + std::to_string(nodes);
+            case Mode::Depth: return "go depth " + std::to_string(depth);
+            default:          return "go movetime " + std::to_string(movetime_ms);
         }
-        return "Engine[" + std::to_string(instance_id) + "]";
     }
 
-    std::string short_name() const {
-        size_t pos = path.rfind('/');
-        return (pos != std::string::npos) ? path.substr(pos + 1) : path;
+    // How long to wait for bestmove. Past it the mover has lost on time with
+    // a clock or movetime; under node and depth limits the engine is hung.
+    int read_timeout_ms(int clock_ms) const {
+        switch (mode) {
+            case Mode::Clock:    return clock_ms + margin_ms + 10000;
+            case Mode::MoveTime: return movetime_ms + 10000;
+            default:             return 600000;
+        }
     }
 
-    void stderr_reader() {
-        std::string buffer;
-        char buf[1024];
-        while (!stopping.load()) {
-            struct pollfd pfd;
-            pfd.fd = stderr_fd;
-            pfd.events = POLLIN;
+    std::string describe() const {
+        std::ostringstream ss;
+        switch (mode) {
+            case Mode::Clock:
+                ss << "tc=" << base_ms / 1000.0 << "+" << inc_ms / 1000.0 << "s";
+                if (margin_ms > 0) ss << " margin=" << margin_ms << "ms";
+                break;
+            case Mode::Nodes: ss << "nodes=" << nodes; break;
+            case Mode::Depth: ss << "depth=" << depth; break;
+            default:          ss << "movetime=" << movetime_ms << "ms"; break;
+        }
+        return ss.str();
+    }
+};
 
-            int ret = poll(&pfd, 1, 100);  // 100ms timeout
-            if (ret <= 0) continue;
-
-            if (pfd.revents & POLLIN) {
-                ssize_t n = read(stderr_fd, buf, sizeof(buf) - 1);
-                if (n <= 0) break;
-                buf[n] = '\0';
-                buffer += buf;
-
-                // Process complete lines
-                size_t pos;
-                while ((pos = buffer.find('\n')) != std::string::npos) {
-                    std::string line = buffer.substr(0, pos);
-                    buffer.erase(0, pos + 1);
-                    if (!line.empty()) {
-                        console_msg("[" + short_name() + "] " + line);
-                    }
-                }
-            }
-            if (pfd.revents & (POLLHUP | POLLERR)) break;
+// Ends decided games early from the engines' own scores. Resign: every one
+// of the last resign_moves moves of *both* sides reported |score| >= resign_cp
+// for the same side. Draw: from move draw_after on, the last draw_moves moves
+// of both sides all reported |score| <= draw_cp. A count of 0 disables a rule.
+struct Adjudication {
+    int resign_moves = 0;
+    int resign_cp = 0;
+    int draw_after = 0;     // Full moves played before draw adjudication applies
+    int draw_moves = 0;
+    int draw_cp = 0;
+
+    bool enabled() const { return resign_moves > 0 || draw_moves > 0; }
+
+    std::string describe() const {
+        std::ostringstream ss;
+        if (resign_moves > 0) ss << "resign " << resign_moves << " moves >= " << resign_cp << "cp";
+        if (draw_moves > 0) {
+            if (resign_moves > 0) ss << ", ";
+            ss << "draw " << draw_moves << " moves <= " << draw_cp << "cp after move " << draw_after;
         }
-        // Flush any remaining partial line
-        if (!buffer.empty()) {
-            console_msg("[" + short_name() + "] " + buffer);
+        return ss.str();
+    }
+};
+
+// Parse "<base>+<inc>" in seconds (e.g. "10+0.1"); false if malformed
+bool parse_tc(const std::string& spec, TimeControl& tc) {
+    try {
+        size_t plus = spec.find('+');
+        double base = std::stod(spec.substr(0, plus));
+        double inc = (plus == std::string::npos) ? 0.0 : std::stod(spec.substr(plus + 1));
+        if (base <= 0 || inc < 0) return false;
+        tc.mode = TimeControl::Mode::Clock;
+        tc.base_ms = static_cast<int>(base * 1000 + 0.5);
+        tc.inc_ms = static_cast<int>(inc * 1000 + 0.5);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// UCI engine subprocess. Only spawns the process and moves bytes: the
+// EngineMux event loop owns the stdout/stderr fds, and the MatchSlot that
+// owns the engine decides what to send next.
+class Engine {
+    std::string path;
+    pid_t child_pid = -1;
+    int to_engine_fd = -1;
+    int from_engine_fd = -1;
+    int err_fd = -1;
+    std::string out_buffer;   // Partial stdout line
+    std::string err_buffer;   // Partial stderr line
+    static std::atomic<int> instance_counter;
+    int instance_id;
+    int current_game_id = -1;  // Set by caller to include in logs
+
+    // Read what is available on fd and split off complete lines.
+    // Returns false on EOF or a read error.
+    static bool read_lines(int fd, std::string& buffer, std::vector<std::string>& lines) {
+        char buf[4096];
+        while (true) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n > 0) {
+                buffer.append(buf, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            bool alive = (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+
+            size_t start = 0, pos;
+            while ((pos = buffer.find('\n', start)) != std::string::npos) {
+                size_t end = (pos > start && buffer[pos - 1] == '\r') ? pos - 1 : pos;
+                lines.push_back(buffer.substr(start, end - start));
+                start = pos + 1;
+            }
+            buffer.erase(0, start);
+            if (!alive && !buffer.empty()) {
+                lines.push_back(buffer);  // Flush a final partial line
+                buffer.clear();
+            }
+            return alive;
         }
     }
 
 public:
-    Engine(const std::string& engine_path) : path(engine_path), instance_id(++instance_counter) {
+    // cpu >= 0 pins the engine process (and all its threads) to that CPU
+    explicit Engine(const std::string& engine_path, int cpu = -1)
+        : path(engine_path), instance_id(++instance_counter) {
         log_msg("Engine[" + std::to_string(instance_id) + "] creating: " + engine_path);
 
-        // Create pipes: stdin, stdout, and stderr
+        // Create pipes: stdin, stdout, and stderr. O_CLOEXEC keeps other
+        // engines' pipe ends out of this child, so EOF is seen when one dies.
         int to_child[2], from_child[2], err_child[2];
-        if (pipe(to_child) < 0 || pipe(from_child) < 0 || pipe(err_child) < 0) {
+        if (pipe2(to_child, O_CLOEXEC) < 0 || pipe2(from_child, O_CLOEXEC) < 0 || pipe2(err_child, O_CLOEXEC) < 0) {
             log_msg("Engine[" + std::to_string(instance_id) + "] FAILED to create pipes");
             throw std::runtime_error("Failed to create pipes");
         }
@@ -236,87 +414,64 @@ public:
         }
 
         if (pid == 0) {
-            // Child process
-            close(to_child[1]);
-            close(from_child[0]);
-            close(err_child[0]);
+            // Child process (dup2 clears O_CLOEXEC on the std fds)
             dup2(to_child[0], STDIN_FILENO);
             dup2(from_child[1], STDOUT_FILENO);
             dup2(err_child[1], STDERR_FILENO);
-            close(to_child[0]);
-            close(from_child[1]);
-            close(err_child[1]);
+            if (cpu >= 0) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(cpu, &cpus);
+                sched_setaffinity(0, sizeof(cpus), &cpus);
+            }
             execlp(engine_path.c_str(), engine_path.c_str(), nullptr);
             _exit(1);
         }
 
         // Parent process
         child_pid = pid;
-        log_msg("Engine[" + std::to_string(instance_id) + "] forked, child pid=" + std::to_string(pid));
+        log_msg("Engine[" + std::to_string(instance_id) + "] forked, child pid=" + std::to_string(pid) +
+                (cpu >= 0 ? ", cpu " + std::to_string(cpu) : ""));
         close(to_child[0]);
         close(from_child[1]);
         close(err_child[1]);
-        to_engine = fdopen(to_child[1], "w");
-        from_engine_fd = from_child[0];  // Keep raw fd for reading
-        stderr_fd = err_child[0];        // Keep raw fd for stderr
-
-        if (!to_engine || from_engine_fd < 0 || stderr_fd < 0) {
-            log_msg("Engine[" + std::to_string(instance_id) + "] FAILED to open streams");
-            throw std::runtime_error("Failed to open engine streams");
-        }
-
-        setvbuf(to_engine, nullptr, _IOLBF, 0);  // Line buffered for writes
-
-        // Start stderr reader thread
-        stderr_thread = std::thread(&Engine::stderr_reader, this);
-
-        // Initialize UCI
-        log_msg("Engine[" + std::to_string(instance_id) + "] sending 'uci'");
-        send("uci");
-        log_msg("Engine[" + std::to_string(instance_id) + "] waiting for 'uciok'");
-        wait_for("uciok");
-        log_msg("Engine[" + std::to_string(instance_id) + "] got 'uciok'");
-
-        send("isready");
-        log_msg("Engine[" + std::to_string(instance_id) + "] waiting for 'readyok'");
-        wait_for("readyok");
-        log_msg("Engine[" + std::to_string(instance_id) + "] READY");
-    }
+        to_engine_fd = to_child[1];
+        from_engine_fd = from_child[0];
+        err_fd = err_child[0];
 
-    void set_hash(int mb, std::atomic<bool>* stop_flag = nullptr) {
-        send("setoption name Hash value " + std::to_string(mb));
-        send("isready");
-        wait_for("readyok", 10000, stop_flag);
+        // Reads are driven by epoll readiness; never block on them
+        fcntl(from_engine_fd, F_SETFL, fcntl(from_engine_fd, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(err_fd, F_SETFL, fcntl(err_fd, F_GETFL, 0) | O_NONBLOCK);
     }
 
-    ~Engine() {
-        // IMPORTANT: Destructors must never throw exceptions
-        // 1. Signal stderr reader to stop and wait for it first
-        //    (must join before closing fds to avoid read-after-close)
-        stopping.store(true);
-        if (stderr_thread.joinable()) {
-            stderr_thread.join();
-        }
-
-        // 2. Try graceful shutdown
-        if (to_engine) {
-            fprintf(to_engine, "quit\n");
-            fflush(to_engine);
-            fclose(to_engine);
-            to_engine = nullptr;
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Ask the engine to quit and close our pipe ends (this also removes them
+    // from any epoll set). The process is reaped by the destructor, which by
+    // then usually finds it already exited.
+    void quit() {
+        if (to_engine_fd >= 0) {
+            (void)write(to_engine_fd, "quit\n", 5);
+            close(to_engine_fd);
+            to_engine_fd = -1;
         }
-
-        // 3. Close read fds
         if (from_engine_fd >= 0) {
             close(from_engine_fd);
             from_engine_fd = -1;
         }
-        if (stderr_fd >= 0) {
-            close(stderr_fd);
-            stderr_fd = -1;
+        if (err_fd >= 0) {
+            close(err_fd);
+            err_fd = -1;
         }
+    }
+
+    ~Engine() {
+        // IMPORTANT: Destructors must never throw exceptions
+        // 1. Try graceful shutdown
+        quit();
 
-        // 4. Wait for child with timeout, then force kill if needed
+        // 2. Wait for child with timeout, then force kill if needed
         if (child_pid > 0) {
             int status;
             // Try non-blocking wait first
@@ -333,196 +488,88 @@ public:
         }
     }
 
-    void set_game_id(int game_id) { current_game_id = game_id; }
-
-    void send(const std::string& cmd) {
-        if (!to_engine) {
-            log_msg(log_prefix() + " SEND FAILED - closed: " + cmd);
-            throw std::runtime_error("Cannot send to closed engine " + path);
-        }
-        log_msg(log_prefix() + " >> " + cmd);
-        if (fprintf(to_engine, "%s\n", cmd.c_str()) < 0) {
-            log_msg(log_prefix() + " SEND FAILED - fprintf error");
-            throw std::runtime_error("Failed to send to engine " + path);
-        }
-        if (fflush(to_engine) != 0) {
-            log_msg(log_prefix() + " SEND FAILED - flush error");
-            throw std::runtime_error("Failed to flush to engine " + path);
-        }
+    // quit() and kill the process: for a hung engine that won't act on "quit"
+    void kill_process() {
+        quit();
+        if (child_pid > 0) kill(child_pid, SIGKILL);
     }
 
-    std::string read_line(int timeout_ms = 30000, std::atomic<bool>* stop_flag = nullptr) {
-        // Check if we already have a complete line in the buffer
-        size_t newline_pos = read_buffer.find('\n');
-        if (newline_pos != std::string::npos) {
-            std::string line = read_buffer.substr(0, newline_pos);
-            read_buffer.erase(0, newline_pos + 1);
-            log_msg(log_prefix() + " << " + line);
-            return line;
-        }
-
-        // Need to read more data
-        auto start_time = std::chrono::steady_clock::now();
-        while (true) {
-            // Check stop flag before each poll - enables responsive shutdown
-            if (stop_flag && stop_flag->load(std::memory_order_acquire)) {
-                log_msg(log_prefix() + " read interrupted by stop signal");
-                throw std::runtime_error("Read interrupted by stop signal");
-            }
-
-            // Calculate remaining timeout
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - start_time).count();
-            int remaining_ms = timeout_ms - static_cast<int>(elapsed);
-            if (remaining_ms <= 0) {
-                log_msg(log_prefix() + " TIMEOUT after " + std::to_string(timeout_ms) + "ms");
-                throw std::runtime_error("Engine " + path + " timed out after " + std::to_string(timeout_ms) + "ms");
-            }
-
-            struct pollfd pfd;
-            pfd.fd = from_engine_fd;
-            pfd.events = POLLIN;
-
-            // Use short poll timeout (100ms) to check stop flag frequently
-            int poll_timeout = std::min(100, remaining_ms);
-            int ret = poll(&pfd, 1, poll_timeout);
-            if (ret < 0) {
-                if (errno == EINTR) {
-                    continue;  // Interrupted by signal, retry
-                }
-                log_msg(log_prefix() + " poll FAILED: " + strerror(errno));
-                throw std::runtime_error("poll() failed for engine " + path + ": " + strerror(errno));
-            }
-            if (ret == 0) {
-                continue;  // Poll timeout, check stop flag and remaining time
-            }
-
-            // Check for errors
-            if (!(pfd.revents & POLLIN)) {
-                if (pfd.revents & POLLHUP) {
-                    log_msg(log_prefix() + " POLLHUP - pipe closed");
-                    throw std::runtime_error("Engine " + path + " closed pipe (crashed?)");
-                }
-                if (pfd.revents & (POLLERR | POLLNVAL)) {
-                    log_msg(log_prefix() + " POLLERR/POLLNVAL");
-                    throw std::runtime_error("Engine " + path + " pipe error");
-                }
-            }
-
-            // Read available data
-            char buf[4096];
-            ssize_t n = read(from_engine_fd, buf, sizeof(buf));
-            if (n < 0) {
-                if (errno == EINTR) {
-                    continue;  // Interrupted by signal, retry
-                }
-                log_msg(log_prefix() + " read FAILED: " + strerror(errno));
-                throw std::runtime_error("read() failed for engine " + path + ": " + strerror(errno));
-            }
-            if (n == 0) {
-                log_msg(log_prefix() + " EOF");
-                throw std::runtime_error("Engine " + path + " closed connection (EOF)");
-            }
+    void set_game_id(int game_id) { current_game_id = game_id; }
 
-            read_buffer.append(buf, n);
+    // Reap the process if it has exited (after quit()); true once it is gone
+    bool exited() {
+        if (child_pid > 0 && waitpid(child_pid, nullptr, WNOHANG) == child_pid) child_pid = -1;
+        return child_pid <= 0;
+    }
 
-            // Check for complete line
-            newline_pos = read_buffer.find('\n');
-            if (newline_pos != std::string::npos) {
-                std::string line = read_buffer.substr(0, newline_pos);
-                read_buffer.erase(0, newline_pos + 1);
-                log_msg(log_prefix() + " << " + line);
-                return line;
-            }
-            // No complete line yet, continue reading
+    std::string log_prefix() const {
+        if (current_game_id >= 0) {
+            return "Engine[" + std::to_string(instance_id) + "] Game[" + std::to_string(current_game_id + 1) + "]";
         }
+        return "Engine[" + std::to_string(instance_id) + "]";
     }
 
-    void wait_for(const std::string& expected, int timeout_ms = 10000,
-                  std::atomic<bool>* stop_flag = nullptr) {
-        auto start_time = std::chrono::steady_clock::now();
-        while (true) {
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - start_time).count();
-            int remaining_ms = timeout_ms - static_cast<int>(elapsed);
-            if (remaining_ms <= 0) {
-                log_msg(log_prefix() + " TIMEOUT waiting for '" + expected + "'");
-                throw std::runtime_error("Timeout waiting for '" + expected + "' from engine " + path);
-            }
-
-            std::string line = read_line(remaining_ms, stop_flag);
-            if (line.find(expected) == 0) {
-                break;
-            }
-        }
+    std::string short_name() const {
+        size_t pos = path.rfind('/');
+        return (pos != std::string::npos) ? path.substr(pos + 1) : path;
     }
 
-    MoveResult get_bestmove(const std::string& position, const std::vector<std::string>& moves,
-                            int movetime_ms, std::atomic<bool>* stop_flag = nullptr) {
-        std::string cmd = "position fen " + position;
-        if (!moves.empty()) {
-            cmd += " moves";
-            for (const auto& m : moves) {
-                cmd += " " + m;
+    void send(const std::string& cmd) {
+        if (to_engine_fd < 0) {
+            log_msg(log_prefix() + " SEND FAILED - closed: " + cmd);
+            throw std::runtime_error("Cannot send to closed engine " + path);
+        }
+        log_msg(log_prefix() + " >> " + cmd);
+        std::string line = cmd + "\n";
+        size_t written = 0;
+        while (written < line.size()) {
+            ssize_t n = write(to_engine_fd, line.data() + written, line.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                log_msg(log_prefix() + " SEND FAILED - " + strerror(errno));
+                throw std::runtime_error("Failed to send to engine " + path + ": " + strerror(errno));
             }
+            written += n;
         }
-        send(cmd);
-
-        send("isready");
-        wait_for("readyok", 10000, stop_flag);
-
-        send("go movetime " + std::to_string(movetime_ms));
-
-        MoveResult result;
+    }
 
-        // Wait for bestmove with generous timeout (movetime + 10 seconds buffer)
-        int timeout = movetime_ms + 10000;
-        while (true) {
-            std::string line = read_line(timeout, stop_flag);
-
-            // Parse UCI info lines for depth and nodes
-            if (line.find("info") == 0) {
-                std::istringstream iss(line);
-                std::string token;
-                while (iss >> token) {
-                    if (token == "depth") {
-                        int d;
-                        if (iss >> d) {
-                            result.depth = d;
-                        }
-                    } else if (token == "nodes") {
-                        u64 n;
-                        if (iss >> n) {
-                            result.nodes = n;
-                        }
-                    }
-                }
-            }
+    int stdout_fd() const { return from_engine_fd; }
+    int stderr_fd() const { return err_fd; }
 
-            if (line.find("bestmove") == 0) {
-                // Parse "bestmove e2e4 ..."
-                std::istringstream iss(line);
-                std::string token;
-                iss >> token >> result.bestmove;
-                return result;
-            }
+    bool read_stdout(std::vector<std::string>& lines) {
+        size_t first = lines.size();
+        bool alive = read_lines(from_engine_fd, out_buffer, lines);
+        for (size_t i = first; i < lines.size(); ++i) {
+            log_msg(log_prefix() + " << " + lines[i]);
         }
+        if (!alive) log_msg(log_prefix() + " EOF");
+        return alive;
     }
 
-    void new_game(std::atomic<bool>* stop_flag = nullptr) {
-        send("ucinewgame");
-        send("isready");
-        wait_for("readyok", 10000, stop_flag);
+    bool read_stderr(std::vector<std::string>& lines) {
+        return read_lines(err_fd, err_buffer, lines);
     }
 
     const std::string& get_path() const { return path; }
 };
 
-int Engine::instance_counter = 0;
+std::atomic<int> Engine::instance_counter{0};
 
 // Game result
 enum class GameResult { WhiteWin, BlackWin, Draw };
 enum class DrawReason { None, FiftyMove, Repetition, Stalemate, InsufficientMaterial };
+enum class Termination { Normal, TimeForfeit, IllegalMove, Adjudication };
+
+// One played move with the mover's search stats (for PGN comments)
+struct MoveRecord {
+    std::string san;      // With "+"/"#" suffix
+    int score = 0;
+    bool mate = false;
+    bool has_score = false;
+    int depth = 0;
+    u64 nodes = 0;
+    int time_ms = 0;
+};
 
 struct GameOutcome {
     GameResult result;
@@ -535,8 +582,25 @@ struct GameOutcome {
     u64 black_nodes = 0;     // Cumulative nodes for black's moves
     u64 white_moves = 0;     // Number of moves made by white
     u64 black_moves = 0;     // Number of moves made by black
+    u64 white_time_ms = 0;   // Cumulative go -> bestmove latency for white
+    u64 black_time_ms = 0;
+    Termination termination = Termination::Normal;
+    std::vector<MoveRecord> moves;  // Filled by GameState; dropped before results are stored
 };
 
+// True if the side to move has at least one legal move
+bool has_legal_move(Board& board) {
+    MoveList moves = generate_moves(board);
+    for (int i = 0; i < moves.size; ++i) {
+        Move32 m = moves[i];
+        UndoInfo undo = make_move(board, m);
+        bool legal = !is_illegal(board);
+        unmake_move(board, m, undo);
+        if (legal) return true;
+    }
+    return false;
+}
+
 // Check for insufficient material
 bool is_insufficient_material(const Board& board) {
     // Count pieces
@@ -603,220 +667,1170 @@ bool is_threefold_repetition(const Board& board, const std::vector<u64>& positio
     return false;
 }
 
-// Forward declarations for TUI
-class GameStateManager;
-
-// Callback type for TUI updates during game play
-using GameUpdateCallback = std::function<void(int game_id, const std::string& fen, const std::vector<std::string>& moves)>;
-
-// Play a single game between two engines (with optional TUI updates)
-GameOutcome play_game(Engine& white, Engine& black, const std::string& start_fen, int movetime_ms,
-                      const std::string& white_name, const std::string& black_name,
-                      GameUpdateCallback on_move = nullptr,
-                      std::atomic<bool>* stop_flag = nullptr) {
-    Board board(start_fen);
+// Rules, clocks and statistics of one game, independent of how the engines
+// are driven. The owner asks check_end() before every move, sends
+// position_command()/go_command() to the side to move and feeds the reply to
+// apply_move().
+class GameState {
+    Board board;
+    std::string start_fen;
+    TimeControl tc;
+    Adjudication adjudication;
     std::vector<std::string> move_history;
     std::vector<u64> position_hashes;
+    int white_clock;  // Remaining clock per side (Clock mode only)
+    int black_clock;
+    GameOutcome outcome;
+    bool over = false;
+    int winning_plies = 0;  // Consecutive plies scored >= resign_cp for one side
+    int winning_sign = 0;   // +1 white, -1 black
+    int drawn_plies = 0;    // Consecutive plies scored within draw_cp
+
+    void finish(GameResult result, DrawReason reason = DrawReason::None,
+                Termination termination = Termination::Normal) {
+        outcome.result = result;
+        outcome.draw_reason = reason;
+        outcome.termination = termination;
+        outcome.final_fen = board.to_fen();
+        over = true;
+    }
+
+    // The side to move forfeits (time, illegal or malformed move)
+    void forfeit(Termination termination) {
+        finish(white_to_move() ? GameResult::BlackWin : GameResult::WhiteWin, DrawReason::None, termination);
+    }
 
-    white.new_game(stop_flag);
-    black.new_game(stop_flag);
+public:
+    GameState(const std::string& fen, const TimeControl& time_control, const Adjudication& adjudication_rules = {})
+        : board(fen), start_fen(fen), tc(time_control), adjudication(adjudication_rules),
+          white_clock(time_control.base_ms), black_clock(time_control.base_ms) {
+        outcome.result = GameResult::Draw;
+        outcome.draw_reason = DrawReason::None;
+        outcome.num_moves = 0;
+    }
 
-    GameOutcome outcome;
-    outcome.num_moves = 0;
-    outcome.draw_reason = DrawReason::None;
+    bool is_over() const { return over; }
+    bool white_to_move() const { return board.turn == ::Color::White; }
+    const GameOutcome& get_outcome() const { return outcome; }
+    const std::vector<std::string>& moves() const { return move_history; }
+    std::string fen() const { return board.to_fen(); }
+    const Board& position() const { return board; }
+    // Hashes of the positions before each move played (for repetition detection)
+    const std::vector<u64>& hashes() const { return position_hashes; }
+
+    // Ends the game if the side to move has no move to make by rule.
+    // Returns true if the game is over.
+    bool check_end() {
+        if (over) return true;
 
-    while (true) {
-        // Check for stop signal at start of each move
-        if (stop_flag && stop_flag->load(std::memory_order_acquire)) {
-            // Abort game cleanly
-            outcome.result = GameResult::Draw;
-            outcome.draw_reason = DrawReason::None;
-            break;
-        }
         // Check for 50-move rule
         if (board.halfmove_clock >= 100) {
-            outcome.result = GameResult::Draw;
-            outcome.draw_reason = DrawReason::FiftyMove;
-            break;
+            finish(GameResult::Draw, DrawReason::FiftyMove);
+            return true;
         }
 
         // Check for 3-fold repetition
         if (is_threefold_repetition(board, position_hashes)) {
-            outcome.result = GameResult::Draw;
-            outcome.draw_reason = DrawReason::Repetition;
-            break;
+            finish(GameResult::Draw, DrawReason::Repetition);
+            return true;
         }
 
         // Check for insufficient material
         if (is_insufficient_material(board)) {
-            outcome.result = GameResult::Draw;
-            outcome.draw_reason = DrawReason::InsufficientMaterial;
-            break;
-        }
-
-        // Generate legal moves to check for checkmate/stalemate
-        MoveList moves = generate_moves(board);
-        int legal_count = 0;
-        for (int i = 0; i < moves.size; ++i) {
-            Move32 m = moves[i];
-            UndoInfo undo = make_move(board, m);
-            if (!is_illegal(board)) {
-                legal_count++;
-            }
-            unmake_move(board, m, undo);
+            finish(GameResult::Draw, DrawReason::InsufficientMaterial);
+            return true;
         }
 
-        if (legal_count == 0) {
+        // Check for checkmate/stalemate
+        if (!has_legal_move(board)) {
             // No legal moves - checkmate or stalemate
             ::Color them = opposite(board.turn);
             bool in_check = is_attacked(board.king_sq[(int)board.turn], them, board);
 
             if (in_check) {
                 // Checkmate - side to move loses
-                outcome.result = (board.turn == ::Color::White) ? GameResult::BlackWin : GameResult::WhiteWin;
+                finish(white_to_move() ? GameResult::BlackWin : GameResult::WhiteWin);
             } else {
-                // Stalemate
-                outcome.result = GameResult::Draw;
-                outcome.draw_reason = DrawReason::Stalemate;
+                finish(GameResult::Draw, DrawReason::Stalemate);
             }
-            break;
+            return true;
         }
+        return false;
+    }
 
-        // Save position hash before move
-        position_hashes.push_back(board.hash);
+    std::string position_command() const {
+        std::string cmd = "position fen " + start_fen;
+        if (!move_history.empty()) {
+            cmd += " moves";
+            for (const auto& m : move_history) {
+                cmd += " " + m;
+            }
+        }
+        return cmd;
+    }
+
+    // The side to move never answered within read_timeout_ms(): lost on time
+    void time_forfeit() { forfeit(Termination::TimeForfeit); }
+
+    std::string go_command() const { return tc.go_command(white_clock, black_clock); }
+    int read_timeout_ms() const { return tc.read_timeout_ms(white_to_move() ? white_clock : black_clock); }
+
+    // Update the adjudication streaks with the score of the move just played
+    // (from the mover's point of view) and end the game if a rule is met
+    void adjudicate(const MoveRecord& record, bool white_moved) {
+        if (!record.has_score) {
+            winning_plies = drawn_plies = 0;
+            return;
+        }
+        constexpr int MATE_CP = 100000;
+        int cp = record.mate ? (record.score > 0 ? MATE_CP : -MATE_CP) : record.score;
+        int white_cp = white_moved ? cp : -cp;
+
+        if (adjudication.resign_moves > 0) {
+            int sign = white_cp >= adjudication.resign_cp ? 1 : white_cp <= -adjudication.resign_cp ? -1 : 0;
+            winning_plies = (sign != 0 && sign == winning_sign) ? winning_plies + 1 : (sign != 0 ? 1 : 0);
+            winning_sign = sign;
+            if (winning_plies >= 2 * adjudication.resign_moves) {
+                finish(sign > 0 ? GameResult::WhiteWin : GameResult::BlackWin, DrawReason::None,
+                       Termination::Adjudication);
+                return;
+            }
+        }
+
+        if (adjudication.draw_moves > 0 && outcome.num_moves / 2 >= adjudication.draw_after) {
+            drawn_plies = std::abs(white_cp) <= adjudication.draw_cp ? drawn_plies + 1 : 0;
+            if (drawn_plies >= 2 * adjudication.draw_moves) {
+                finish(GameResult::Draw, DrawReason::None, Termination::Adjudication);
+            }
+        }
+    }
 
-        // Get move from current player
-        Engine& current = (board.turn == ::Color::White) ? white : black;
-        MoveResult move_result = current.get_bestmove(start_fen, move_history, movetime_ms, stop_flag);
-        std::string uci_move = move_result.bestmove;
+    // Apply the reply of the side to move: charge its clock, validate and
+    // play the move. Returns true if the move was played (the game may still
+    // have ended by the move limit); false if the mover forfeited.
+    bool apply_move(const MoveResult& move_result, const std::string& engine_name) {
+        const std::string& uci_move = move_result.bestmove;
 
-        // Track depth/nodes per color
-        if (board.turn == ::Color::White) {
+        // Track depth/nodes/time per color
+        if (white_to_move()) {
             outcome.white_depth += move_result.depth;
             outcome.white_nodes += move_result.nodes;
+            outcome.white_time_ms += move_result.elapsed_ms;
             outcome.white_moves++;
         } else {
             outcome.black_depth += move_result.depth;
             outcome.black_nodes += move_result.nodes;
+            outcome.black_time_ms += move_result.elapsed_ms;
             outcome.black_moves++;
         }
 
+        // Charge the measured latency to the mover's clock
+        if (tc.mode == TimeControl::Mode::Clock) {
+            int& clock = white_to_move() ? white_clock : black_clock;
+            clock -= move_result.elapsed_ms;
+            if (clock < -tc.margin_ms) {
+                log_msg("Time forfeit: " + engine_name + " used " + std::to_string(move_result.elapsed_ms) +
+                        "ms, clock now " + std::to_string(clock) + "ms");
+                forfeit(Termination::TimeForfeit);
+                return false;
+            }
+            clock = std::max(clock, 0) + tc.inc_ms;
+        }
+
         // Validate move format (should be 4-5 chars: e2e4 or e7e8q)
         if (uci_move.length() < 4 || uci_move.length() > 5) {
-            const std::string& engine_name = (board.turn == ::Color::White) ? white_name : black_name;
             log_msg("ERROR: Malformed move '" + uci_move + "' (len=" + std::to_string(uci_move.length()) +
                     ") from " + engine_name);
-            outcome.result = (board.turn == ::Color::White) ? GameResult::BlackWin : GameResult::WhiteWin;
-            break;
+            forfeit(Termination::IllegalMove);
+            return false;
         }
 
         // Apply move
         Move32 move = parse_uci_move(uci_move, board);
         if (move.data == 0) {
-            const std::string& engine_name = (board.turn == ::Color::White) ? white_name : black_name;
             log_msg("ERROR: Invalid move '" + uci_move + "' from " + engine_name +
                     " in position " + board.to_fen());
-            outcome.result = (board.turn == ::Color::White) ? GameResult::BlackWin : GameResult::WhiteWin;
-            break;
+            forfeit(Termination::IllegalMove);
+            return false;
         }
 
+        MoveRecord record;
+        record.san = move.to_string(board);
+        record.score = move_result.score;
+        record.mate = move_result.mate;
+        record.has_score = move_result.has_score;
+        record.depth = move_result.depth;
+        record.nodes = move_result.nodes;
+        record.time_ms = move_result.elapsed_ms;
+
+        position_hashes.push_back(board.hash);
         (void)make_move(board, move);
         move_history.push_back(uci_move);
         outcome.num_moves++;
 
-        // Update TUI state after each move
-        if (on_move) {
-            on_move(-1, board.to_fen(), move_history);  // game_id filled in by caller
+        if (is_attacked(board.king_sq[(int)board.turn], opposite(board.turn), board)) {
+            record.san += has_legal_move(board) ? "+" : "#";
+        }
+        outcome.moves.push_back(std::move(record));
+        if (adjudication.enabled()) {
+            adjudicate(outcome.moves.back(), !white_to_move());
+            if (over) return true;
         }
 
         // Safety limit
         if (outcome.num_moves > 500) {
-            outcome.result = GameResult::Draw;
-            outcome.draw_reason = DrawReason::None;
-            break;
-        }
-    }
-
-    outcome.final_fen = board.to_fen();
-    return outcome;
-}
-
-// Parse EPD file - simple format: just FEN strings, one per line
-std::vector<std::string> parse_epd_file(const std::string& filename) {
-    std::vector<std::string> positions;
-    std::ifstream file(filename);
-    std::string line;
-
-    while (std::getline(file, line)) {
-        if (!line.empty() && line[0] != '#') {
-            // EPD might have operations after FEN, just take first 4-6 fields
-            positions.push_back(line);
+            finish(GameResult::Draw);
         }
+        return true;
     }
+};
 
-    return positions;
-}
-
-// Game task for work queue
+// ============================================================================
+// Engine multiplexer: one epoll loop drives every game
+// ============================================================================
+// Each MatchSlot runs two engine processes ("seats") and plays games back to
+// back as a state machine; EngineMux waits on all engine stdout/stderr fds at
+// once and feeds complete lines (and expired deadlines) to the owning slot.
+// The thread count is independent of the number of concurrent games, and a
+// bestmove is acted on as soon as it arrives. A task names the two engines
+// that play it; a slot keeps a seat's process across games while the engine
+// stays the same and only restarts the seats that change.
+
+// A game to be played by a slot
 struct GameTask {
     std::string fen;
     bool engine1_is_white;
     int game_id;  // For ordering output
+    int tag = 0;  // Source-specific (e.g. SPSA iteration)
+    // Engines (indices into the match's engine list) playing the engine1/engine2 roles
+    std::array<int, 2> players = {0, 1};
+    // setoption name/value pairs sent before the game, per engine (engine1, engine2)
+    std::vector<std::pair<std::string, std::string>> options[2];
 };
 
-// Thread-safe work queue
-class WorkQueue {
-    std::queue<GameTask> tasks;
-    std::mutex mtx;
-
+// Where slots get their games and report results. All callbacks run on the
+// event loop thread.
+class GameSource {
 public:
-    void push(GameTask task) {
-        std::lock_guard<std::mutex> lock(mtx);
-        tasks.push(std::move(task));
+    virtual ~GameSource() = default;
+    // Next game to play; false when there is no more work. task still holds
+    // the slot's previous game, so a source can prefer its loaded engines.
+    virtual bool next_game(GameTask& task) = 0;
+    virtual void game_moved(const GameTask&, const std::string& /*fen*/, const std::vector<std::string>& /*moves*/) {}
+    // Game played to its end (by rule, forfeit or illegal move)
+    virtual void game_finished(const GameTask& task, const GameOutcome& outcome) = 0;
+    // An engine failed mid-game (crash, hang); the slot is retired
+    virtual void game_failed(const GameTask&, const std::string& /*error*/) {}
+    // A slot could not start its engines
+    virtual void slot_failed(int /*slot_id*/, const std::string& /*error*/) {}
+};
+
+class MatchSlot {
+    enum class Phase { Handshake, Configure, NewGame, Thinking, Idle, Dead };
+    using Clock = std::chrono::steady_clock;
+    static constexpr int HANDSHAKE_TIMEOUT_MS = 10000;
+    static constexpr int READY_TIMEOUT_MS = 10000;
+
+    int id;
+    GameSource& source;
+    const std::vector<std::string>& paths;  // Every engine of the match
+    const TimeControl& tc;
+    const Adjudication& adjudication;
+    int hash_mb;
+    std::array<int, 2> cpus;             // CPU per seat (-1 = not pinned)
+    std::function<void(int, Engine&)> on_spawn;  // Registers a new seat engine's fds
+    std::unique_ptr<Engine> engines[2];  // Engine process per seat
+    int loaded[2] = {-1, -1};            // Index into paths of each seat's engine
+    bool fresh[2] = {false, false};      // Seat started for this game, handshake pending
+    std::set<std::string> offered[2];    // Option names each seat's engine listed before uciok
+    int seat_of[2] = {0, 1};             // Seat of the task's engine1/engine2 role
+    std::vector<std::unique_ptr<Engine>> retired;  // Quit, awaiting reaping
+
+    Phase phase = Phase::Handshake;
+    std::string expected_ack;            // "uciok" / "readyok" awaited from the engines
+    bool acked[2] = {false, false};
+    Clock::time_point deadline;
+
+    GameTask task;
+    std::unique_ptr<GameState> game;
+    int mover = 0;                       // Seat of the side to move
+    MoveResult current;
+    Clock::time_point go_time;
+
+    // Wait for ack from both seats, or only the fresh ones
+    void expect(const std::string& ack, int timeout_ms, bool fresh_only = false) {
+        expected_ack = ack;
+        acked[0] = fresh_only && !fresh[0];
+        acked[1] = fresh_only && !fresh[1];
+        deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
     }
 
-    bool pop(GameTask& task) {
-        std::lock_guard<std::mutex> lock(mtx);
-        if (tasks.empty()) return false;
-        task = std::move(tasks.front());
-        tasks.pop();
-        return true;
+    void send_both(const std::string& cmd) {
+        engines[0]->send(cmd);
+        engines[1]->send(cmd);
     }
 
-    size_t size() {
-        std::lock_guard<std::mutex> lock(mtx);
-        return tasks.size();
+    void send_fresh(const std::string& cmd) {
+        for (int seat = 0; seat < 2; ++seat) {
+            if (fresh[seat]) engines[seat]->send(cmd);
+        }
     }
-};
 
-// Game result for reporting
-struct GameReport {
-    int game_id;
-    GameOutcome outcome;
-    bool engine1_is_white;
-    std::string fen;
-};
+    // Seat the task's two engines, keeping processes that already run one of
+    // them. Returns true if an engine had to be started.
+    bool load_engines() {
+        std::erase_if(retired, [](const std::unique_ptr<Engine>& engine) { return engine->exited(); });
+
+        bool kept[2] = {false, false};
+        for (int role = 0; role < 2; ++role) {
+            seat_of[role] = -1;
+            for (int seat = 0; seat < 2; ++seat) {
+                if (!kept[seat] && engines[seat] && loaded[seat] == task.players[role]) {
+                    seat_of[role] = seat;
+                    kept[seat] = true;
+                    break;
+                }
+            }
+        }
 
-// Thread-safe results collector with running stats
-class ResultsCollector {
-    std::vector<GameReport> results;
-    std::mutex mtx;
-    std::atomic<int> completed{0};
-    std::atomic<int> wins1{0};
-    std::atomic<int> wins2{0};
-    std::atomic<int> draws{0};
+        bool spawned = false;
+        fresh[0] = fresh[1] = false;
+        for (int role = 0; role < 2; ++role) {
+            if (seat_of[role] >= 0) continue;
+            int seat = kept[0] ? 1 : 0;
+            kept[seat] = true;
+            seat_of[role] = seat;
+            if (engines[seat]) {
+                engines[seat]->quit();
+                retired.push_back(std::move(engines[seat]));
+            }
+            const std::string& path = paths[task.players[role]];
+            log_msg("Slot[" + std::to_string(id) + "] seat " + std::to_string(seat) + " starting " + path);
+            engines[seat] = std::make_unique<Engine>(path, cpus[seat]);
+            loaded[seat] = task.players[role];
+            fresh[seat] = true;
+            offered[seat].clear();
+            on_spawn(seat, *engines[seat]);
+            spawned = true;
+        }
+        return spawned;
+    }
+
+    void start_next_game() {
+        if (!source.next_game(task)) {
+            log_msg("Slot[" + std::to_string(id) + "] no more games");
+            shutdown(Phase::Idle);
+            return;
+        }
+        if (load_engines()) {
+            send_fresh("uci");
+            expect("uciok", HANDSHAKE_TIMEOUT_MS, true);
+            phase = Phase::Handshake;
+            return;
+        }
+        begin_game();
+    }
+
+    void begin_game() {
+        // Engines ignore setoption for names they do not know, so a task
+        // option the engine never offered would silently play untuned
+        for (int role = 0; role < 2; ++role) {
+            int seat = seat_of[role];
+            for (const auto& [name, value] : task.options[role]) {
+                if (!offered[seat].count(name)) {
+                    fail("Engine " + paths[loaded[seat]] + " has no option '" + name + "' = '" + value + "'");
+                    return;
+                }
+            }
+        }
+        for (int role = 0; role < 2; ++role) {
+            Engine& engine = *engines[seat_of[role]];
+            engine.set_game_id(task.game_id);
+            for (const auto& [name, value] : task.options[role]) {
+                engine.send("setoption name " + name + " value " + value);
+            }
+        }
+        send_both("ucinewgame");
+        send_both("isready");
+        expect("readyok", READY_TIMEOUT_MS);
+        game = std::make_unique<GameState>(task.fen, tc, adjudication);
+        phase = Phase::NewGame;
+    }
+
+    void request_move() {
+        if (game->check_end()) {
+            finish_game();
+            return;
+        }
+        mover = seat_of[(game->white_to_move() == task.engine1_is_white) ? 0 : 1];
+        current = MoveResult{};
+        engines[mover]->send(game->position_command());
+        go_time = Clock::now();
+        engines[mover]->send(game->go_command());
+        deadline = go_time + std::chrono::milliseconds(game->read_timeout_ms());
+        phase = Phase::Thinking;
+    }
+
+    void finish_game() {
+        source.game_finished(task, game->get_outcome());
+        game.reset();
+        start_next_game();
+    }
+
+    // Parse UCI info/bestmove lines from the side to move
+    void on_search_line(const std::string& line) {
+        if (line.compare(0, 4, "info") == 0) {
+            std::istringstream iss(line);
+            std::string token;
+            while (iss >> token) {
+                if (token == "depth") {
+                    int d;
+                    if (iss >> d) current.depth = d;
+                } else if (token == "nodes") {
+                    u64 n;
+                    if (iss >> n) current.nodes = n;
+                } else if (token == "score") {
+                    std::string kind;
+                    int v;
+                    if (iss >> kind >> v && (kind == "cp" || kind == "mate")) {
+                        current.score = v;
+                        current.mate = kind == "mate";
+                        current.has_score = true;
+                    }
+                }
+            }
+            return;
+        }
+        if (line.compare(0, 8, "bestmove") != 0) return;
+
+        current.elapsed_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - go_time).count());
+        // Parse "bestmove e2e4 ..."
+        std::istringstream iss(line);
+        std::string token;
+        iss >> token >> current.bestmove;
+
+        bool played = game->apply_move(current, paths[loaded[mover]]);
+        if (played) {
+            source.game_moved(task, game->fen(), game->moves());
+        }
+        if (game->is_over()) {
+            finish_game();
+        } else {
+            request_move();
+        }
+    }
+
+    // Quit the engines without waiting for them; the processes are reaped
+    // when the slot is destroyed so other slots' games aren't held up
+    void shutdown(Phase final_phase) {
+        phase = final_phase;
+        for (auto& engine : engines) {
+            if (!engine) continue;
+            engine->quit();
+            retired.push_back(std::move(engine));
+        }
+    }
+
+public:
+    MatchSlot(int slot_id, GameSource& game_source, const std::vector<std::string>& engine_paths,
+              const TimeControl& time_control, const Adjudication& adjudication_rules, int hash,
+              std::array<int, 2> engine_cpus, std::function<void(int, Engine&)> spawn_callback)
+        : id(slot_id), source(game_source), paths(engine_paths), tc(time_control),
+          adjudication(adjudication_rules), hash_mb(hash), cpus(engine_cpus),
+          on_spawn(std::move(spawn_callback)) {}
+
+    int get_id() const { return id; }
+    bool is_active() const { return phase != Phase::Idle && phase != Phase::Dead; }
+    Clock::time_point get_deadline() const { return deadline; }
+    Engine* engine(int e) const { return engines[e].get(); }
+
+    // Take the first game and spawn its engines. Returns false (after
+    // reporting to the source) if an engine can't be started.
+    bool start() {
+        try {
+            start_next_game();
+        } catch (const std::exception& e) {
+            fail(e.what());
+            return false;
+        }
+        return true;
+    }
+
+    void on_line(int e, const std::string& line) {
+        try {
+            switch (phase) {
+                case Phase::Handshake:
+                    if (!acked[e] && line.compare(0, 12, "option name ") == 0) {
+                        size_t type = line.find(" type ", 12);
+                        offered[e].insert(line.substr(12, type == std::string::npos ? std::string::npos : type - 12));
+                        return;
+                    }
+                    [[fallthrough]];
+                case Phase::Configure:
+                case Phase::NewGame:
+                    if (acked[e] || line.compare(0, expected_ack.size(), expected_ack) != 0) return;
+                    acked[e] = true;
+                    if (!acked[0] || !acked[1]) return;
+
+                    if (phase == Phase::Handshake) {
+                        log_msg("Slot[" + std::to_string(id) + "] new engines answered uci");
+                        if (hash_mb > 0) {
+                            send_fresh("setoption name Hash value " + std::to_string(hash_mb));
+                        }
+                        send_fresh("isready");
+                        expect("readyok", READY_TIMEOUT_MS, true);
+                        phase = Phase::Configure;
+                    } else if (phase == Phase::Configure) {
+                        log_msg("Slot[" + std::to_string(id) + "] READY");
+                        begin_game();
+                    } else {
+                        request_move();
+                    }
+                    break;
+                case Phase::Thinking:
+                    if (e == mover) on_search_line(line);
+                    break;
+                default:
+                    break;
+            }
+        } catch (const std::exception& ex) {
+            fail(ex.what());
+        }
+    }
+
+    void on_timeout() {
+        if (!is_active() || Clock::now() < deadline) return;
+        if (phase == Phase::Thinking &&
+            (tc.mode == TimeControl::Mode::Clock || tc.mode == TimeControl::Mode::MoveTime)) {
+            try {
+                forfeit_on_time();
+            } catch (const std::exception& ex) {
+                fail(ex.what());
+            }
+            return;
+        }
+        std::string waiting = (phase == Phase::Thinking) ? "bestmove" : expected_ack;
+        int seat = (phase == Phase::Thinking) ? mover : (acked[0] ? 1 : 0);
+        fail("Engine " + paths[loaded[seat]] + " timed out waiting for '" + waiting + "'");
+    }
+
+    void shutdown_engines() {
+        if (is_active()) shutdown(Phase::Dead);
+    }
+
+    // The mover is still thinking well past its time (10 s over its clock or
+    // movetime): it has lost on time. Only its seat is restarted; the slot
+    // goes on with the next game.
+    void forfeit_on_time() {
+        log_msg("Slot[" + std::to_string(id) + "] " + paths[loaded[mover]] + " sent no bestmove " +
+                std::to_string(game->read_timeout_ms()) + "ms after go: time forfeit, restarting it");
+        game->time_forfeit();
+        engines[mover]->kill_process();
+        retired.push_back(std::move(engines[mover]));
+        loaded[mover] = -1;
+        finish_game();
+    }
+
+    // An engine died or hung: report and retire the slot (its engines are unusable)
+    void fail(const std::string& error) {
+        if (!is_active()) return;
+        log_msg("Slot[" + std::to_string(id) + "] failed: " + error);
+        if (game) {
+            source.game_failed(task, error);
+            game.reset();
+        } else {
+            source.slot_failed(id, error);
+        }
+        shutdown(Phase::Dead);
+    }
+};
+
+class EngineMux {
+    int epoll_fd;
+    int interrupt_fd = -1;  // Readable -> stop (e.g. the signal pipe)
+    std::vector<std::unique_ptr<MatchSlot>> slots;
+
+    // epoll user data: slot index, engine index and stream
+    static u64 encode(size_t slot, int engine, bool is_stderr) {
+        return (static_cast<u64>(slot) << 2) | (engine << 1) | (is_stderr ? 1 : 0);
+    }
+
+    void watch(int fd, u64 data) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = data;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void handle(u64 data) {
+        MatchSlot& slot = *slots[data >> 2];
+        int e = (data >> 1) & 1;
+        bool is_stderr = data & 1;
+        Engine* engine = slot.engine(e);
+        if (!engine) return;  // Slot already shut down
+
+        std::vector<std::string> lines;
+        if (is_stderr) {
+            bool alive = engine->read_stderr(lines);
+            for (const auto& line : lines) {
+                // Console panel only: engine chatter would flood a headless terminal
+                if (!line.empty()) console_buffer.add("[" + engine->short_name() + "] " + line);
+            }
+            if (!alive) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, engine->stderr_fd(), nullptr);
+            return;
+        }
+
+        bool alive = engine->read_stdout(lines);
+        for (const auto& line : lines) {
+            slot.on_line(e, line);
+            if (slot.engine(e) != engine) return;  // Slot finished or failed on this line
+        }
+        if (!alive) {
+            slot.fail("Engine " + engine->get_path() + " closed connection (crashed?)");
+        }
+    }
+
+public:
+    EngineMux() : epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+        if (epoll_fd < 0) throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+    ~EngineMux() {
+        slots.clear();
+        close(epoll_fd);
+    }
+
+    void set_interrupt_fd(int fd) {
+        interrupt_fd = fd;
+        watch(fd, ~0ULL);
+    }
+
+    // Create a slot and start its engines
+    void add_slot(GameSource& source, const std::vector<std::string>& engine_paths,
+                  const TimeControl& tc, const Adjudication& adjudication, int hash_mb,
+                  std::array<int, 2> cpus = {-1, -1}) {
+        size_t index = slots.size();
+        auto on_spawn = [this, index](int seat, Engine& engine) {
+            watch(engine.stdout_fd(), encode(index, seat, false));
+            watch(engine.stderr_fd(), encode(index, seat, true));
+        };
+        slots.push_back(std::make_unique<MatchSlot>((int)index, source, engine_paths, tc,
+                                                    adjudication, hash_mb, cpus, on_spawn));
+        slots.back()->start();
+    }
+
+    // Run until every slot has run out of games (or died), stop is set, or
+    // the interrupt fd becomes readable. Unfinished games are abandoned.
+    void run(std::atomic<bool>& stop) {
+        constexpr int MAX_EVENTS = 64;
+        constexpr int STOP_CHECK_MS = 100;  // Bounds how long a stop request goes unnoticed
+        struct epoll_event events[MAX_EVENTS];
+
+        while (!stop.load(std::memory_order_acquire)) {
+            auto now = std::chrono::steady_clock::now();
+            int timeout_ms = STOP_CHECK_MS;
+            bool any_active = false;
+            for (const auto& slot : slots) {
+                if (!slot->is_active()) continue;
+                any_active = true;
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(slot->get_deadline() - now).count();
+                timeout_ms = std::clamp(static_cast<int>(left) + 1, 0, timeout_ms);
+            }
+            if (!any_active) break;
+
+            int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout_ms);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                log_msg(std::string("epoll_wait failed: ") + strerror(errno));
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.u64 == ~0ULL) {
+                    char c;
+                    (void)read(interrupt_fd, &c, 1);
+                    log_msg("EngineMux: interrupted");
+                    stop.store(true);
+                    break;
+                }
+                handle(events[i].data.u64);
+            }
+
+            for (auto& slot : slots) {
+                slot->on_timeout();
+            }
+        }
+
+        // Quit all engines first, then reap them
+        for (auto& slot : slots) {
+            slot->shutdown_engines();
+        }
+        slots.clear();
+    }
+};
+
+// ============================================================================
+// In-process games: the search linked into this binary plays both sides
+// ============================================================================
+// For workloads where engine process overhead dominates (SPSA at a few
+// thousand nodes per move, self-play data generation). Each slot is a thread
+// that plays its games back to back with two InProcessEngines, each with its
+// own TTable, pawn cache and search parameters; killers and history are per
+// search as in the engine. Moves are charged their measured wall time like
+// those of engine processes. InProcessMux mirrors EngineMux, so the game
+// sources work unchanged: their callbacks are serialized under one mutex.
+
+// One side of an in-process game, configured like a UCI engine
+class InProcessEngine {
+    static constexpr int DEFAULT_MOVE_OVERHEAD_MS = 10;
+
+    TTable tt;
+    PawnCache pawn_cache;
+    SearchParamValues params;
+    int move_overhead_ms = DEFAULT_MOVE_OVERHEAD_MS;
+    int moves_played = 0;
+
+public:
+    static constexpr int DEFAULT_HASH_MB = 16;
+
+    explicit InProcessEngine(int hash_mb) : tt(hash_mb > 0 ? hash_mb : DEFAULT_HASH_MB), pawn_cache(1) {}
+
+    // setoption: Hash, Move Overhead or a search parameter (tuning builds).
+    // Returns false for anything else.
+    bool set_option(const std::string& name, const std::string& value) {
+        int v = std::stoi(value);
+        if (name == "Hash") {
+            tt.resize(std::max(1, v));
+            tt.clear();
+            return true;
+        }
+        if (name == "Move Overhead") {
+            move_overhead_ms = std::max(0, v);
+            return true;
+        }
+        // set_search_param works on the calling thread's values: stage ours there
+        SearchParamValues thread_values = get_search_params();
+        set_search_params(params);
+        bool known = set_search_param(name, v);
+        params = get_search_params();
+        set_search_params(thread_values);
+        return known;
+    }
+
+    // ucinewgame
+    void new_game() {
+        tt.clear();
+        pawn_cache.clear();
+        moves_played = 0;
+    }
+
+    // position + go on the calling thread
+    MoveResult think(const GameState& game) {
+        Board board = game.position();
+        GoParams go = parse_go_command(game.go_command(), board, moves_played, move_overhead_ms);
+        t_pawn_cache = &pawn_cache;
+        set_search_params(params);
+        tt.new_search();
+
+        auto start = std::chrono::steady_clock::now();
+        SearchLimits limits{go.time_ms, go.depth_limit, go.node_limit, true};
+        SearchResult r = search(board, tt, limits, game.hashes().data(), static_cast<int>(game.hashes().size()));
+        moves_played++;
+
+        MoveResult result;
+        result.elapsed_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        result.bestmove = r.best_move.to_uci();
+        result.depth = r.depth;
+        result.nodes = r.nodes;
+        result.has_score = r.depth > 0;
+        if (is_mate_score(r.score)) {
+            result.mate = true;
+            result.score = mate_in_moves(r.score);
+        } else {
+            result.score = r.score;
+        }
+        return result;
+    }
+};
+
+class InProcessMux {
+    struct Slot {
+        int id;
+        GameSource& source;
+        const std::vector<std::string>& names;  // Every player of the match (for logs)
+        const TimeControl& tc;
+        const Adjudication& adjudication;
+        int hash_mb;
+        int cpu;
+    };
+
+    int interrupt_fd = -1;
+    std::mutex source_mutex;            // Sources expect one caller at a time
+    std::atomic<bool> halt{false};      // Abandon games in progress and exit
+    std::atomic<int> active{0};
+    std::vector<std::thread> threads;
+
+    void fail(const Slot& slot, const std::string& error) {
+        log_msg("Slot[" + std::to_string(slot.id) + "] failed: " + error);
+        std::lock_guard<std::mutex> lock(source_mutex);
+        slot.source.slot_failed(slot.id, error);
+    }
+
+    void play(Slot slot) {
+        if (slot.cpu >= 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(slot.cpu, &cpus);
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+        }
+
+        InProcessEngine engines[2] = {InProcessEngine(slot.hash_mb), InProcessEngine(slot.hash_mb)};
+        GameTask task;
+        while (!halt.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(source_mutex);
+                if (!slot.source.next_game(task)) break;
+            }
+            for (int role = 0; role < 2; ++role) {
+                engines[role].new_game();
+                for (const auto& [name, value] : task.options[role]) {
+                    bool known = false;
+                    try {
+                        known = engines[role].set_option(name, value);
+                    } catch (const std::exception&) {
+                    }
+                    if (!known) {
+                        fail(slot, "in-process engine has no option '" + name + "' = '" + value + "'" +
+                                   (SEARCH_TUNING_ENABLED ? "" : " (search parameters need -DCACHEMISS_TUNE=ON)"));
+                        return;
+                    }
+                }
+            }
+
+            GameState game(task.fen, slot.tc, slot.adjudication);
+            while (!game.check_end() && !halt.load(std::memory_order_relaxed)) {
+                int role = (game.white_to_move() == task.engine1_is_white) ? 0 : 1;
+                MoveResult move = engines[role].think(game);
+                if (halt.load(std::memory_order_relaxed)) break;  // Search may have been cut short
+                game.apply_move(move, slot.names[task.players[role]]);
+            }
+            if (!game.is_over()) break;
+
+            std::lock_guard<std::mutex> lock(source_mutex);
+            slot.source.game_finished(task, game.get_outcome());
+        }
+        log_msg("Slot[" + std::to_string(slot.id) + "] no more games");
+    }
+
+public:
+    ~InProcessMux() {
+        halt.store(true);
+        for (auto& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    void set_interrupt_fd(int fd) { interrupt_fd = fd; }
+
+    // Start a slot thread; engine_paths only name the players
+    void add_slot(GameSource& source, const std::vector<std::string>& engine_paths,
+                  const TimeControl& tc, const Adjudication& adjudication, int hash_mb,
+                  std::array<int, 2> cpus = {-1, -1}) {
+        Slot slot{static_cast<int>(threads.size()), source, engine_paths, tc, adjudication, hash_mb, cpus[0]};
+        active.fetch_add(1);
+        threads.emplace_back([this, slot] {
+            play(slot);
+            active.fetch_sub(1);
+        });
+    }
+
+    // Same contract as EngineMux::run
+    void run(std::atomic<bool>& stop) {
+        constexpr int STOP_CHECK_MS = 100;
+        while (!stop.load(std::memory_order_acquire) && active.load() > 0) {
+            struct pollfd pfd = {interrupt_fd, POLLIN, 0};
+            int n = poll(&pfd, interrupt_fd >= 0 ? 1 : 0, STOP_CHECK_MS);
+            if (n > 0 && (pfd.revents & POLLIN)) {
+                char c;
+                (void)read(interrupt_fd, &c, 1);
+                log_msg("InProcessMux: interrupted");
+                stop.store(true);
+            }
+        }
+
+        // Searches in progress see the stop flag within a few thousand nodes
+        halt.store(true);
+        if (active.load() > 0) g_search_controller.request_stop();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+        g_search_controller.reset();
+    }
+};
+
+// Play a source's games on `slots` concurrent slots, with engine processes or
+// in-process, until the source runs out, stop is set or a signal arrives
+void run_slots(bool in_process, GameSource& source, const std::vector<std::string>& engine_paths,
+               const TimeControl& tc, const Adjudication& adjudication, int hash_mb, int slots,
+               const std::vector<std::array<int, 2>>& affinity, std::atomic<bool>& stop) {
+    auto run = [&](auto& mux) {
+        mux.set_interrupt_fd(g_signal_pipe[0]);
+        for (int i = 0; i < slots && !stop.load(); ++i) {
+            mux.add_slot(source, engine_paths, tc, adjudication, hash_mb, affinity[i]);
+        }
+        mux.run(stop);
+    };
+    if (in_process) {
+        InProcessMux mux;
+        run(mux);
+    } else {
+        EngineMux mux;
+        run(mux);
+    }
+}
+
+// Parse EPD file - simple format: just FEN strings, one per line
+std::vector<std::string> parse_epd_file(const std::string& filename) {
+    std::vector<std::string> positions;
+    std::ifstream file(filename);
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[0] != '#') {
+            // EPD might have operations after FEN, just take first 4-6 fields
+            positions.push_back(line);
+        }
+    }
+
+    return positions;
+}
+
+// Thread-safe work queue
+class WorkQueue {
+    std::deque<GameTask> tasks;
+    std::mutex mtx;
+
+public:
+    void push(GameTask task) {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks.push_back(std::move(task));
+    }
+
+    bool pop(GameTask& task) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (tasks.empty()) return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+
+    // Oldest task played by the same two engines (either role), else the
+    // oldest task: lets a slot keep its engine processes between games
+    bool pop(GameTask& task, std::array<int, 2> players) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (tasks.empty()) return false;
+        auto it = std::find_if(tasks.begin(), tasks.end(), [&](const GameTask& t) {
+            return (t.players[0] == players[0] && t.players[1] == players[1]) ||
+                   (t.players[0] == players[1] && t.players[1] == players[0]);
+        });
+        if (it == tasks.end()) it = tasks.begin();
+        task = std::move(*it);
+        tasks.erase(it);
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return tasks.size();
+    }
+};
+
+// Game result for reporting
+struct GameReport {
+    int game_id;
+    GameOutcome outcome;
+    bool engine1_is_white;
+    std::string fen;
+};
+
+// ============================================================================
+// SPRT (sequential probability ratio test)
+// ============================================================================
+// Uses the normal approximation of the generalized SPRT on logistic Elo:
+//   LLR ~= N * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance)
+// where s0/s1 are the expected scores at elo0/elo1 and mean/variance are the
+// per-sample score statistics. With paired openings (colors reversed) the
+// samples are game pairs scored 0, 1/4, ... 1 (pentanomial), which removes
+// the opening bias from the variance; otherwise single games (trinomial).
+
+struct SprtConfig {
+    bool enabled = false;
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+};
+
+enum class SprtState { Continue, AcceptH0, AcceptH1 };
+
+struct SprtStatus {
+    double llr = 0.0;
+    double elo = 0.0;
+    double elo_error = 0.0;  // 95% confidence half-width
+    SprtState state = SprtState::Continue;
+};
+
+class Sprt {
+    SprtConfig config;
+
+    static double expected_score(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+    static double score_to_elo(double score) {
+        score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    }
+
+public:
+    explicit Sprt(const SprtConfig& cfg = {}) : config(cfg) {}
+
+    const SprtConfig& get_config() const { return config; }
+    double lower_bound() const { return std::log(config.beta / (1.0 - config.alpha)); }
+    double upper_bound() const { return std::log((1.0 - config.beta) / config.alpha); }
+
+    // counts[i] samples scored scores[i] (scores in [0, 1])
+    SprtStatus status(const double* scores, const int* counts, int n) const {
+        SprtStatus st;
+        double total = 0, sum = 0;
+        for (int i = 0; i < n; ++i) {
+            total += counts[i];
+            sum += counts[i] * scores[i];
+        }
+        if (total == 0) return st;
+        double mean = sum / total;
+        double variance = 0;
+        for (int i = 0; i < n; ++i) {
+            variance += counts[i] * (scores[i] - mean) * (scores[i] - mean);
+        }
+        variance /= total;
+
+        st.elo = score_to_elo(mean);
+        if (variance > 0) {
+            double s0 = expected_score(config.elo0);
+            double s1 = expected_score(config.elo1);
+            st.llr = total * (s1 - s0) * (2 * mean - s0 - s1) / (2 * variance);
+            double margin = 1.96 * std::sqrt(variance / total);
+            st.elo_error = (score_to_elo(mean + margin) - score_to_elo(mean - margin)) / 2;
+        }
+        if (st.llr >= upper_bound()) st.state = SprtState::AcceptH1;
+        else if (st.llr <= lower_bound()) st.state = SprtState::AcceptH0;
+        return st;
+    }
+};
+
+std::string format_nodes(u64 n);
+
+// Per-engine search speed over the match. The first games set a baseline;
+// when the average of the most recent games falls well below it the machine
+// is oversubscribed (or throttling) and results get noisy.
+class NpsMonitor {
+public:
+    static constexpr int WINDOW = 8;             // Games per average
+    static constexpr double DROP_RATIO = 0.85;   // Warn below this fraction of the baseline
+    static constexpr u64 MIN_TIME_MS = 100;      // Ignore games with too little search time
+
+private:
+    struct Track {
+        double baseline_sum = 0;
+        int baseline_games = 0;
+        std::deque<double> recent;
+        bool dropped = false;
+    };
+    Track tracks[2];
+
+public:
+    // Add one game's totals for an engine. Returns true when the engine's
+    // recent NPS has just dropped below DROP_RATIO of its baseline.
+    bool add(int engine, u64 nodes, u64 time_ms) {
+        if (time_ms < MIN_TIME_MS || nodes == 0) return false;
+        Track& t = tracks[engine];
+        double nps = nodes * 1000.0 / time_ms;
+        if (t.baseline_games < WINDOW) {
+            t.baseline_sum += nps;
+            t.baseline_games++;
+        }
+        t.recent.push_back(nps);
+        if (t.recent.size() > WINDOW) t.recent.pop_front();
+
+        if (t.baseline_games < WINDOW || t.recent.size() < WINDOW) return false;
+        double ratio = recent(engine) / baseline(engine);
+        if (!t.dropped && ratio < DROP_RATIO) {
+            t.dropped = true;
+            return true;
+        }
+        if (t.dropped && ratio > (1.0 + DROP_RATIO) / 2) {
+            t.dropped = false;  // Recovered; warn again on the next drop
+        }
+        return false;
+    }
+
+    double baseline(int engine) const {
+        const Track& t = tracks[engine];
+        return t.baseline_games > 0 ? t.baseline_sum / t.baseline_games : 0.0;
+    }
+
+    double recent(int engine) const {
+        const Track& t = tracks[engine];
+        if (t.recent.empty()) return 0.0;
+        double sum = 0;
+        for (double nps : t.recent) sum += nps;
+        return sum / t.recent.size();
+    }
+
+    bool is_dropped(int engine) const { return tracks[engine].dropped; }
+};
+
+// Thread-safe results collector with running stats
+class ResultsCollector {
+    std::vector<GameReport> results;
+    std::mutex mtx;
+    std::atomic<int> completed{0};
+    std::atomic<int> wins1{0};
+    std::atomic<int> wins2{0};
+    std::atomic<int> draws{0};
     std::atomic<u64> total_depth1{0};
     std::atomic<u64> total_depth2{0};
     std::atomic<u64> total_nodes1{0};
     std::atomic<u64> total_nodes2{0};
     std::atomic<u64> total_moves1{0};
     std::atomic<u64> total_moves2{0};
+    std::atomic<u64> total_time1{0};
+    std::atomic<u64> total_time2{0};
+    std::atomic<int> forfeits1{0};     // Games engine1 lost on time
+    std::atomic<int> forfeits2{0};
+    std::atomic<int> adjudicated_wins{0};
+    std::atomic<int> adjudicated_draws{0};
+    std::atomic<int> failed{0};        // Crashed or hung games, left out of the score
     int total_games;
 
+    // Pentanomial counts over game pairs (game ids 2k and 2k+1 share an
+    // opening with colors reversed): engine1 scored 0, 0.5, 1, 1.5, 2
+    bool paired;
+    int pentanomial[5] = {0, 0, 0, 0, 0};
+    std::unordered_map<int, double> half_pairs;  // pair id -> score of the finished game
+    Sprt sprt;
+    bool sprt_concluded = false;
+    NpsMonitor nps;
+
 public:
-    ResultsCollector(int total) : total_games(total) {}
+    ResultsCollector(int total, bool paired_openings = false, const SprtConfig& sprt_config = {})
+        : total_games(total), paired(paired_openings), sprt(sprt_config) {}
+
+    // A game that never reached a result: it scores nothing for either engine
+    // and leaves its opening pair incomplete, so it cannot move the SPRT
+    void add_failed() { failed++; }
 
-    void add(GameReport report) {
+    // Returns true exactly once: for the game that made the SPRT cross a bound
+    bool add(GameReport report) {
         // Update running stats
         switch (report.outcome.result) {
             case GameResult::WhiteWin:
@@ -838,6 +1852,8 @@ public:
             total_nodes2.fetch_add(report.outcome.black_nodes);
             total_moves1.fetch_add(report.outcome.white_moves);
             total_moves2.fetch_add(report.outcome.black_moves);
+            total_time1.fetch_add(report.outcome.white_time_ms);
+            total_time2.fetch_add(report.outcome.black_time_ms);
         } else {
             total_depth1.fetch_add(report.outcome.black_depth);
             total_depth2.fetch_add(report.outcome.white_depth);
@@ -845,11 +1861,89 @@ public:
             total_nodes2.fetch_add(report.outcome.white_nodes);
             total_moves1.fetch_add(report.outcome.black_moves);
             total_moves2.fetch_add(report.outcome.white_moves);
+            total_time1.fetch_add(report.outcome.black_time_ms);
+            total_time2.fetch_add(report.outcome.white_time_ms);
+        }
+
+        if (report.outcome.termination == Termination::TimeForfeit) {
+            bool white_lost = report.outcome.result == GameResult::BlackWin;
+            if (white_lost == report.engine1_is_white) forfeits1++; else forfeits2++;
+        }
+        if (report.outcome.termination == Termination::Adjudication) {
+            if (report.outcome.result == GameResult::Draw) adjudicated_draws++; else adjudicated_wins++;
+        }
+
+        double score1 = 0.5;
+        if (report.outcome.result != GameResult::Draw) {
+            score1 = ((report.outcome.result == GameResult::WhiteWin) == report.engine1_is_white) ? 1.0 : 0.0;
         }
 
         std::lock_guard<std::mutex> lock(mtx);
+        const GameOutcome& o = report.outcome;
+        u64 side_nodes[2] = {report.engine1_is_white ? o.white_nodes : o.black_nodes,
+                             report.engine1_is_white ? o.black_nodes : o.white_nodes};
+        u64 side_time[2] = {report.engine1_is_white ? o.white_time_ms : o.black_time_ms,
+                            report.engine1_is_white ? o.black_time_ms : o.white_time_ms};
+        for (int e = 0; e < 2; ++e) {
+            if (nps.add(e, side_nodes[e], side_time[e])) {
+                console_msg("WARNING: engine" + std::to_string(e + 1) + " NPS dropped to " +
+                            format_nodes(static_cast<u64>(nps.recent(e))) + " (baseline " +
+                            format_nodes(static_cast<u64>(nps.baseline(e))) +
+                            ") - machine oversubscribed?");
+                log_msg("NPS drop: engine" + std::to_string(e + 1));
+            }
+        }
+
+        if (paired) {
+            int pair_id = report.game_id / 2;
+            auto it = half_pairs.find(pair_id);
+            if (it == half_pairs.end()) {
+                half_pairs.emplace(pair_id, score1);
+            } else {
+                pentanomial[static_cast<int>((it->second + score1) * 2 + 0.5)]++;
+                half_pairs.erase(it);
+            }
+        }
         results.push_back(std::move(report));
         completed++;
+
+        if (!sprt.get_config().enabled || sprt_concluded) return false;
+        sprt_concluded = status_locked().state != SprtState::Continue;
+        return sprt_concluded;
+    }
+
+private:
+    SprtStatus status_locked() const {
+        if (paired) {
+            static constexpr double PAIR_SCORES[5] = {0.0, 0.25, 0.5, 0.75, 1.0};
+            return sprt.status(PAIR_SCORES, pentanomial, 5);
+        }
+        static constexpr double GAME_SCORES[3] = {0.0, 0.5, 1.0};
+        int trinomial[3] = {wins2.load(), draws.load(), wins1.load()};
+        return sprt.status(GAME_SCORES, trinomial, 3);
+    }
+
+public:
+    SprtStatus get_sprt_status() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return status_locked();
+    }
+
+    const Sprt& get_sprt() const { return sprt; }
+
+    // Recent and baseline NPS of engine 0/1, and whether it has dropped
+    void get_nps(int engine, double& recent, double& baseline, bool& dropped) {
+        std::lock_guard<std::mutex> lock(mtx);
+        recent = nps.recent(engine);
+        baseline = nps.baseline(engine);
+        dropped = nps.is_dropped(engine);
+    }
+    bool is_paired() const { return paired; }
+
+    // LL, LD, DD+WL, WD, WW from engine1's point of view
+    std::array<int, 5> get_pentanomial() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return {pentanomial[0], pentanomial[1], pentanomial[2], pentanomial[3], pentanomial[4]};
     }
 
     int get_completed() const { return completed.load(); }
@@ -863,10 +1957,180 @@ public:
     u64 get_total_nodes2() const { return total_nodes2.load(); }
     u64 get_total_moves1() const { return total_moves1.load(); }
     u64 get_total_moves2() const { return total_moves2.load(); }
+    u64 get_total_time1() const { return total_time1.load(); }
+    u64 get_total_time2() const { return total_time2.load(); }
+    int get_forfeits1() const { return forfeits1.load(); }
+    int get_forfeits2() const { return forfeits2.load(); }
+    int get_adjudicated_wins() const { return adjudicated_wins.load(); }
+    int get_adjudicated_draws() const { return adjudicated_draws.load(); }
+    int get_failed() const { return failed.load(); }
+
+    std::vector<GameReport> get_results() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return results;
+    }
+};
+
+// ============================================================================
+// Results log (JSONL) for resumable matches
+// ============================================================================
+// One JSON object per finished game, flushed as soon as the game ends so an
+// interrupted match loses at most the games in progress. -resume reads the
+// file back, feeds the stored games to the ResultsCollector and skips their
+// game ids. Games lost to an engine failure are not stored and are replayed.
+
+static const char* result_name(GameResult result) {
+    switch (result) {
+        case GameResult::WhiteWin: return "1-0";
+        case GameResult::BlackWin: return "0-1";
+        default:                   return "1/2-1/2";
+    }
+}
+
+static const char* draw_reason_name(DrawReason reason) {
+    switch (reason) {
+        case DrawReason::FiftyMove:            return "fifty_move";
+        case DrawReason::Repetition:           return "repetition";
+        case DrawReason::Stalemate:            return "stalemate";
+        case DrawReason::InsufficientMaterial: return "insufficient_material";
+        default:                               return "none";
+    }
+}
+
+static const char* termination_name(Termination termination) {
+    switch (termination) {
+        case Termination::TimeForfeit:  return "time_forfeit";
+        case Termination::IllegalMove:  return "illegal_move";
+        case Termination::Adjudication: return "adjudication";
+        default:                        return "normal";
+    }
+}
+
+static std::string json_escape(const std::string& str) {
+    std::string out;
+    for (char c : str) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// Raw value of "key" in a flat JSON object written by ResultsLog (strings
+// unquoted and unescaped); empty if missing
+static std::string json_field(const std::string& line, const std::string& key) {
+    std::string pattern = "\"" + key + "\":";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) return "";
+    pos += pattern.size();
+    std::string value;
+    if (pos < line.size() && line[pos] == '"') {
+        for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+            if (line[pos] == '\\' && pos + 1 < line.size()) ++pos;
+            value += line[pos];
+        }
+        return value;
+    }
+    size_t end = line.find_first_of(",}", pos);
+    return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+class ResultsLog {
+    std::string names[2];  // engine1, engine2
+    FILE* file = nullptr;
+
+public:
+    ResultsLog(const std::string& engine1, const std::string& engine2) : names{engine1, engine2} {}
+    ~ResultsLog() { close(); }
+
+    // Open for appending (resume) or truncate. When appending, a last line
+    // cut short by a crash is dropped first (load() skips it too), so the
+    // next record starts on a line of its own
+    bool open(const std::string& path, bool append) {
+        close();
+        std::error_code ec;
+        u64 size = append ? std::filesystem::file_size(path, ec) : 0;
+        if (!ec && size > 0) {
+            std::ifstream in(path, std::ios::binary);
+            u64 keep = size;
+            for (char c = 0; keep > 0 && in.seekg(keep - 1).get(c) && c != '\n';) keep--;
+            if (keep < size) std::filesystem::resize_file(path, keep, ec);
+        }
+        file = std::fopen(path.c_str(), append ? "a" : "w");
+        return file != nullptr;
+    }
 
-    std::vector<GameReport> get_results() {
-        std::lock_guard<std::mutex> lock(mtx);
-        return results;
+    void close() {
+        if (!file) return;
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    void write(const GameReport& report) {
+        if (!file) return;
+        const GameOutcome& o = report.outcome;
+        std::fprintf(file, "{\"game_id\":%d,\"engine1\":\"%s\",\"engine2\":\"%s\",\"engine1_white\":%s,\"fen\":\"%s\"",
+                     report.game_id, json_escape(names[0]).c_str(), json_escape(names[1]).c_str(),
+                     report.engine1_is_white ? "true" : "false", json_escape(report.fen).c_str());
+        std::fprintf(file, ",\"result\":\"%s\",\"draw_reason\":\"%s\",\"termination\":\"%s\",\"plies\":%d,\"final_fen\":\"%s\"",
+                     result_name(o.result), draw_reason_name(o.draw_reason), termination_name(o.termination),
+                     o.num_moves, json_escape(o.final_fen).c_str());
+        std::fprintf(file, ",\"white_depth\":%llu,\"black_depth\":%llu,\"white_nodes\":%llu,\"black_nodes\":%llu",
+                     (unsigned long long)o.white_depth, (unsigned long long)o.black_depth,
+                     (unsigned long long)o.white_nodes, (unsigned long long)o.black_nodes);
+        std::fprintf(file, ",\"white_moves\":%llu,\"black_moves\":%llu,\"white_time_ms\":%llu,\"black_time_ms\":%llu}\n",
+                     (unsigned long long)o.white_moves, (unsigned long long)o.black_moves,
+                     (unsigned long long)o.white_time_ms, (unsigned long long)o.black_time_ms);
+        std::fflush(file);
+    }
+
+    // Games stored in a results file; a truncated last line (crash while
+    // writing) is skipped
+    static std::vector<GameReport> load(const std::string& path) {
+        std::vector<GameReport> reports;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line.back() != '}') continue;
+            std::string id = json_field(line, "game_id");
+            std::string result = json_field(line, "result");
+            if (id.empty() || result.empty()) continue;
+
+            GameReport report;
+            report.game_id = std::stoi(id);
+            report.engine1_is_white = json_field(line, "engine1_white") == "true";
+            report.fen = json_field(line, "fen");
+
+            GameOutcome& o = report.outcome;
+            o.result = result == "1-0" ? GameResult::WhiteWin : result == "0-1" ? GameResult::BlackWin : GameResult::Draw;
+            o.draw_reason = DrawReason::None;
+            std::string reason = json_field(line, "draw_reason");
+            for (DrawReason r : {DrawReason::FiftyMove, DrawReason::Repetition, DrawReason::Stalemate,
+                                 DrawReason::InsufficientMaterial}) {
+                if (reason == draw_reason_name(r)) o.draw_reason = r;
+            }
+            std::string termination = json_field(line, "termination");
+            for (Termination t : {Termination::TimeForfeit, Termination::IllegalMove, Termination::Adjudication}) {
+                if (termination == termination_name(t)) o.termination = t;
+            }
+            auto number = [&](const char* key) {
+                std::string v = json_field(line, key);
+                return v.empty() ? 0ULL : std::stoull(v);
+            };
+            o.num_moves = static_cast<int>(number("plies"));
+            o.final_fen = json_field(line, "final_fen");
+            o.white_depth = number("white_depth");
+            o.black_depth = number("black_depth");
+            o.white_nodes = number("white_nodes");
+            o.black_nodes = number("black_nodes");
+            o.white_moves = number("white_moves");
+            o.black_moves = number("black_moves");
+            o.white_time_ms = number("white_time_ms");
+            o.black_time_ms = number("black_time_ms");
+            reports.push_back(std::move(report));
+        }
+        return reports;
     }
 };
 
@@ -881,7 +2145,9 @@ struct GameDisplay {
     std::vector<std::string> moves;  // UCI moves
     GameResult result = GameResult::Draw;
     DrawReason draw_reason = DrawReason::None;
+    Termination termination = Termination::Normal;
     bool finished = false;
+    bool failed = false;         // Finished without a result (engine crash or hang)
     bool engine1_is_white = true;
     int view_move_index = -1;  // -1 means show latest position
 };
@@ -913,11 +2179,21 @@ public:
         }
     }
 
-    void finish_game(int game_id, GameResult result, DrawReason reason) {
+    void finish_game(int game_id, GameResult result, DrawReason reason,
+                     Termination termination = Termination::Normal) {
         std::lock_guard<std::mutex> lock(mtx);
         if (game_id < (int)games.size()) {
             games[game_id].result = result;
             games[game_id].draw_reason = reason;
+            games[game_id].termination = termination;
+            games[game_id].finished = true;
+        }
+    }
+
+    void fail_game(int game_id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (game_id < (int)games.size()) {
+            games[game_id].failed = true;
             games[game_id].finished = true;
         }
     }
@@ -1080,201 +2356,943 @@ Element render_moves(const std::vector<std::string>& moves, int highlight_index)
     return hflow(parts);
 }
 
-Element render_game_card(const GameDisplay& game, const std::string& engine1_name, const std::string& engine2_name, bool selected, int card_width) {
-    // Header with game number and status
-    std::string status;
-    if (game.finished) {
-        switch (game.result) {
-            case GameResult::WhiteWin: status = "1-0"; break;
-            case GameResult::BlackWin: status = "0-1"; break;
-            case GameResult::Draw: status = "1/2"; break;
+Element render_game_card(const GameDisplay& game, const std::string& engine1_name, const std::string& engine2_name, bool selected, int card_width) {
+    // Header with game number and status
+    std::string status;
+    if (game.failed) {
+        status = "error";
+    } else if (game.finished) {
+        switch (game.result) {
+            case GameResult::WhiteWin: status = "1-0"; break;
+            case GameResult::BlackWin: status = "0-1"; break;
+            case GameResult::Draw: status = "1/2"; break;
+        }
+        if (game.draw_reason != DrawReason::None) {
+            switch (game.draw_reason) {
+                case DrawReason::Stalemate: status += " stale"; break;
+                case DrawReason::FiftyMove: status += " 50mv"; break;
+                case DrawReason::Repetition: status += " rep"; break;
+                case DrawReason::InsufficientMaterial: status += " insuf"; break;
+                default: break;
+            }
+        }
+        if (game.termination == Termination::TimeForfeit) status += " time";
+        if (game.termination == Termination::IllegalMove) status += " illegal";
+        if (game.termination == Termination::Adjudication) status += " adj";
+    } else {
+        status = "...";
+    }
+
+    std::string header = "Game " + std::to_string(game.game_id + 1) + " [" + status + "]";
+
+    // Show which engine is which color - truncate names to fit
+    const std::string& white_path = game.engine1_is_white ? engine1_name : engine2_name;
+    const std::string& black_path = game.engine1_is_white ? engine2_name : engine1_name;
+    std::string white_name = white_path.substr(white_path.rfind('/') + 1);
+    std::string black_name = black_path.substr(black_path.rfind('/') + 1);
+
+    // Truncate engine names if too long (card_width - border(2) - "W:"(2) - padding)
+    int max_name_len = card_width - 6;
+    if ((int)white_name.length() > max_name_len) {
+        white_name = white_name.substr(0, max_name_len - 2) + "..";
+    }
+    if ((int)black_name.length() > max_name_len) {
+        black_name = black_name.substr(0, max_name_len - 2) + "..";
+    }
+
+    // Determine which position and move to show
+    int view_idx = game.view_move_index;
+    int total_moves = (int)game.moves.size();
+    std::string display_fen = get_fen_at_move(game, view_idx);
+
+    // Move indicator: show "move X/Y" or "latest"
+    std::string move_info;
+    if (view_idx < 0 || view_idx >= total_moves - 1) {
+        move_info = "move " + std::to_string(total_moves) + "/" + std::to_string(total_moves);
+    } else {
+        move_info = "move " + std::to_string(view_idx + 1) + "/" + std::to_string(total_moves);
+    }
+
+    // Inner width for content (excluding border)
+    int inner_width = card_width - 2;
+
+    auto card = vbox({
+        text(header) | bold,
+        hbox({text("W:") | dim, text(white_name)}),
+        hbox({text("B:") | dim, text(black_name)}),
+        text(move_info) | dim,
+        separator(),
+        render_board(display_fen),
+        separator(),
+        render_moves(game.moves, view_idx) | size(WIDTH, EQUAL, inner_width) | size(HEIGHT, LESS_THAN, 4),
+    }) | size(WIDTH, EQUAL, inner_width);
+
+    if (selected) {
+        card = card | border | color(ftxui::Color::Yellow);
+    } else {
+        card = card | border;
+    }
+
+    return card;
+}
+
+// ============================================================================
+// PGN output
+// ============================================================================
+// Finished games are queued by the event loop and formatted/written by one
+// background thread through a large stdio buffer, so disk I/O never delays a
+// bestmove. Each move carries a comment "{score/depth time n=nodes nps=nps}"
+// with the score from the mover's point of view.
+
+class PgnWriter {
+    struct Entry {
+        int game_id;
+        bool engine1_is_white;
+        std::array<int, 2> players;
+        std::string fen;
+        GameOutcome outcome;
+    };
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+    static constexpr size_t LINE_WIDTH = 80;
+
+    std::vector<std::string> names;  // Indexed like GameTask::players
+    std::string time_control;
+    std::string event;
+    std::thread writer;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Entry> queue;
+    FILE* file = nullptr;
+    std::unique_ptr<char[]> buffer;
+    bool stopping = false;
+
+    static const char* termination_string(Termination termination) {
+        switch (termination) {
+            case Termination::TimeForfeit: return "time forfeit";
+            case Termination::IllegalMove: return "rules infraction";
+            case Termination::Adjudication: return "adjudication";
+            default:                       return "normal";
+        }
+    }
+
+    static std::string ending_comment(const GameOutcome& outcome) {
+        switch (outcome.termination) {
+            case Termination::TimeForfeit: return outcome.result == GameResult::WhiteWin ? "Black loses on time" : "White loses on time";
+            case Termination::IllegalMove: return outcome.result == GameResult::WhiteWin ? "Black makes an illegal move" : "White makes an illegal move";
+            case Termination::Adjudication:
+                if (outcome.result == GameResult::Draw) return "Draw by adjudication";
+                return outcome.result == GameResult::WhiteWin ? "White wins by adjudication" : "Black wins by adjudication";
+            default: break;
+        }
+        switch (outcome.draw_reason) {
+            case DrawReason::FiftyMove:            return "Draw by fifty moves rule";
+            case DrawReason::Repetition:           return "Draw by 3-fold repetition";
+            case DrawReason::Stalemate:            return "Draw by stalemate";
+            case DrawReason::InsufficientMaterial: return "Draw by insufficient mating material";
+            default: break;
+        }
+        if (outcome.result == GameResult::Draw) return "Draw by move limit";
+        return outcome.result == GameResult::WhiteWin ? "White mates" : "Black mates";
+    }
+
+    static std::string move_comment(const MoveRecord& m) {
+        std::ostringstream ss;
+        if (m.has_score) {
+            if (m.mate) {
+                ss << (m.score > 0 ? "+M" : "-M") << std::abs(m.score);
+            } else {
+                ss << std::showpos << std::fixed << std::setprecision(2) << m.score / 100.0 << std::noshowpos;
+            }
+            ss << "/" << m.depth << " ";
+        }
+        u64 nps = m.time_ms > 0 ? m.nodes * 1000 / static_cast<u64>(m.time_ms) : 0;
+        ss << std::fixed << std::setprecision(3) << m.time_ms / 1000.0 << "s n=" << m.nodes << " nps=" << nps;
+        return ss.str();
+    }
+
+    void writer_loop() {
+        std::deque<Entry> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty() && stopping) return;
+                batch.swap(queue);
+            }
+            for (const auto& entry : batch) {
+                write_game(entry);
+            }
+            batch.clear();
+            std::fflush(file);
+        }
+    }
+
+    void write_game(const Entry& entry) {
+        const GameOutcome& outcome = entry.outcome;
+        const std::string& white = names[entry.players[entry.engine1_is_white ? 0 : 1]];
+        const std::string& black = names[entry.players[entry.engine1_is_white ? 1 : 0]];
+        const char* result = result_name(outcome.result);
+
+        char date[16];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+        std::fprintf(file, "[Event \"%s\"]\n[Site \"?\"]\n[Date \"%s\"]\n[Round \"%d\"]\n",
+                     event.c_str(), date, entry.game_id + 1);
+        std::fprintf(file, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n",
+                     white.c_str(), black.c_str(), result);
+        std::fprintf(file, "[FEN \"%s\"]\n[SetUp \"1\"]\n[TimeControl \"%s\"]\n",
+                     entry.fen.c_str(), time_control.c_str());
+        std::fprintf(file, "[Termination \"%s\"]\n[PlyCount \"%zu\"]\n\n",
+                     termination_string(outcome.termination), outcome.moves.size());
+
+        // Move number and side to move from the FEN's 2nd and 6th fields
+        std::istringstream fields(entry.fen);
+        std::string placement, side, castling, ep;
+        int halfmove = 0, fullmove = 1;
+        fields >> placement >> side >> castling >> ep >> halfmove >> fullmove;
+        bool white_moves = side != "b";
+        if (fullmove < 1) fullmove = 1;
+
+        std::string line;
+        auto emit = [&](const std::string& token) {
+            if (!line.empty() && line.size() + 1 + token.size() > LINE_WIDTH) {
+                std::fprintf(file, "%s\n", line.c_str());
+                line.clear();
+            }
+            if (!line.empty()) line += ' ';
+            line += token;
+        };
+
+        for (size_t i = 0; i < outcome.moves.size(); ++i) {
+            const MoveRecord& m = outcome.moves[i];
+            if (white_moves) {
+                emit(std::to_string(fullmove) + ". " + m.san);
+            } else {
+                emit(i == 0 ? std::to_string(fullmove) + "... " + m.san : m.san);
+                fullmove++;
+            }
+            emit("{" + move_comment(m) + "}");
+            white_moves = !white_moves;
+        }
+        emit("{" + ending_comment(outcome) + "}");
+        emit(result);
+        std::fprintf(file, "%s\n\n", line.c_str());
+    }
+
+public:
+    PgnWriter(std::vector<std::string> engine_names, const TimeControl& tc)
+        : names(std::move(engine_names)), event("CacheMiss match (" + tc.describe() + ")") {
+        if (tc.mode == TimeControl::Mode::Clock) {
+            std::ostringstream ss;
+            ss << tc.base_ms / 1000.0 << "+" << tc.inc_ms / 1000.0;
+            time_control = ss.str();
+        } else if (tc.mode == TimeControl::Mode::MoveTime) {
+            std::ostringstream ss;
+            ss << "1/" << tc.movetime_ms / 1000.0;
+            time_control = ss.str();
+        } else {
+            time_control = "-";
+        }
+    }
+
+    ~PgnWriter() { close(); }
+
+    // Open (append) the file and start the writer thread
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "a");
+        if (!file) return false;
+        if (!buffer) buffer.reset(new char[BUFFER_BYTES]);
+        std::setvbuf(file, buffer.get(), _IOFBF, BUFFER_BYTES);
+        stopping = false;
+        writer = std::thread(&PgnWriter::writer_loop, this);
+        return true;
+    }
+
+    // Drain the queue and stop the writer thread
+    void close() {
+        if (!file) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        writer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    // Queue a finished game (no-op if the file is closed)
+    void write(const GameTask& task, const GameOutcome& outcome) {
+        if (!file) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.push_back({task.game_id, task.engine1_is_white, task.players, task.fen, outcome});
+        }
+        cv.notify_one();
+    }
+};
+
+// Prints line() every interval from a background thread until destroyed
+// (headless matches and tournaments)
+class ProgressReporter {
+    std::function<std::string()> line;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::thread thread;
+
+public:
+    static constexpr std::chrono::seconds DEFAULT_INTERVAL{10};
+
+    explicit ProgressReporter(std::function<std::string()> progress_line,
+                              std::chrono::seconds interval = DEFAULT_INTERVAL)
+        : line(std::move(progress_line)) {
+        thread = std::thread([this, interval] {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!cv.wait_for(lock, interval, [this] { return stopping; })) {
+                std::cout << line() << std::endl;
+            }
+        });
+    }
+
+    ~ProgressReporter() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+};
+
+// ============================================================================
+// Match games: work queue -> slots -> results and TUI state
+// ============================================================================
+
+class MatchSource : public GameSource {
+    WorkQueue& work_queue;
+    ResultsCollector& results;
+    GameStateManager* state;             // TUI state (null when headless)
+    std::function<void()> exit_ui;       // Leave the TUI (no-op when headless)
+    std::atomic<bool>& fatal_error;
+    std::atomic<bool>& all_done;
+    PgnWriter* pgn;
+    ResultsLog* results_log;
+
+    void report(const GameTask& task, const GameOutcome& outcome, bool store) {
+        // Mark game as finished in TUI state
+        // Note: UI refresh is handled by dedicated refresh thread
+        if (state) state->finish_game(task.game_id, outcome.result, outcome.draw_reason, outcome.termination);
+
+        GameReport report;
+        report.game_id = task.game_id;
+        report.outcome = outcome;
+        report.outcome.moves.clear();  // Only the PGN needs them
+        report.engine1_is_white = task.engine1_is_white;
+        report.fen = task.fen;
+        if (store && results_log) results_log->write(report);
+
+        if (results.add(std::move(report))) {
+            // SPRT bound crossed: stop all games and leave the TUI
+            SprtStatus st = results.get_sprt_status();
+            console_msg(std::string("SPRT: ") + (st.state == SprtState::AcceptH1 ? "H1" : "H0") + " accepted");
+            log_msg("SPRT concluded, stopping match");
+            all_done.store(true);
+            exit_ui();
+        }
+    }
+
+public:
+    MatchSource(WorkQueue& queue, ResultsCollector& collector, GameStateManager* game_state,
+                std::function<void()> exit_ui_fn, std::atomic<bool>& fatal, std::atomic<bool>& done,
+                PgnWriter* pgn_writer, ResultsLog* log)
+        : work_queue(queue), results(collector), state(game_state), exit_ui(std::move(exit_ui_fn)),
+          fatal_error(fatal), all_done(done), pgn(pgn_writer), results_log(log) {}
+
+    bool next_game(GameTask& task) override {
+        return !all_done.load() && work_queue.pop(task);
+    }
+
+    void game_moved(const GameTask& task, const std::string& fen, const std::vector<std::string>& moves) override {
+        if (state) state->update_game(task.game_id, fen, moves);
+    }
+
+    void game_finished(const GameTask& task, const GameOutcome& outcome) override {
+        if (pgn) pgn->write(task, outcome);
+        report(task, outcome, true);
+    }
+
+    void game_failed(const GameTask& task, const std::string& error) override {
+        // Game-level error (e.g., engine crashed mid-game). There is no result
+        // to score, so it is counted apart from W/D/L and the SPRT; it is not
+        // stored either, so -resume replays it
+        console_msg("Game " + std::to_string(task.game_id + 1) + " error: " + error);
+        if (state) state->fail_game(task.game_id);
+        results.add_failed();
+    }
+
+    void slot_failed(int slot_id, const std::string& error) override {
+        // Engines failed to start
+        console_msg("Slot " + std::to_string(slot_id) + " fatal error: " + error);
+        fatal_error.store(true);
+        all_done.store(true);
+        exit_ui();
+    }
+};
+
+// ============================================================================
+// SPSA tuning (headless)
+// ============================================================================
+// Tunes engine UCI spin options (e.g. a -DCACHEMISS_TUNE=ON build's search
+// parameters). Each iteration draws a random +-1 direction per parameter and
+// plays a game pair from one opening, engine1 with theta + c_k * delta and
+// engine2 with theta - c_k * delta, colors swapped between the two games.
+// theta then moves by r_k * c_k * result * delta. Game slots run several
+// iterations concurrently; schedule constants follow the usual fishtest
+// formulation with A = 0.1 * iterations, alpha = 0.602, gamma = 0.101.
+//
+// Parameter file, one per line: name, value, min, max, c_end, r_end
+// The same format is written back after every iteration.
+
+struct SpsaParam {
+    std::string name;
+    double value;
+    double min, max;
+    double c_end, r_end;
+    double c = 0, a = 0;  // Schedule constants derived from c_end/r_end
+};
+
+std::vector<SpsaParam> parse_spsa_file(const std::string& filename) {
+    std::vector<SpsaParam> params;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream iss(line);
+        SpsaParam p;
+        if (iss >> p.name >> p.value >> p.min >> p.max >> p.c_end >> p.r_end) {
+            params.push_back(p);
+        }
+    }
+    return params;
+}
+
+class SpsaTuner {
+    static constexpr double ALPHA = 0.602;
+    static constexpr double GAMMA = 0.101;
+
+    std::vector<SpsaParam> params;
+    int iterations;
+    double big_a;
+    std::string out_file;
+    std::mutex mtx;
+    std::mt19937_64 rng{std::random_device{}()};
+    int next_k = 0;
+    int completed = 0;
+    double total_result = 0;
+
+    void write_params() {
+        std::string tmp = out_file + ".tmp";
+        std::ofstream out(tmp);
+        out << "# SPSA iteration " << completed << "/" << iterations << "\n";
+        for (const auto& p : params) {
+            out << p.name << ", " << std::round(p.value * 100) / 100 << ", " << p.min << ", " << p.max
+                << ", " << p.c_end << ", " << p.r_end << "\n";
+        }
+        out.close();
+        std::rename(tmp.c_str(), out_file.c_str());
+    }
+
+public:
+    struct Trial {
+        int k = 0;
+        double c_k_scale = 0;                // (k)^-gamma, c_k = c * scale per parameter
+        std::vector<int> delta;              // +1 / -1 per parameter
+        std::vector<int> plus, minus;        // Rounded, clamped values sent to the engines
+    };
+
+    SpsaTuner(std::vector<SpsaParam> p, int n, std::string out)
+        : params(std::move(p)), iterations(n), big_a(0.1 * n), out_file(std::move(out)) {
+        for (auto& param : params) {
+            param.c = param.c_end * std::pow(iterations, GAMMA);
+            double a_end = param.r_end * param.c_end * param.c_end;
+            param.a = a_end * std::pow(big_a + iterations, ALPHA);
+        }
+    }
+
+    const std::vector<SpsaParam>& get_params() const { return params; }
+
+    bool next_trial(Trial& trial) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (next_k >= iterations) return false;
+        trial.k = ++next_k;
+        trial.c_k_scale = std::pow(trial.k, -GAMMA);
+        trial.delta.clear();
+        trial.plus.clear();
+        trial.minus.clear();
+        for (const auto& p : params) {
+            int d = (rng() & 1) ? 1 : -1;
+            double c_k = p.c * trial.c_k_scale;
+            trial.delta.push_back(d);
+            trial.plus.push_back(static_cast<int>(std::lround(std::clamp(p.value + c_k * d, p.min, p.max))));
+            trial.minus.push_back(static_cast<int>(std::lround(std::clamp(p.value - c_k * d, p.min, p.max))));
+        }
+        return true;
+    }
+
+    // result: game pair score of the plus side minus the minus side, in [-2, 2]
+    void report(const Trial& trial, double result) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::ostringstream line;
+        line << "iter " << trial.k << "/" << iterations << " result " << std::showpos << result << std::noshowpos;
+        for (size_t i = 0; i < params.size(); ++i) {
+            auto& p = params[i];
+            double c_k = p.c * trial.c_k_scale;
+            double a_k = p.a / std::pow(big_a + trial.k, ALPHA);
+            double r_k = a_k / (c_k * c_k);
+            p.value = std::clamp(p.value + r_k * c_k * result * trial.delta[i], p.min, p.max);
+            line << " " << p.name << "=" << std::fixed << std::setprecision(2) << p.value;
+        }
+        completed++;
+        total_result += result;
+        write_params();
+        std::cout << line.str() << std::endl;
+        log_msg("SPSA " + line.str());
+    }
+};
+
+// Score of `engine1` in one game (+1 win, 0 draw, -1 loss)
+static double engine1_score(const GameOutcome& outcome, bool engine1_is_white) {
+    if (outcome.result == GameResult::Draw) return 0;
+    bool white_won = outcome.result == GameResult::WhiteWin;
+    return (white_won == engine1_is_white) ? 1 : -1;
+}
+
+// Hands out each SPSA iteration as two games (engine1 = theta+ as white, then
+// as black) and reports the iteration once both have finished. The two games
+// may run on different slots at the same time.
+class SpsaSource : public GameSource {
+    struct PendingTrial {
+        SpsaTuner::Trial trial;
+        double result = 0;
+        int games_done = 0;
+    };
+
+    SpsaTuner& tuner;
+    const std::vector<std::string>& positions;
+    PgnWriter* pgn;
+    std::unordered_map<int, PendingTrial> pending;  // By iteration k
+    int second_game_k = 0;  // Iteration whose reversed-color game is still to be handed out
+
+public:
+    SpsaSource(SpsaTuner& spsa_tuner, const std::vector<std::string>& position_list, PgnWriter* pgn_writer)
+        : tuner(spsa_tuner), positions(position_list), pgn(pgn_writer) {}
+
+    bool next_game(GameTask& task) override {
+        int k;
+        bool engine1_white;
+        if (second_game_k != 0) {
+            k = second_game_k;
+            second_game_k = 0;
+            engine1_white = false;
+        } else {
+            SpsaTuner::Trial trial;
+            if (!tuner.next_trial(trial)) return false;
+            k = trial.k;
+            pending[k].trial = std::move(trial);
+            second_game_k = k;
+            engine1_white = true;
+        }
+
+        const SpsaTuner::Trial& trial = pending[k].trial;
+        const auto& params = tuner.get_params();
+        task.fen = positions[(k - 1) % positions.size()];
+        task.engine1_is_white = engine1_white;
+        task.game_id = 2 * (k - 1) + (engine1_white ? 0 : 1);
+        task.tag = k;
+        task.options[0].clear();
+        task.options[1].clear();
+        for (size_t i = 0; i < params.size(); ++i) {
+            task.options[0].emplace_back(params[i].name, std::to_string(trial.plus[i]));
+            task.options[1].emplace_back(params[i].name, std::to_string(trial.minus[i]));
+        }
+        return true;
+    }
+
+    void game_finished(const GameTask& task, const GameOutcome& outcome) override {
+        auto it = pending.find(task.tag);
+        if (pgn) pgn->write(task, outcome);
+        if (it == pending.end()) return;  // Other game of the pair failed
+        it->second.result += engine1_score(outcome, task.engine1_is_white);
+        if (++it->second.games_done == 2) {
+            tuner.report(it->second.trial, it->second.result);
+            pending.erase(it);
+        }
+    }
+
+    void game_failed(const GameTask& task, const std::string& error) override {
+        std::cerr << "SPSA iteration " << task.tag << " dropped: " << error << std::endl;
+        pending.erase(task.tag);
+        if (second_game_k == task.tag) second_game_k = 0;
+    }
+
+    void slot_failed(int slot_id, const std::string& error) override {
+        std::cerr << "SPSA slot " << slot_id << " error: " << error << std::endl;
+    }
+};
+
+int run_spsa(const std::string& engine1_path, const std::string& engine2_path, const std::string& spsa_file,
+             const std::string& out_file, int iterations, const TimeControl& tc, const Adjudication& adjudication,
+             int hash_mb, int concurrency, bool in_process,
+             const std::vector<std::string>& positions, const std::vector<std::array<int, 2>>& affinity,
+             PgnWriter* pgn) {
+    std::vector<SpsaParam> params = parse_spsa_file(spsa_file);
+    if (params.empty()) {
+        std::cerr << "No SPSA parameters in " << spsa_file << std::endl;
+        return 1;
+    }
+
+    SpsaTuner tuner(params, iterations, out_file);
+    std::cout << "SPSA: " << params.size() << " parameters, " << iterations << " iterations, "
+              << concurrency << " concurrent games, writing " << out_file << std::endl;
+
+    if (!init_signal_pipe()) {
+        std::cerr << "Failed to create signal pipe" << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    // The signal pipe interrupts the event loop; games in progress are discarded
+    SpsaSource source(tuner, positions, pgn);
+    std::vector<std::string> engine_paths = {engine1_path, engine2_path};
+    std::atomic<bool> stop{false};
+    run_slots(in_process, source, engine_paths, tc, adjudication, hash_mb, concurrency, affinity, stop);
+    if (stop.load()) {
+        std::cout << "Stopped (unfinished iterations are discarded)" << std::endl;
+    }
+    close_signal_pipe();
+    return 0;
+}
+
+// ============================================================================
+// Tournaments: gauntlet / round-robin over N engines (headless)
+// ============================================================================
+// Every pairing plays every opening -games times with colors alternating.
+// Gauntlet: the first engine against each of the others; round-robin: every
+// pair. Slots take tasks of the pairing they already have loaded, so engine
+// processes only restart when a slot moves on to another pairing.
+//
+// Ratings are the maximum-likelihood logistic Elo fit over all games (draws
+// count half), with one virtual draw per played pairing so a perfect score
+// stays finite. Error bars are the 95% interval of each engine's score
+// against its opponents (plus the same virtual draw), converted to Elo.
+
+std::vector<std::array<int, 2>> tournament_pairings(int engines, bool gauntlet) {
+    std::vector<std::array<int, 2>> pairings;
+    for (int a = 0; a < engines; ++a) {
+        for (int b = a + 1; b < engines; ++b) {
+            if (gauntlet && a != 0) break;
+            pairings.push_back({a, b});
+        }
+    }
+    return pairings;
+}
+
+class TournamentTable {
+    struct Record {
+        int wins = 0, draws = 0, losses = 0;
+        int games() const { return wins + draws + losses; }
+        double points() const { return wins + 0.5 * draws; }
+    };
+
+    std::vector<std::string> names;
+    std::vector<std::vector<Record>> vs;  // vs[i][j]: results of engine i against engine j
+    int played = 0;
+    bool gauntlet;
+    mutable std::mutex mtx;
+
+    // Elo and error of a record, with one virtual draw
+    static SprtStatus score_status(const Record& r) {
+        static constexpr double GAME_SCORES[3] = {0.0, 0.5, 1.0};
+        int counts[3] = {r.losses, r.draws + 1, r.wins};
+        return Sprt().status(GAME_SCORES, counts, 3);
+    }
+
+    Record total_locked(int i) const {
+        Record total;
+        for (const Record& r : vs[i]) {
+            total.wins += r.wins;
+            total.draws += r.draws;
+            total.losses += r.losses;
         }
-        if (game.draw_reason != DrawReason::None) {
-            switch (game.draw_reason) {
-                case DrawReason::Stalemate: status += " stale"; break;
-                case DrawReason::FiftyMove: status += " 50mv"; break;
-                case DrawReason::Repetition: status += " rep"; break;
-                case DrawReason::InsufficientMaterial: status += " insuf"; break;
-                default: break;
+        return total;
+    }
+
+    // Newton iterations per engine on the log-likelihood; the gauntlet is
+    // anchored at its first engine, a round-robin at the mean rating
+    std::vector<double> ratings_locked() const {
+        constexpr int MAX_ITERATIONS = 1000;
+        constexpr double MAX_STEP = 100.0;
+        const double elo_per_logit = 400.0 / std::log(10.0);
+        int n = static_cast<int>(names.size());
+        std::vector<double> rating(n, 0.0);
+
+        for (int iter = 0; iter < MAX_ITERATIONS; ++iter) {
+            double largest = 0;
+            for (int i = 0; i < n; ++i) {
+                double actual = 0, expected = 0, information = 0;
+                for (int j = 0; j < n; ++j) {
+                    const Record& r = vs[i][j];
+                    if (j == i || r.games() == 0) continue;
+                    double games = r.games() + 1.0;  // + one virtual draw
+                    double p = 1.0 / (1.0 + std::pow(10.0, (rating[j] - rating[i]) / 400.0));
+                    actual += r.points() + 0.5;
+                    expected += games * p;
+                    information += games * p * (1 - p);
+                }
+                if (information <= 0) continue;
+                double step = std::clamp((actual - expected) / information * elo_per_logit, -MAX_STEP, MAX_STEP);
+                rating[i] += step;
+                largest = std::max(largest, std::abs(step));
             }
+            if (largest < 1e-3) break;
         }
-    } else {
-        status = "...";
+
+        double anchor = 0;
+        if (gauntlet) {
+            anchor = rating[0];
+        } else {
+            for (double r : rating) anchor += r;
+            anchor /= n;
+        }
+        for (double& r : rating) r -= anchor;
+        return rating;
     }
 
-    std::string header = "Game " + std::to_string(game.game_id + 1) + " [" + status + "]";
+public:
+    TournamentTable(std::vector<std::string> engine_names, bool gauntlet_mode)
+        : names(std::move(engine_names)),
+          vs(names.size(), std::vector<Record>(names.size())),
+          gauntlet(gauntlet_mode) {}
 
-    // Show which engine is which color - truncate names to fit
-    const std::string& white_path = game.engine1_is_white ? engine1_name : engine2_name;
-    const std::string& black_path = game.engine1_is_white ? engine2_name : engine1_name;
-    std::string white_name = white_path.substr(white_path.rfind('/') + 1);
-    std::string black_name = black_path.substr(black_path.rfind('/') + 1);
+    void add(const GameTask& task, const GameOutcome& outcome) {
+        int a = task.players[0], b = task.players[1];
+        std::lock_guard<std::mutex> lock(mtx);
+        played++;
+        if (outcome.result == GameResult::Draw) {
+            vs[a][b].draws++;
+            vs[b][a].draws++;
+        } else if ((outcome.result == GameResult::WhiteWin) == task.engine1_is_white) {
+            vs[a][b].wins++;
+            vs[b][a].losses++;
+        } else {
+            vs[a][b].losses++;
+            vs[b][a].wins++;
+        }
+    }
 
-    // Truncate engine names if too long (card_width - border(2) - "W:"(2) - padding)
-    int max_name_len = card_width - 6;
-    if ((int)white_name.length() > max_name_len) {
-        white_name = white_name.substr(0, max_name_len - 2) + "..";
+    int games_played() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return played;
     }
-    if ((int)black_name.length() > max_name_len) {
-        black_name = black_name.substr(0, max_name_len - 2) + "..";
+
+    // "name +12 name -3 ..." in rating order
+    std::string ratings_line() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<double> rating = ratings_locked();
+        std::vector<int> order(names.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::sort(order.begin(), order.end(), [&](int x, int y) { return rating[x] > rating[y]; });
+        std::ostringstream ss;
+        ss << std::showpos << std::fixed << std::setprecision(0);
+        for (int i : order) ss << " " << names[i] << " " << rating[i];
+        return ss.str();
     }
 
-    // Determine which position and move to show
-    int view_idx = game.view_move_index;
-    int total_moves = (int)game.moves.size();
-    std::string display_fen = get_fen_at_move(game, view_idx);
+    void print(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<double> rating = ratings_locked();
+        std::vector<int> order(names.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+        std::sort(order.begin(), order.end(), [&](int x, int y) { return rating[x] > rating[y]; });
+
+        size_t width = 4;
+        for (const auto& name : names) width = std::max(width, name.size());
+
+        out << "\nRank  " << std::left << std::setw(width) << "Name" << std::right
+            << "      Elo     +/-   Games   Score      W      D      L\n";
+        int rank = 1;
+        for (int i : order) {
+            Record total = total_locked(i);
+            SprtStatus st = score_status(total);
+            double score = total.games() > 0 ? 100.0 * total.points() / total.games() : 0.0;
+            out << std::setw(4) << rank++ << "  " << std::left << std::setw(width) << names[i] << std::right
+                << std::fixed << std::setprecision(1) << std::showpos << std::setw(9) << rating[i]
+                << std::noshowpos << std::setw(8) << st.elo_error
+                << std::setw(8) << total.games() << std::setw(7) << score << "%"
+                << std::setw(7) << total.wins << std::setw(7) << total.draws << std::setw(7) << total.losses << "\n";
+        }
 
-    // Move indicator: show "move X/Y" or "latest"
-    std::string move_info;
-    if (view_idx < 0 || view_idx >= total_moves - 1) {
-        move_info = "move " + std::to_string(total_moves) + "/" + std::to_string(total_moves);
-    } else {
-        move_info = "move " + std::to_string(view_idx + 1) + "/" + std::to_string(total_moves);
+        if (gauntlet) {
+            out << "\nHead to head (" << names[0] << "):\n";
+            for (size_t j = 1; j < names.size(); ++j) {
+                const Record& r = vs[0][j];
+                if (r.games() == 0) continue;
+                SprtStatus st = score_status(r);
+                out << "  vs " << std::left << std::setw(width) << names[j] << std::right
+                    << std::fixed << std::setprecision(1) << std::showpos << std::setw(9) << st.elo
+                    << std::noshowpos << " +/- " << st.elo_error
+                    << "  [W:" << r.wins << " D:" << r.draws << " L:" << r.losses << "]\n";
+            }
+        }
+        out << std::defaultfloat;
     }
+};
 
-    // Inner width for content (excluding border)
-    int inner_width = card_width - 2;
+class TournamentSource : public GameSource {
+    WorkQueue& work_queue;
+    TournamentTable& table;
+    const std::vector<std::string>& names;
+    PgnWriter* pgn;
+    std::atomic<bool>& fatal_error;
+    std::atomic<bool>& stop;
 
-    auto card = vbox({
-        text(header) | bold,
-        hbox({text("W:") | dim, text(white_name)}),
-        hbox({text("B:") | dim, text(black_name)}),
-        text(move_info) | dim,
-        separator(),
-        render_board(display_fen),
-        separator(),
-        render_moves(game.moves, view_idx) | size(WIDTH, EQUAL, inner_width) | size(HEIGHT, LESS_THAN, 4),
-    }) | size(WIDTH, EQUAL, inner_width);
+public:
+    TournamentSource(WorkQueue& queue, TournamentTable& results, const std::vector<std::string>& engine_names,
+                     PgnWriter* pgn_writer, std::atomic<bool>& fatal, std::atomic<bool>& stop_flag)
+        : work_queue(queue), table(results), names(engine_names), pgn(pgn_writer),
+          fatal_error(fatal), stop(stop_flag) {}
 
-    if (selected) {
-        card = card | border | color(ftxui::Color::Yellow);
-    } else {
-        card = card | border;
+    bool next_game(GameTask& task) override {
+        return !stop.load() && work_queue.pop(task, task.players);
     }
 
-    return card;
-}
-
-// ============================================================================
-// Worker thread function (updated for TUI)
-// ============================================================================
+    void game_finished(const GameTask& task, const GameOutcome& outcome) override {
+        if (pgn) pgn->write(task, outcome);
+        table.add(task, outcome);
+    }
 
-void worker_thread(
-    int thread_id,
-    const std::string& engine1_path,
-    const std::string& engine2_path,
-    int movetime_ms,
-    int hash_mb,
-    WorkQueue& work_queue,
-    ResultsCollector& results,
-    GameStateManager& state,
-    ScreenInteractive& screen,
-    std::atomic<bool>& fatal_error,
-    std::atomic<bool>& all_done,
-    std::atomic<bool>& screen_exiting
-) {
-    log_msg("Worker[" + std::to_string(thread_id) + "] started");
-
-    // Check if there's any work before creating expensive engine processes
-    if (work_queue.size() == 0) {
-        log_msg("Worker[" + std::to_string(thread_id) + "] no work available, exiting early");
-        return;
+    void game_failed(const GameTask& task, const std::string& error) override {
+        std::cerr << "Game " << task.game_id + 1 << " (" << names[task.players[0]] << " vs "
+                  << names[task.players[1]] << ") dropped: " << error << std::endl;
     }
 
-    try {
-        // Each thread has its own engine instances
-        log_msg("Worker[" + std::to_string(thread_id) + "] creating engine1: " + engine1_path);
-        Engine engine1(engine1_path);
-        log_msg("Worker[" + std::to_string(thread_id) + "] creating engine2: " + engine2_path);
-        Engine engine2(engine2_path);
-        log_msg("Worker[" + std::to_string(thread_id) + "] both engines created");
+    void slot_failed(int slot_id, const std::string& error) override {
+        std::cerr << "Slot " << slot_id << " fatal error: " << error << std::endl;
+        fatal_error.store(true);
+        stop.store(true);
+    }
+};
 
-        // Configure hash table size
-        if (hash_mb > 0) {
-            log_msg("Worker[" + std::to_string(thread_id) + "] setting hash to " + std::to_string(hash_mb) + "MB");
-            engine1.set_hash(hash_mb, &all_done);
-            engine2.set_hash(hash_mb, &all_done);
+int run_tournament(const std::vector<std::string>& engine_paths, const std::vector<std::string>& names,
+                   bool gauntlet, const std::vector<std::string>& positions, int games_per_position,
+                   const TimeControl& tc, const Adjudication& adjudication, int hash_mb, int concurrency,
+                   const std::function<std::vector<std::array<int, 2>>(int)>& make_affinity, PgnWriter* pgn) {
+    WorkQueue work_queue;
+    auto pairings = tournament_pairings(static_cast<int>(engine_paths.size()), gauntlet);
+    int total_games = 0;
+    for (const auto& fen : positions) {
+        for (const auto& pairing : pairings) {
+            for (int game = 0; game < games_per_position; ++game) {
+                GameTask task;
+                task.fen = fen;
+                task.engine1_is_white = (game % 2 == 0);
+                task.game_id = total_games++;
+                task.players = pairing;
+                work_queue.push(task);
+            }
         }
+    }
+    concurrency = std::max(1, std::min(concurrency, total_games));
+    std::vector<std::array<int, 2>> affinity = make_affinity(concurrency);
+
+    std::cout << (gauntlet ? "Gauntlet: " : "Round-robin: ") << engine_paths.size() << " engines, "
+              << pairings.size() << " pairings, " << total_games << " games, " << tc.describe() << ", "
+              << concurrency << " concurrent" << std::endl;
+    for (size_t i = 0; i < engine_paths.size(); ++i) {
+        std::cout << "  " << names[i] << ": " << engine_paths[i] << std::endl;
+    }
 
-        GameTask task;
-        while (!fatal_error.load() && !all_done.load() && work_queue.pop(task)) {
-            Engine& white = task.engine1_is_white ? engine1 : engine2;
-            Engine& black = task.engine1_is_white ? engine2 : engine1;
-            const std::string& white_name = task.engine1_is_white ? engine1_path : engine2_path;
-            const std::string& black_name = task.engine1_is_white ? engine2_path : engine1_path;
-
-            // Set game_id on both engines for logging
-            engine1.set_game_id(task.game_id);
-            engine2.set_game_id(task.game_id);
-
-            // Callback to update TUI on each move
-            // Note: UI refresh is handled by dedicated refresh thread (10Hz) to avoid event queue flooding
-            int game_id = task.game_id;
-            auto on_move = [&state, game_id](int, const std::string& fen, const std::vector<std::string>& moves) {
-                state.update_game(game_id, fen, moves);
-            };
+    if (!init_signal_pipe()) {
+        std::cerr << "Failed to create signal pipe" << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
 
-            try {
-                GameOutcome outcome = play_game(white, black, task.fen, movetime_ms, white_name, black_name, on_move, &all_done);
-
-                // Mark game as finished in TUI state
-                // Note: UI refresh is handled by dedicated refresh thread
-                state.finish_game(task.game_id, outcome.result, outcome.draw_reason);
-
-                GameReport report;
-                report.game_id = task.game_id;
-                report.outcome = outcome;
-                report.engine1_is_white = task.engine1_is_white;
-                report.fen = task.fen;
-
-                results.add(std::move(report));
-            } catch (const std::exception& e) {
-                // Game-level error (e.g., engine crashed mid-game)
-                // Mark as loss for the side whose engine crashed, but we can't tell which
-                // So mark as draw and continue
-                console_msg("Game " + std::to_string(task.game_id + 1) + " error: " + e.what());
-                log_msg("Worker[" + std::to_string(thread_id) + "] game error, exiting: " + e.what());
-
-                GameOutcome outcome;
-                outcome.result = GameResult::Draw;
-                outcome.draw_reason = DrawReason::None;
-                outcome.num_moves = 0;
-
-                state.finish_game(task.game_id, outcome.result, outcome.draw_reason);
-
-                GameReport report;
-                report.game_id = task.game_id;
-                report.outcome = outcome;
-                report.engine1_is_white = task.engine1_is_white;
-                report.fen = task.fen;
-                results.add(std::move(report));
-
-                // Engine crashed, can't continue with this thread's engines
-                // Exit the loop - engines are broken
-                break;
-            }
+    TournamentTable table(names, gauntlet);
+    std::atomic<bool> fatal_error{false};
+    std::atomic<bool> stop{false};
+    TournamentSource source(work_queue, table, names, pgn, fatal_error, stop);
+    auto start_time = std::chrono::steady_clock::now();
+    auto elapsed_s = [&] {
+        return (long long)std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    };
+    auto progress_line = [&] {
+        return "[" + std::to_string(table.games_played()) + "/" + std::to_string(total_games) + "]" +
+               table.ratings_line() + " | " + std::to_string(elapsed_s()) + "s";
+    };
+    {
+        ProgressReporter progress(progress_line);
+        EngineMux mux;
+        mux.set_interrupt_fd(g_signal_pipe[0]);
+        for (int i = 0; i < concurrency && !stop.load(); ++i) {
+            mux.add_slot(source, engine_paths, tc, adjudication, hash_mb, affinity[i]);
         }
-    } catch (const std::exception& e) {
-        // Thread-level error (e.g., engine failed to start)
-        console_msg("Thread " + std::to_string(thread_id) + " fatal error: " + e.what());
-        log_msg("Worker[" + std::to_string(thread_id) + "] fatal error: " + e.what());
-        fatal_error.store(true);
-        screen_exiting.store(true);
-        // Post exit request to main thread (screen.Exit() is not thread-safe)
-        screen.Post([&] { screen.Exit(); });
+        mux.run(stop);
     }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    close_signal_pipe();
+
+    std::cout << "\n" << table.games_played() << "/" << total_games << " games in " << elapsed_s() << "s" << std::endl;
+    table.print(std::cout);
+    return fatal_error.load() ? 1 : 0;
 }
 
 void print_usage(const char* prog) {
-    std::cerr << "Usage: " << prog << " <engine1> <engine2> [options]\n"
+    std::cerr << "Usage: " << prog << " <engine1> <engine2> [<engine3> ...] [options]\n"
+              << "       " << prog << " -inprocess [options]\n"
+              << "  An engine argument may be a directory (all executables in it, e.g. builds/).\n"
+              << "  More than two engines play a headless round-robin (or -gauntlet) tournament.\n"
               << "Options:\n"
+              << "  -gauntlet        Tournament: the first engine plays each of the others (default: round-robin)\n"
               << "  -movetime <ms>   Time per move (default: 100)\n"
+              << "  -tc <base+inc>   Clock per side in seconds, e.g. 10+0.1 (go wtime/btime/winc/binc)\n"
+              << "  -timemargin <ms> Clock overrun tolerated before a time forfeit (default: 0)\n"
+              << "  -nodes <n>       Fixed nodes per move (go nodes)\n"
+              << "  -depth <d>       Fixed depth per move (go depth)\n"
+              << "  -resign <n> <cp> Adjudicate a win once both engines gave |score| >= cp for n moves each\n"
+              << "  -draw <m> <n> <cp>  Adjudicate a draw after move m once both gave |score| <= cp for n moves each\n"
               << "  -epd <file>      EPD file with starting positions\n"
               << "  -fen <string>    Single starting position\n"
               << "  -games <n>       Games per position (default: 2)\n"
               << "  -threads <n>     Number of concurrent games (default: CPU count)\n"
-              << "  -hash <mb>       Hash table size per engine (default: 512)\n"
+              << "  -affinity        Pin each game's engines to dedicated CPUs\n"
+              << "  -nosmt           Like -affinity, using one thread per physical core (default -threads: core count)\n"
+              << "  -hash <mb>       Hash table size per engine (default: 512, 16 in-process)\n"
+              << "  -inprocess       No engine processes: the search built into match plays both sides\n"
+              << "                   (one thread per game; -spsa needs a -DCACHEMISS_TUNE=ON build)\n"
               << "  -log <file>      Enable verbose logging to file\n"
+              << "  -pgn <file>      Append finished games to a PGN file (per-move score/depth/time/nodes/nps)\n"
+              << "  -results <file>  Write each finished game as a JSON line (truncated unless -resume)\n"
+              << "  -resume          Continue the match stored in -results, skipping finished games\n"
+              << "  -headless        No TUI: print a progress line every few seconds\n"
+              << "  -sprt <elo0> <elo1>  Stop as soon as an SPRT bound is crossed (-games caps the test)\n"
+              << "  -alpha <a>       SPRT type I error (default: 0.05)\n"
+              << "  -beta <b>        SPRT type II error (default: 0.05)\n"
+              << "  -spsa <file>     SPSA-tune UCI options listed in file (headless, see below)\n"
+              << "  -spsa-iterations <n>  Game pairs to play (default: 1000)\n"
+              << "  -spsa-out <file> Where updated values are written (default: <file>.out)\n"
+              << "\nSPSA file lines: name, value, min, max, c_end, r_end\n"
+              << "  engine1 plays theta+c, engine2 theta-c (normally the same -DCACHEMISS_TUNE=ON build)\n"
               << "\nControls:\n"
               << "  Arrows           Select game\n"
               << "  ,/.              Previous/next move\n"
@@ -1291,24 +3309,79 @@ int main(int argc, char* argv[]) {
     // Ignore SIGPIPE - writing to a pipe after child dies would otherwise crash us
     std::signal(SIGPIPE, SIG_IGN);
 
-    if (argc < 3) {
-        print_usage(argv[0]);
-        return 1;
+    // Engines: every argument before the first option; a directory stands
+    // for all executables in it (e.g. builds/)
+    std::vector<std::string> engine_paths;
+    int first_option = 1;
+    for (; first_option < argc && argv[first_option][0] != '-'; ++first_option) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        if (!fs::is_directory(argv[first_option], ec)) {
+            engine_paths.push_back(argv[first_option]);
+            continue;
+        }
+        std::vector<std::string> executables;
+        for (const auto& entry : fs::directory_iterator(argv[first_option], ec)) {
+            if (entry.is_regular_file() &&
+                (entry.status().permissions() & fs::perms::owner_exec) != fs::perms::none) {
+                executables.push_back(entry.path().string());
+            }
+        }
+        std::sort(executables.begin(), executables.end());
+        for (const auto& exe : executables) {
+            // Skip a candidate that also lives in the directory (gauntlet vs builds/)
+            if (std::find(engine_paths.begin(), engine_paths.end(), exe) == engine_paths.end()) {
+                engine_paths.push_back(exe);
+            }
+        }
     }
-
-    std::string engine1_path = argv[1];
-    std::string engine2_path = argv[2];
-    int movetime_ms = 100;
+    bool gauntlet = false;
+    TimeControl tc;
+    Adjudication adjudication;
     std::string epd_file;
     std::string fen;
     int games_per_position = 2;
     int num_threads = std::thread::hardware_concurrency();
+    bool threads_set = false;
+    bool pin_cpus = false;
+    bool avoid_smt = false;
     int hash_mb = 512;
+    bool hash_set = false;
+    bool in_process = false;
     std::string log_filename;
-
-    for (int i = 3; i < argc; ++i) {
+    std::string pgn_filename;
+    std::string results_filename;
+    bool resume = false;
+    bool headless = false;
+    std::string spsa_file;
+    std::string spsa_out;
+    int spsa_iterations = 1000;
+    SprtConfig sprt_config;
+
+    for (int i = first_option; i < argc; ++i) {
         if (strcmp(argv[i], "-movetime") == 0 && i + 1 < argc) {
-            movetime_ms = std::stoi(argv[++i]);
+            tc.mode = TimeControl::Mode::MoveTime;
+            tc.movetime_ms = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-tc") == 0 && i + 1 < argc) {
+            if (!parse_tc(argv[++i], tc)) {
+                std::cerr << "Invalid -tc '" << argv[i] << "' (expected <base>+<inc> in seconds)" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-timemargin") == 0 && i + 1 < argc) {
+            tc.margin_ms = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+            tc.mode = TimeControl::Mode::Nodes;
+            tc.nodes = std::stoull(argv[++i]);
+        } else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+            tc.mode = TimeControl::Mode::Depth;
+            tc.depth = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-resign") == 0 && i + 2 < argc) {
+            adjudication.resign_moves = std::stoi(argv[++i]);
+            adjudication.resign_cp = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-draw") == 0 && i + 3 < argc) {
+            adjudication.draw_after = std::stoi(argv[++i]);
+            adjudication.draw_moves = std::stoi(argv[++i]);
+            adjudication.draw_cp = std::stoi(argv[++i]);
         } else if (strcmp(argv[i], "-epd") == 0 && i + 1 < argc) {
             epd_file = argv[++i];
         } else if (strcmp(argv[i], "-fen") == 0 && i + 1 < argc) {
@@ -1317,10 +3390,43 @@ int main(int argc, char* argv[]) {
             games_per_position = std::stoi(argv[++i]);
         } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
             num_threads = std::stoi(argv[++i]);
+            threads_set = true;
+        } else if (strcmp(argv[i], "-affinity") == 0) {
+            pin_cpus = true;
+        } else if (strcmp(argv[i], "-nosmt") == 0) {
+            pin_cpus = true;
+            avoid_smt = true;
         } else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
             hash_mb = std::stoi(argv[++i]);
+            hash_set = true;
+        } else if (strcmp(argv[i], "-inprocess") == 0) {
+            in_process = true;
         } else if (strcmp(argv[i], "-log") == 0 && i + 1 < argc) {
             log_filename = argv[++i];
+        } else if (strcmp(argv[i], "-pgn") == 0 && i + 1 < argc) {
+            pgn_filename = argv[++i];
+        } else if (strcmp(argv[i], "-results") == 0 && i + 1 < argc) {
+            results_filename = argv[++i];
+        } else if (strcmp(argv[i], "-resume") == 0) {
+            resume = true;
+        } else if (strcmp(argv[i], "-headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "-gauntlet") == 0) {
+            gauntlet = true;
+        } else if (strcmp(argv[i], "-sprt") == 0 && i + 2 < argc) {
+            sprt_config.enabled = true;
+            sprt_config.elo0 = std::stod(argv[++i]);
+            sprt_config.elo1 = std::stod(argv[++i]);
+        } else if (strcmp(argv[i], "-alpha") == 0 && i + 1 < argc) {
+            sprt_config.alpha = std::stod(argv[++i]);
+        } else if (strcmp(argv[i], "-beta") == 0 && i + 1 < argc) {
+            sprt_config.beta = std::stod(argv[++i]);
+        } else if (strcmp(argv[i], "-spsa") == 0 && i + 1 < argc) {
+            spsa_file = argv[++i];
+        } else if (strcmp(argv[i], "-spsa-iterations") == 0 && i + 1 < argc) {
+            spsa_iterations = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "-spsa-out") == 0 && i + 1 < argc) {
+            spsa_out = argv[++i];
         } else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             print_usage(argv[0]);
@@ -1328,20 +3434,51 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // In-process games are played by the search linked into this binary
+    if (in_process) {
+        if (!engine_paths.empty()) {
+            std::cerr << "-inprocess plays the search built into " << argv[0] << "; don't name engines" << std::endl;
+            return 1;
+        }
+        engine_paths = {"inprocess1", "inprocess2"};
+        headless = true;
+        if (!hash_set) hash_mb = InProcessEngine::DEFAULT_HASH_MB;
+    }
+    if (engine_paths.size() < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string engine1_path = engine_paths[0];
+    std::string engine2_path = engine_paths[1];
+    bool tournament = engine_paths.size() > 2;
+
+    // With -nosmt the default is one game per physical core
+    CpuTopology topo = detect_cpus(avoid_smt);
+    if (avoid_smt && !threads_set && !topo.cpus.empty()) {
+        num_threads = static_cast<int>(topo.cpus.size());
+    }
+
     // Initialize logging if requested
     if (!log_filename.empty()) {
         log_init(log_filename);
         log_msg("Match starting: " + engine1_path + " vs " + engine2_path);
-        log_msg("Options: movetime=" + std::to_string(movetime_ms) + "ms, threads=" +
+        log_msg("Options: " + tc.describe() + ", threads=" +
                 std::to_string(num_threads) + ", hash=" + std::to_string(hash_mb) + "MB");
+        if (adjudication.enabled()) log_msg("Adjudication: " + adjudication.describe());
     }
 
     // Add initialization messages to console
     console_msg("Match: " + engine1_path + " vs " + engine2_path);
-    console_msg("Options: movetime=" + std::to_string(movetime_ms) + "ms, threads=" +
+    console_msg("Options: " + tc.describe() + ", threads=" +
                 std::to_string(num_threads) + ", hash=" + std::to_string(hash_mb) + "MB");
+    if (adjudication.enabled()) console_msg("Adjudication: " + adjudication.describe());
 
     if (num_threads < 1) num_threads = 1;
+    if (resume && results_filename.empty()) {
+        std::cerr << "-resume needs -results <file>" << std::endl;
+        return 1;
+    }
+    console_to_stderr = headless || tournament;
 
     // Collect positions
     std::vector<std::string> positions;
@@ -1359,43 +3496,326 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Engine CPUs per game slot (-1 = not pinned)
+    auto make_affinity = [&](int slots) {
+        for (const auto& warning : oversubscription_warnings(topo, slots, avoid_smt)) {
+            console_msg(warning);
+            log_msg(warning);
+            if (!spsa_file.empty()) std::cerr << warning << std::endl;
+        }
+        if (!pin_cpus) return std::vector<std::array<int, 2>>(slots, {-1, -1});
+        auto plan = plan_affinity(topo, slots);
+        std::ostringstream ss;
+        ss << "Pinning engines:";
+        for (int i = 0; i < slots; ++i) {
+            ss << " [" << plan[i][0] << (plan[i][1] != plan[i][0] ? "," + std::to_string(plan[i][1]) : "") << "]";
+        }
+        console_msg(ss.str());
+        log_msg(ss.str());
+        return plan;
+    };
+
+    // Engine names as shown in the TUI, tables and PGN; the full path
+    // where file names collide
+    auto short_name = [](const std::string& path) {
+        size_t pos = path.rfind('/');
+        return (pos != std::string::npos) ? path.substr(pos + 1) : path;
+    };
+    std::vector<std::string> engine_names;
+    for (const auto& path : engine_paths) {
+        int same = 0;
+        for (const auto& other : engine_paths) same += short_name(other) == short_name(path);
+        engine_names.push_back(same > 1 && tournament ? path : short_name(path));
+    }
+    std::string engine1_short = engine_names[0];
+    std::string engine2_short = engine_names[1];
+
+    // Games are written as they finish
+    PgnWriter pgn(engine_names, tc);
+    if (!pgn_filename.empty() && !pgn.open(pgn_filename)) {
+        std::cerr << "Cannot open PGN file " << pgn_filename << std::endl;
+        return 1;
+    }
+
+    if (tournament) {
+        if (!spsa_file.empty() || sprt_config.enabled || !results_filename.empty()) {
+            std::cerr << "-spsa, -sprt and -results/-resume need exactly two engines" << std::endl;
+            return 1;
+        }
+        int rc = run_tournament(engine_paths, engine_names, gauntlet, positions, games_per_position, tc,
+                                adjudication, hash_mb, num_threads, make_affinity,
+                                pgn.is_open() ? &pgn : nullptr);
+        log_close();
+        return rc;
+    }
+
+    if (!spsa_file.empty()) {
+        if (spsa_out.empty()) spsa_out = spsa_file + ".out";
+        int concurrency = std::max(1, std::min(num_threads, spsa_iterations));
+        int rc = run_spsa(engine1_path, engine2_path, spsa_file, spsa_out, spsa_iterations,
+                          tc, adjudication, hash_mb, concurrency, in_process, positions, make_affinity(concurrency),
+                          pgn.is_open() ? &pgn : nullptr);
+        log_close();
+        return rc;
+    }
+
     // Build work queue and initialize game state
     log_msg("Building work queue from " + std::to_string(positions.size()) + " positions");
-    WorkQueue work_queue;
+    std::vector<GameTask> tasks;
     GameStateManager state;
-    int game_id = 0;
     for (const auto& start_fen : positions) {
         for (int game = 0; game < games_per_position; ++game) {
             GameTask task;
             task.fen = start_fen;
             task.engine1_is_white = (game % 2 == 0);
-            task.game_id = game_id;
-            work_queue.push(task);
-            state.init_game(game_id, start_fen, task.engine1_is_white);
-            game_id++;
+            task.game_id = (int)tasks.size();
+            state.init_game(task.game_id, start_fen, task.engine1_is_white);
+            tasks.push_back(task);
         }
     }
 
-    int total_games = game_id;
+    int total_games = (int)tasks.size();
     log_msg("Total games to play: " + std::to_string(total_games));
     console_msg("Loaded " + std::to_string(positions.size()) + " position(s), " +
                 std::to_string(total_games) + " games total");
 
-    // Don't spawn more threads than games - each thread creates 2 engine processes
-    if (num_threads > total_games) {
-        log_msg("Reducing threads from " + std::to_string(num_threads) + " to " + std::to_string(total_games));
-        num_threads = total_games;
+    // Consecutive games of an opening alternate colors, so with an even count
+    // per opening games 2k/2k+1 form a pair for pentanomial statistics
+    bool paired = games_per_position % 2 == 0;
+    ResultsCollector results(total_games, paired, sprt_config);
+    if (sprt_config.enabled) {
+        const Sprt& sprt = results.get_sprt();
+        std::ostringstream ss;
+        ss << "SPRT: elo0=" << sprt_config.elo0 << " elo1=" << sprt_config.elo1
+           << " alpha=" << sprt_config.alpha << " beta=" << sprt_config.beta
+           << std::fixed << std::setprecision(2) << " bounds [" << sprt.lower_bound() << ", " << sprt.upper_bound() << "]"
+           << (paired ? " (pentanomial)" : " (trinomial, odd -games)");
+        console_msg(ss.str());
+        log_msg(ss.str());
     }
 
-    ResultsCollector results(total_games);
+    // Replay stored games into the results; they must come from the same
+    // openings and -games, otherwise game ids would not line up
+    std::vector<bool> completed(total_games, false);
+    bool sprt_done = false;
+    if (resume) {
+        int resumed = 0;
+        for (GameReport& report : ResultsLog::load(results_filename)) {
+            int id = report.game_id;
+            if (id < 0 || id >= total_games || report.fen != tasks[id].fen ||
+                report.engine1_is_white != tasks[id].engine1_is_white) {
+                std::cerr << results_filename << ": game " << id + 1
+                          << " does not match this match's openings/-games" << std::endl;
+                return 1;
+            }
+            if (completed[id]) continue;
+            completed[id] = true;
+            resumed++;
+            state.update_game(id, report.outcome.final_fen, {});
+            state.finish_game(id, report.outcome.result, report.outcome.draw_reason, report.outcome.termination);
+            sprt_done = results.add(std::move(report)) || sprt_done;
+        }
+        console_msg("Resuming: " + std::to_string(resumed) + " of " + std::to_string(total_games) +
+                    " games already played");
+        log_msg("Resumed " + std::to_string(resumed) + " games from " + results_filename);
+    }
 
-    // Extract short engine names for display
-    auto short_name = [](const std::string& path) {
-        size_t pos = path.rfind('/');
-        return (pos != std::string::npos) ? path.substr(pos + 1) : path;
+    WorkQueue work_queue;
+    int remaining = 0;
+    for (const auto& task : tasks) {
+        if (completed[task.game_id]) continue;
+        work_queue.push(task);
+        remaining++;
+    }
+
+    ResultsLog results_log(engine1_short, engine2_short);
+    if (!results_filename.empty() && !results_log.open(results_filename, resume)) {
+        std::cerr << "Cannot open results file " << results_filename << std::endl;
+        return 1;
+    }
+
+    // Don't spawn more slots than games - each slot creates 2 engine processes
+    if (num_threads > remaining) {
+        log_msg("Reducing threads from " + std::to_string(num_threads) + " to " + std::to_string(remaining));
+        num_threads = remaining;
+    }
+    std::vector<std::array<int, 2>> affinity = make_affinity(num_threads);
+
+    // Final score and statistics over the games actually played
+    auto print_summary = [&](long long elapsed) {
+        // Aggregate final results
+        auto all_results = results.get_results();
+        std::sort(all_results.begin(), all_results.end(),
+                  [](const GameReport& a, const GameReport& b) { return a.game_id < b.game_id; });
+
+        double score1 = 0, score2 = 0;
+        int wins1 = 0, wins2 = 0, draws = 0;
+
+        for (const auto& report : all_results) {
+            double white_score = 0, black_score = 0;
+
+            switch (report.outcome.result) {
+                case GameResult::WhiteWin:
+                    white_score = 1.0;
+                    if (report.engine1_is_white) wins1++; else wins2++;
+                    break;
+                case GameResult::BlackWin:
+                    black_score = 1.0;
+                    if (report.engine1_is_white) wins2++; else wins1++;
+                    break;
+                case GameResult::Draw:
+                    white_score = black_score = 0.5;
+                    draws++;
+                    break;
+            }
+
+            if (report.engine1_is_white) {
+                score1 += white_score;
+                score2 += black_score;
+            } else {
+                score1 += black_score;
+                score2 += white_score;
+            }
+        }
+
+        // Print final score to stdout
+        // Games stopped early (quit, signal or SPRT) are not counted
+        int played = (int)all_results.size();
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "Final Score (" << played << "/" << total_games << " games in " << elapsed << "s):" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        double pct1 = (played > 0) ? (100.0 * score1 / played) : 0;
+        double pct2 = (played > 0) ? (100.0 * score2 / played) : 0;
+
+        std::cout << "  " << engine1_path << ": " << score1 << "/" << played
+                  << " (" << pct1 << "%) [W:" << wins1 << " D:" << draws << " L:" << wins2 << "]" << std::endl;
+        std::cout << "  " << engine2_path << ": " << score2 << "/" << played
+                  << " (" << pct2 << "%) [W:" << wins2 << " D:" << draws << " L:" << wins1 << "]" << std::endl;
+        if (results.get_failed() > 0) {
+            std::cout << "  Failed games: " << results.get_failed()
+                      << " (not scored; -resume replays them)" << std::endl;
+        }
+
+        if (sprt_config.enabled) {
+            SprtStatus st = results.get_sprt_status();
+            const Sprt& sprt = results.get_sprt();
+            const char* verdict = st.state == SprtState::AcceptH1 ? "H1 accepted"
+                                : st.state == SprtState::AcceptH0 ? "H0 accepted" : "inconclusive";
+            std::cout << std::fixed << std::setprecision(2)
+                      << "\nSPRT (" << sprt_config.elo0 << ", " << sprt_config.elo1 << "): " << verdict
+                      << ", LLR " << st.llr << " [" << sprt.lower_bound() << ", " << sprt.upper_bound() << "]"
+                      << std::setprecision(1) << ", Elo " << st.elo << " +/- " << st.elo_error << std::endl;
+            if (paired) {
+                auto p = results.get_pentanomial();
+                std::cout << "  Ptnml(0-2): " << p[0] << ", " << p[1] << ", " << p[2] << ", " << p[3] << ", " << p[4] << std::endl;
+            }
+            std::cout << std::defaultfloat;
+        }
+
+        // Print search statistics
+        u64 moves1 = results.get_total_moves1();
+        u64 moves2 = results.get_total_moves2();
+        u64 depth1 = results.get_total_depth1();
+        u64 depth2 = results.get_total_depth2();
+        u64 nodes1 = results.get_total_nodes1();
+        u64 nodes2 = results.get_total_nodes2();
+
+        if (moves1 > 0 || moves2 > 0) {
+            std::cout << "\nSearch Statistics:" << std::endl;
+            double avg_d1 = (moves1 > 0) ? (double)depth1 / moves1 : 0;
+            double avg_d2 = (moves2 > 0) ? (double)depth2 / moves2 : 0;
+            std::cout << std::fixed << std::setprecision(1);
+            double avg_t1 = (moves1 > 0) ? (double)results.get_total_time1() / moves1 : 0;
+            double avg_t2 = (moves2 > 0) ? (double)results.get_total_time2() / moves2 : 0;
+            std::cout << "  " << engine1_short << ": avg depth " << avg_d1
+                      << ", total nodes " << format_nodes(nodes1)
+                      << ", avg move time " << avg_t1 << "ms"
+                      << " (" << moves1 << " moves)" << std::endl;
+            std::cout << "  " << engine2_short << ": avg depth " << avg_d2
+                      << ", total nodes " << format_nodes(nodes2)
+                      << ", avg move time " << avg_t2 << "ms"
+                      << " (" << moves2 << " moves)" << std::endl;
+            for (int e = 0; e < 2; ++e) {
+                double recent, baseline;
+                bool dropped;
+                results.get_nps(e, recent, baseline, dropped);
+                if (baseline <= 0) continue;
+                std::cout << "  " << (e == 0 ? engine1_short : engine2_short) << ": NPS baseline "
+                          << format_nodes(static_cast<u64>(baseline)) << ", last " << NpsMonitor::WINDOW << " games "
+                          << format_nodes(static_cast<u64>(recent))
+                          << (dropped ? " (dropped - machine oversubscribed?)" : "") << std::endl;
+            }
+            if (tc.mode == TimeControl::Mode::Clock) {
+                std::cout << "  Time forfeits: " << engine1_short << " " << results.get_forfeits1()
+                          << ", " << engine2_short << " " << results.get_forfeits2() << std::endl;
+            }
+            if (adjudication.enabled()) {
+                std::cout << "  Adjudicated: " << results.get_adjudicated_wins() << " wins, "
+                          << results.get_adjudicated_draws() << " draws" << std::endl;
+            }
+        }
     };
-    std::string engine1_short = short_name(engine1_path);
-    std::string engine2_short = short_name(engine2_path);
+
+    // Shared flags for thread coordination
+    std::atomic<bool> fatal_error{false};
+    std::atomic<bool> all_done{false};
+
+    if (resume && (remaining == 0 || sprt_done)) {
+        std::cout << (sprt_done ? "SPRT already concluded" : "All games already played") << " in "
+                  << results_filename << std::endl;
+        print_summary(0);
+        log_close();
+        return 0;
+    }
+
+    if (headless) {
+        std::cout << "Match: " << engine1_short << " vs " << engine2_short << ", " << tc.describe() << ", "
+                  << remaining << " games, " << num_threads << " concurrent" << std::endl;
+        if (!init_signal_pipe()) {
+            std::cerr << "Failed to create signal pipe" << std::endl;
+            return 1;
+        }
+        std::signal(SIGINT, signal_handler);
+        std::signal(SIGTERM, signal_handler);
+
+        auto start_time = std::chrono::steady_clock::now();
+        auto elapsed_s = [&] {
+            return (long long)std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+        };
+        auto progress_line = [&] {
+            int w1 = results.get_wins1(), w2 = results.get_wins2(), d = results.get_draws();
+            int finished = w1 + w2 + d;
+            SprtStatus st = results.get_sprt_status();
+            std::ostringstream ss;
+            ss << "[" << finished << "/" << total_games << "] W:" << w1 << " D:" << d << " L:" << w2
+               << std::fixed << std::setprecision(1)
+               << " (" << (finished > 0 ? 100.0 * (w1 + 0.5 * d) / finished : 0.0) << "%)"
+               << " Elo " << st.elo << " +/- " << st.elo_error;
+            if (int failed = results.get_failed()) ss << " failed:" << failed;
+            if (sprt_config.enabled) ss << std::setprecision(2) << " LLR " << st.llr;
+            ss << " | " << elapsed_s() << "s";
+            return ss.str();
+        };
+
+        // Games run on this thread's event loop (or on in-process slot threads)
+        MatchSource source(work_queue, results, nullptr, [] {}, fatal_error, all_done,
+                           pgn.is_open() ? &pgn : nullptr, results_log.is_open() ? &results_log : nullptr);
+        {
+            ProgressReporter progress(progress_line);
+            run_slots(in_process, source, engine_paths, tc, adjudication, hash_mb, num_threads, affinity, all_done);
+        }
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        close_signal_pipe();
+
+        std::cout << progress_line() << std::endl;
+        print_summary(elapsed_s());
+        log_msg("Match finished");
+        log_close();
+        return fatal_error.load() ? 1 : 0;
+    }
 
     // Create FTXUI screen
     auto screen = ScreenInteractive::Fullscreen();
@@ -1406,9 +3826,6 @@ int main(int argc, char* argv[]) {
     int cols = 1;              // Columns (computed in renderer)
     bool console_expanded = false;  // Whether console panel is expanded
 
-    // Shared flags for thread coordination
-    std::atomic<bool> fatal_error{false};
-    std::atomic<bool> all_done{false};
     std::atomic<bool> screen_exiting{false};  // Prevents posting to screen after exit initiated
 
     // Main UI component
@@ -1419,8 +3836,9 @@ int main(int argc, char* argv[]) {
         int w1 = results.get_wins1();
         int w2 = results.get_wins2();
         int d = results.get_draws();
+        int scored = w1 + w2 + d;  // Failed games are finished but not scored
         double score1 = w1 + 0.5 * d;
-        double pct = (finished > 0) ? (100.0 * score1 / finished) : 0;
+        double pct = (scored > 0) ? (100.0 * score1 / scored) : 0;
 
         // Header
         std::ostringstream header_ss;
@@ -1428,6 +3846,7 @@ int main(int argc, char* argv[]) {
                   << "  |  " << finished << "/" << total_games
                   << " [W:" << w1 << " D:" << d << " L:" << w2
                   << " = " << std::fixed << std::setprecision(1) << pct << "%]";
+        if (int failed = results.get_failed()) header_ss << " failed:" << failed;
 
         // Add depth and nodes stats
         u64 moves1 = results.get_total_moves1();
@@ -1444,6 +3863,17 @@ int main(int argc, char* argv[]) {
                       << " N:" << format_nodes(nodes1) << "/" << format_nodes(nodes2);
         }
 
+        // Recent NPS per engine; "!" marks a drop below the match's baseline
+        double nps_recent[2], nps_baseline[2];
+        bool nps_dropped[2];
+        for (int e = 0; e < 2; ++e) {
+            results.get_nps(e, nps_recent[e], nps_baseline[e], nps_dropped[e]);
+        }
+        if (nps_recent[0] > 0 || nps_recent[1] > 0) {
+            header_ss << " NPS:" << format_nodes(static_cast<u64>(nps_recent[0])) << (nps_dropped[0] ? "!" : "")
+                      << "/" << format_nodes(static_cast<u64>(nps_recent[1])) << (nps_dropped[1] ? "!" : "");
+        }
+
         bool all_complete = (finished >= total_games);
         if (all_complete) {
             header_ss << "  COMPLETE";
@@ -1454,6 +3884,23 @@ int main(int argc, char* argv[]) {
             header = header | color(ftxui::Color::Green);
         }
 
+        if (sprt_config.enabled) {
+            SprtStatus st = results.get_sprt_status();
+            const Sprt& sprt = results.get_sprt();
+            std::ostringstream sprt_ss;
+            sprt_ss << std::fixed << std::setprecision(2)
+                    << "LLR " << st.llr << " [" << sprt.lower_bound() << ", " << sprt.upper_bound() << "]"
+                    << std::setprecision(1) << "  Elo " << st.elo << " +/- " << st.elo_error;
+            if (paired) {
+                auto p = results.get_pentanomial();
+                sprt_ss << "  Ptnml [" << p[0] << ", " << p[1] << ", " << p[2] << ", " << p[3] << ", " << p[4] << "]";
+            }
+            Element sprt_line = text(sprt_ss.str()) | center;
+            if (st.state == SprtState::AcceptH1) sprt_line = sprt_line | color(ftxui::Color::Green);
+            if (st.state == SprtState::AcceptH0) sprt_line = sprt_line | color(ftxui::Color::Red);
+            header = vbox({header, sprt_line});
+        }
+
         // Help line
         Element help = text("Arrows=select  ,/.=move  ;/:=10moves  Home/End=first/last  |=console  q=quit") | dim | center;
 
@@ -1677,29 +4124,38 @@ int main(int argc, char* argv[]) {
         return false;
     });
 
-    // Spawn worker threads (they will wait for screen_ready)
-    log_msg("Main: spawning " + std::to_string(num_threads) + " worker threads");
-    console_msg("Starting " + std::to_string(num_threads) + " worker thread(s)...");
+    // Start the event loop thread (it waits for screen_ready). One thread
+    // drives all games, however many run concurrently.
+    log_msg("Main: starting event loop with " + std::to_string(num_threads) + " game slots");
+    console_msg("Starting " + std::to_string(num_threads) + " concurrent game(s)...");
     auto start_time = std::chrono::steady_clock::now();
     std::atomic<bool> screen_ready{false};
-    std::vector<std::thread> threads;
-    for (int i = 0; i < num_threads; ++i) {
-        threads.emplace_back([&, i]() {
-            log_msg("Thread[" + std::to_string(i) + "] waiting for screen_ready");
-            // Wait for screen to be ready before starting
-            while (!screen_ready.load() && !fatal_error.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            log_msg("Thread[" + std::to_string(i) + "] screen_ready=" + std::to_string(screen_ready.load()) +
-                    ", fatal_error=" + std::to_string(fatal_error.load()));
-            if (!fatal_error.load() && !all_done.load()) {
-                worker_thread(i, engine1_path, engine2_path,
-                             movetime_ms, hash_mb, work_queue, results,
-                             state, screen, fatal_error, all_done, screen_exiting);
-            }
-            log_msg("Thread[" + std::to_string(i) + "] exiting");
-        });
-    }
+    auto exit_ui = [&] {
+        if (!screen_exiting.exchange(true)) {
+            // Post exit request to main thread (screen.Exit() is not thread-safe)
+            screen.Post([&] { screen.Exit(); });
+        }
+    };
+    MatchSource source(work_queue, results, &state, exit_ui, fatal_error, all_done,
+                       pgn.is_open() ? &pgn : nullptr, results_log.is_open() ? &results_log : nullptr);
+    std::thread event_loop_thread([&] {
+        log_msg("Event loop waiting for screen_ready");
+        // Wait for screen to be ready before starting
+        while (!screen_ready.load() && !fatal_error.load() && !all_done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (fatal_error.load() || all_done.load()) return;
+        try {
+            EngineMux mux;
+            for (int i = 0; i < num_threads && !all_done.load(); ++i) {
+                mux.add_slot(source, engine_paths, tc, adjudication, hash_mb, affinity[i]);
+            }
+            mux.run(all_done);
+        } catch (const std::exception& e) {
+            source.slot_failed(-1, e.what());
+        }
+        log_msg("Event loop exiting");
+    });
 
     // Dedicated UI refresh thread - posts at fixed 5Hz rate to avoid event queue flooding
     // This replaces per-game screen.Post() calls from workers which could overwhelm the UI
@@ -1720,9 +4176,7 @@ int main(int argc, char* argv[]) {
         std::cerr << "Failed to create signal pipe" << std::endl;
         fatal_error.store(true);
         all_done.store(true);
-        for (auto& t : threads) {
-            t.join();
-        }
+        event_loop_thread.join();
         refresh_thread.join();
         log_close();
         return 1;
@@ -1782,82 +4236,13 @@ int main(int argc, char* argv[]) {
     close_signal_pipe();
 
     // Wait for all threads to complete
-    for (auto& t : threads) {
-        t.join();
-    }
+    event_loop_thread.join();
     refresh_thread.join();
 
     auto end_time = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time).count();
 
-    // Aggregate final results
-    auto all_results = results.get_results();
-    std::sort(all_results.begin(), all_results.end(),
-              [](const GameReport& a, const GameReport& b) { return a.game_id < b.game_id; });
-
-    double score1 = 0, score2 = 0;
-    int wins1 = 0, wins2 = 0, draws = 0;
-
-    for (const auto& report : all_results) {
-        double white_score = 0, black_score = 0;
-
-        switch (report.outcome.result) {
-            case GameResult::WhiteWin:
-                white_score = 1.0;
-                if (report.engine1_is_white) wins1++; else wins2++;
-                break;
-            case GameResult::BlackWin:
-                black_score = 1.0;
-                if (report.engine1_is_white) wins2++; else wins1++;
-                break;
-            case GameResult::Draw:
-                white_score = black_score = 0.5;
-                draws++;
-                break;
-        }
-
-        if (report.engine1_is_white) {
-            score1 += white_score;
-            score2 += black_score;
-        } else {
-            score1 += black_score;
-            score2 += white_score;
-        }
-    }
-
-    // Print final score to stdout
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "Final Score (" << total_games << " games in " << elapsed << "s):" << std::endl;
-    std::cout << "========================================" << std::endl;
-
-    double pct1 = (total_games > 0) ? (100.0 * score1 / total_games) : 0;
-    double pct2 = (total_games > 0) ? (100.0 * score2 / total_games) : 0;
-
-    std::cout << "  " << engine1_path << ": " << score1 << "/" << total_games
-              << " (" << pct1 << "%) [W:" << wins1 << " D:" << draws << " L:" << wins2 << "]" << std::endl;
-    std::cout << "  " << engine2_path << ": " << score2 << "/" << total_games
-              << " (" << pct2 << "%) [W:" << wins2 << " D:" << draws << " L:" << wins1 << "]" << std::endl;
-
-    // Print search statistics
-    u64 moves1 = results.get_total_moves1();
-    u64 moves2 = results.get_total_moves2();
-    u64 depth1 = results.get_total_depth1();
-    u64 depth2 = results.get_total_depth2();
-    u64 nodes1 = results.get_total_nodes1();
-    u64 nodes2 = results.get_total_nodes2();
-
-    if (moves1 > 0 || moves2 > 0) {
-        std::cout << "\nSearch Statistics:" << std::endl;
-        double avg_d1 = (moves1 > 0) ? (double)depth1 / moves1 : 0;
-        double avg_d2 = (moves2 > 0) ? (double)depth2 / moves2 : 0;
-        std::cout << std::fixed << std::setprecision(1);
-        std::cout << "  " << engine1_short << ": avg depth " << avg_d1
-                  << ", total nodes " << format_nodes(nodes1)
-                  << " (" << moves1 << " moves)" << std::endl;
-        std::cout << "  " << engine2_short << ": avg depth " << avg_d2
-                  << ", total nodes " << format_nodes(nodes2)
-                  << " (" << moves2 << " moves)" << std::endl;
-    }
+    print_summary(elapsed);
 
     log_msg("Match finished");
     log_close();
@@ -0,0 +1,154 @@
+// Search-tree log analysis
+// Reads a log written by `cachemiss --tree-log` (built with -DCACHEMISS_TREE_LOG=ON)
+// and reports how often reduced moves later proved best, per reduction bucket,
+// plus null-move cutoff rates per R and SEE pruning counts.
+//
+// Usage: ./tree_stats <tree.bin> [-min-depth <d>]
+
+#include "tree_log.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+struct PendingMove {
+    u8 move_index;
+    s8 reduction;
+    u8 flags;
+};
+
+struct ReductionBucket {
+    u64 moves = 0;         // Moves searched with this reduction
+    u64 researched = 0;    // Re-searched at full depth
+    u64 proved_best = 0;   // Became the best move of a PV or cut node
+};
+
+struct NullMoveBucket {
+    u64 attempts = 0;
+    u64 cutoffs = 0;
+};
+
+void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <tree.bin> [options]\n"
+              << "Options:\n"
+              << "  -min-depth <d>     Only count nodes searched at depth >= d (default: 0)\n";
+}
+
+double percent(u64 part, u64 total) {
+    return total > 0 ? 100.0 * part / total : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input_file = argv[1];
+    int min_depth = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "-min-depth") == 0 && i + 1 < argc) {
+            min_depth = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream in(input_file, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open " << input_file << std::endl;
+        return 1;
+    }
+
+    TreeLogHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TREE_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.record_size != sizeof(TreeLogRecord)) {
+        std::cerr << input_file << " is not a tree log (or was written by an incompatible build)" << std::endl;
+        return 1;
+    }
+
+    // Moves are written before the node record of their parent, so keep them
+    // pending until the parent's outcome (and best move index) is known
+    std::unordered_map<u32, std::vector<PendingMove>> pending;
+    std::map<int, ReductionBucket> reductions;
+    std::map<int, NullMoveBucket> null_moves;
+    u64 total_records = 0;
+    u64 total_nodes = 0;
+    u64 node_types[3] = {0, 0, 0};
+    u64 see_pruned = 0;
+
+    std::vector<TreeLogRecord> chunk(1 << 16);
+    while (in) {
+        in.read(reinterpret_cast<char*>(chunk.data()), chunk.size() * sizeof(TreeLogRecord));
+        size_t n = static_cast<size_t>(in.gcount()) / sizeof(TreeLogRecord);
+
+        for (size_t i = 0; i < n; ++i) {
+            const TreeLogRecord& r = chunk[i];
+            total_records++;
+            if (r.depth < min_depth) continue;
+
+            if (r.kind == TREE_MOVE) {
+                if (r.flags & TREE_NULL_MOVE) {
+                    auto& bucket = null_moves[r.reduction];
+                    bucket.attempts++;
+                    if (r.score >= r.beta) bucket.cutoffs++;
+                } else if (r.flags & TREE_SEE_PRUNED) {
+                    see_pruned++;
+                } else {
+                    pending[r.node_id].push_back({r.move_index, r.reduction, r.flags});
+                }
+                continue;
+            }
+
+            // TREE_NODE: resolve the node's moves
+            total_nodes++;
+            if (r.node_type < 3) node_types[r.node_type]++;
+
+            auto it = pending.find(r.node_id);
+            if (it == pending.end()) continue;
+            for (const PendingMove& m : it->second) {
+                auto& bucket = reductions[m.reduction];
+                bucket.moves++;
+                if (m.flags & TREE_RESEARCH_DEPTH) bucket.researched++;
+                if (r.node_type != NODE_ALL && m.move_index == r.move_index) bucket.proved_best++;
+            }
+            pending.erase(it);
+        }
+    }
+
+    std::cout << "Records: " << total_records << ", nodes: " << total_nodes
+              << " (PV " << node_types[NODE_PV] << ", cut " << node_types[NODE_CUT]
+              << ", all " << node_types[NODE_ALL] << ")\n";
+    if (!pending.empty()) {
+        std::cout << "Unfinished nodes (search stopped): " << pending.size() << "\n";
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\nLate move reductions\n";
+    std::cout << "   R        moves   re-searched   proved best\n";
+    for (const auto& [r, b] : reductions) {
+        std::cout << std::setw(4) << r
+                  << std::setw(13) << b.moves
+                  << std::setw(13) << percent(b.researched, b.moves) << "%"
+                  << std::setw(13) << percent(b.proved_best, b.moves) << "%\n";
+    }
+
+    std::cout << "\nNull move pruning\n";
+    std::cout << "   R     attempts       cutoffs\n";
+    for (const auto& [r, b] : null_moves) {
+        std::cout << std::setw(4) << r
+                  << std::setw(13) << b.attempts
+                  << std::setw(13) << percent(b.cutoffs, b.attempts) << "%\n";
+    }
+
+    std::cout << "\nSEE-pruned captures: " << see_pruned << "\n";
+    return 0;
+}